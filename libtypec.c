@@ -43,12 +43,20 @@ SOFTWARE.
 #include <fcntl.h>
 
 static int ops_method = -1;
+static const char *ops_name;
 static char ver_buf[64];
 static struct utsname ker_uname;
 static const struct libtypec_os_backend *cur_libtypec_os_backend;
+static const struct libtypec_os_backend *native_libtypec_os_backend;
+static int native_ops_method = -1;
+static int native_refs;
 
 #define OPS_METHOD_DBGFS 0
 #define OPS_METHOD_SYSFS 1
+#define OPS_METHOD_SHM 2
+#define OPS_METHOD_TYPECD 3
+#define OPS_METHOD_FIXTURE 4
+#define OPS_METHOD_COMPOSITE 5
 
 
 /**
@@ -132,6 +140,85 @@ char *get_os_name(void)
     return p;
 }
 
+/**
+ * Selects and initializes the backend that talks to the kernel directly.
+ * The backend is shared by the session and by the shared memory publisher
+ * and is reference counted through libtypec_put_native_backend().
+ *
+ * \param ops_method Returns the OPS_METHOD_* of the selected backend
+ *
+ * \returns backend on success, NULL when no usable backend exists
+ */
+const struct libtypec_os_backend *libtypec_get_native_backend(int *ops_method)
+{
+    const struct libtypec_os_backend *backend = NULL;
+    struct statfs sb;
+    int ret, method = -1, has_sysfs;
+
+    if (native_libtypec_os_backend)
+    {
+        native_refs++;
+        *ops_method = native_ops_method;
+        return native_libtypec_os_backend;
+    }
+
+    /**
+        debugfs provides direct access to UCSI command and response.
+        Try opening debugfs before falling back to sysfs
+    */
+    has_sysfs = statfs(SYSFS_TYPEC_PATH, &sb) == 0 && sb.f_type == SYSFS_MAGIC;
+
+    ret = statfs(UCSI_DEBUGFS_PATH, &sb);
+
+    /* A recorded UCSI trace stands in for debugfs, see libtypec_ucsi_trace.c */
+    if (getenv("LIBTYPEC_UCSI_REPLAY"))
+    {
+        method = OPS_METHOD_DBGFS;
+        backend = &libtypec_lnx_dbgfs_backend;
+    }
+    else if (ret == 0 && sb.f_type == DEBUGFS_MAGIC)
+    {
+        /* sysfs answers what the debugfs backend does not implement */
+        method = has_sysfs ? OPS_METHOD_COMPOSITE : OPS_METHOD_DBGFS;
+        backend = has_sysfs ? &libtypec_composite_backend : &libtypec_lnx_dbgfs_backend;
+    }
+    else if (has_sysfs)
+    {
+        method = OPS_METHOD_SYSFS;
+        backend = &libtypec_lnx_sysfs_backend;
+    }
+
+    if (!backend)
+        return NULL;
+
+    if (backend->init && backend->init(NULL) < 0)
+        return NULL;
+
+    native_libtypec_os_backend = backend;
+    native_ops_method = method;
+    native_refs = 1;
+
+    *ops_method = method;
+    return backend;
+}
+
+const struct libtypec_os_backend *libtypec_get_backend(void)
+{
+    return cur_libtypec_os_backend;
+}
+
+void libtypec_put_native_backend(void)
+{
+    if (!native_libtypec_os_backend || --native_refs > 0)
+        return;
+
+    if (native_libtypec_os_backend->exit)
+        native_libtypec_os_backend->exit();
+
+    native_libtypec_os_backend = NULL;
+    native_ops_method = -1;
+}
+
 /**
  * This function initializes libtypec and must be called before
  * calling any other libtypec function.
@@ -139,15 +226,26 @@ char *get_os_name(void)
  * The function is responsible for setting up the backend interface and
  * also provides necessary platform session information
  *
+ * When a process on the host publishes port state through
+ * libtypec_shm_publish_init(), queries are served from the shared region
+ * instead of the kernel interfaces. Otherwise a running typecd daemon is
+ * preferred over direct kernel access. A topology loaded with
+ * libtypec_fixture_load(), or named by the LIBTYPEC_FIXTURE environment
+ * variable, takes precedence over all of them. The LIBTYPEC_BACKEND
+ * environment variable ("fixture", "shm", "typecd" or "native") restricts
+ * the selection to one kind of backend. A native session on a system with
+ * both UCSI debugfs and the typec class uses the composite backend, which
+ * routes each call to one of them; libtypec_get_routing() tells which.
+ *
  * \param Array of platform session strings
  *
  * \returns 0 on success
  */
 int libtypec_init(char **session_info)
 {
-    int ret;
-    struct statfs sb;
-    char *ops_str[] = {"debugfs","sysfs"};
+    int ret = -1;
+    char *ops_str[] = {"debugfs","sysfs","shm","typecd","fixture","composite"};
+    char *backend_env = getenv("LIBTYPEC_BACKEND");
 
     sprintf(ver_buf, "libtypec %d.%d.%d", LIBTYPEC_MAJOR_VERSION, LIBTYPEC_MINOR_VERSION,LIBTYPEC_PATCH_VERSION);
 
@@ -155,39 +253,53 @@ int libtypec_init(char **session_info)
     session_info[LIBTYPEC_KERNEL_INDEX] = get_kernel_verion();
     session_info[LIBTYPEC_OS_INDEX] = get_os_name();
 
-    /**
-        debugfs provides direct access to UCSI command and response.
-        Try opening debugfs before falling back to sysfs
-    */
-    ret = statfs(UCSI_DEBUGFS_PATH, &sb);
-
-    if (ret == 0 && sb.f_type == DEBUGFS_MAGIC)
+    if ((!backend_env || !strcmp(backend_env, "fixture")) && libtypec_fixture_attach() == 0)
     {
-            ops_method = OPS_METHOD_DBGFS;
-            cur_libtypec_os_backend = &libtypec_lnx_dbgfs_backend;
-	    if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->init );
-	    else
-                ret = cur_libtypec_os_backend->init(session_info);
+        ops_method = OPS_METHOD_FIXTURE;
+        cur_libtypec_os_backend = &libtypec_fixture_backend;
+        ret = cur_libtypec_os_backend->init(session_info);
     }
-    else
+    else if ((!backend_env || !strcmp(backend_env, "shm")) && libtypec_shm_attach() == 0)
     {
-        ret = statfs(SYSFS_TYPEC_PATH, &sb);
-
-        if (ret == 0 && sb.f_type == SYSFS_MAGIC)
-        {
-            ops_method = OPS_METHOD_SYSFS;
-            cur_libtypec_os_backend = &libtypec_lnx_sysfs_backend;
-            if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->init );
-            else
-            	ret = cur_libtypec_os_backend->init(session_info);
-        }    
+        ops_method = OPS_METHOD_SHM;
+        cur_libtypec_os_backend = &libtypec_shm_backend;
+        ret = cur_libtypec_os_backend->init(session_info);
+    }
+    else if ((!backend_env || !strcmp(backend_env, "typecd")) && libtypec_typecd_attach() == 0)
+    {
+        ops_method = OPS_METHOD_TYPECD;
+        cur_libtypec_os_backend = &libtypec_typecd_backend;
+        ret = cur_libtypec_os_backend->init(session_info);
+    }
+    else if (!backend_env || !strcmp(backend_env, "native"))
+    {
+        cur_libtypec_os_backend = libtypec_get_native_backend(&ops_method);
+        if (cur_libtypec_os_backend)
+            ret = 0;
     }
 
-    session_info[LIBTYPEC_OPS_INDEX] = ops_str[ops_method];
+    session_info[LIBTYPEC_OPS_INDEX] = (ops_method < 0) ? "none" : ops_str[ops_method];
+    ops_name = session_info[LIBTYPEC_OPS_INDEX];
 
     return ret;
 }
 
+/**
+ * This function reports which backend serves each call. session_info keeps
+ * its size for binaries built against earlier releases, so the routing is
+ * only available here.
+ *
+ * \returns Comma separated op=backend pairs for the composite backend,
+ * the backend name otherwise
+ */
+const char *libtypec_get_routing(void)
+{
+    if (ops_method == OPS_METHOD_COMPOSITE)
+        return libtypec_composite_routing();
+
+    return ops_name ? ops_name : "none";
+}
+
 /**
  * This function must be called before exiting libtypec session to perform
  * cleanup.
@@ -199,12 +311,23 @@ int libtypec_init(char **session_info)
 
 int libtypec_exit(void)
 {
-    if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->exit )
+    int ret = 0;
+
+    if (!cur_libtypec_os_backend)
         return -EIO;
 
     /* clear session info */
 
-    return cur_libtypec_os_backend->exit();
+    if (cur_libtypec_os_backend == native_libtypec_os_backend)
+        libtypec_put_native_backend();
+    else if (cur_libtypec_os_backend->exit)
+        ret = cur_libtypec_os_backend->exit();
+
+    cur_libtypec_os_backend = NULL;
+    ops_method = -1;
+    ops_name = NULL;
+
+    return ret;
 }
 
 /**
@@ -257,6 +380,40 @@ int libtypec_get_alternate_modes(int recipient, int conn_num, struct altmode_dat
 
     return cur_libtypec_os_backend->get_alternate_modes(recipient, conn_num, alt_mode_data);
 }
+
+/**
+ * This function shall be used to get the list of Alternate Modes supported
+ * on a connector that the OPM may enter
+ *
+ * \param  conn_num Indicates which connector's modes needs to be retrieved
+ *
+ * \param  cam_data Bitmap with one bit per alternate mode of the connector
+ *
+ * \returns number of bytes of cam_data on success
+ */
+int libtypec_get_cam_supported(int conn_num, char *cam_data)
+{
+    if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->get_cam_supported_ops )
+        return -EIO;
+
+    return cur_libtypec_os_backend->get_cam_supported_ops(conn_num, cam_data);
+}
+
+/**
+ * This function shall be used to get the Alternate Modes currently active
+ *
+ * \param  cur_cam_data Holds the current alternate mode data
+ *
+ * \returns number of bytes of cur_cam_data on success
+ */
+int libtypec_get_current_cam(char *cur_cam_data)
+{
+    if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->get_current_cam_ops )
+        return -EIO;
+
+    return cur_libtypec_os_backend->get_current_cam_ops(cur_cam_data);
+}
+
 /**
  * This function shall be used to get the Cable Property of a connector
  *
@@ -287,6 +444,24 @@ int libtypec_get_connector_status(int conn_num, struct libtypec_connector_status
     return cur_libtypec_os_backend->get_connector_status_ops(conn_num, conn_sts);
 }
 
+/**
+ * This function shall be used to get the status of a connector's power supply
+ *
+ * \param  conn_num Indicates which connector's power supply needs to be read
+ *
+ * \param  psy_sts Filled with the properties reported by the power supply
+ *
+ * \returns 0 on success, -ENODEV when the connector has no power supply,
+ * -EOPNOTSUPP when the backend cannot read power supplies
+ */
+int libtypec_get_power_supply_status(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+    if (!cur_libtypec_os_backend || !cur_libtypec_os_backend->get_power_supply_status_ops )
+        return -EIO;
+
+    return cur_libtypec_os_backend->get_power_supply_status_ops(conn_num, psy_sts);
+}
+
 /**
  * This function shall be used to get the USB PD response messages from
  *
@@ -371,6 +546,16 @@ int libtypec_get_bb_data(int bb_instance,char* bb_data)
     return cur_libtypec_os_backend->get_bb_data(bb_instance,bb_data);
 
 }
+/**
+ * This function registers a callback invoked from libtypec_monitor_events()
+ * whenever @event occurs.
+ *
+ * \param event Event of interest
+ * \param cb Callback to invoke
+ * \param data Passed back to the callback unchanged
+ *
+ * \returns 0 on success
+ */
 int libtypec_register_typec_notification_callback(enum usb_typec_event event, usb_typec_callback_t cb, void* data)
 {
     if (event >= USBC_EVENT_COUNT) {
@@ -384,14 +569,27 @@ int libtypec_register_typec_notification_callback(enum usb_typec_event event, us
     }
     node->cb_func = cb;
     node->data = data;
+
+    pthread_mutex_lock(&registered_callbacks_lock);
     node->next = registered_callbacks[event];
     registered_callbacks[event] = node;
+    pthread_mutex_unlock(&registered_callbacks_lock);
+
+    return 0;
 }
-int libtypec_unregister_callback(enum usb_typec_event event, usb_typec_callback_t cb) {
+
+/**
+ * This function removes every registration of @cb for @event.
+ *
+ * \returns 0 on success
+ */
+int libtypec_unregister_typec_notification_callback(enum usb_typec_event event, usb_typec_callback_t cb)
+{
     if (event >= USBC_EVENT_COUNT) {
         fprintf(stderr, "Invalid event\n");
         return -1;
     }
+    pthread_mutex_lock(&registered_callbacks_lock);
     libtypec_notification_list_t** node = &registered_callbacks[event];
     while (*node) {
         if ((*node)->cb_func == cb) {
@@ -402,6 +600,9 @@ int libtypec_unregister_callback(enum usb_typec_event event, usb_typec_callback_
             node = &(*node)->next;
         }
     }
+    pthread_mutex_unlock(&registered_callbacks_lock);
+
+    return 0;
 }
 
 void libtypec_monitor_events(void)
@@ -35,6 +35,7 @@ SOFTWARE.
 #define LIBTYPEC_H
 
 #include <stdint.h>
+#include <stddef.h>
 #include "libtypec_config.h"
 
 struct libtypec_capability_data
@@ -101,6 +102,72 @@ struct libtypec_connector_status
     unsigned reserved_2;
 };
 
+/* libtypec_power_supply_status.valid bits */
+#define LIBTYPEC_PSY_ONLINE (1 << 0)
+#define LIBTYPEC_PSY_PRESENT (1 << 1)
+#define LIBTYPEC_PSY_VOLTAGE_MIN (1 << 2)
+#define LIBTYPEC_PSY_VOLTAGE_MAX (1 << 3)
+#define LIBTYPEC_PSY_VOLTAGE_NOW (1 << 4)
+#define LIBTYPEC_PSY_CURRENT_MAX (1 << 5)
+#define LIBTYPEC_PSY_CURRENT_NOW (1 << 6)
+#define LIBTYPEC_PSY_INPUT_CURRENT_LIMIT (1 << 7)
+#define LIBTYPEC_PSY_POWER_NOW (1 << 8)
+
+/**
+ * @brief Numeric properties of a connector's power supply
+ *
+ * Units are those of the power_supply class: uV, uA and uW. Only
+ * properties flagged in valid were reported by the supply.
+ */
+struct libtypec_power_supply_status
+{
+    uint32_t valid;
+    uint32_t online;
+    uint32_t present;
+    uint32_t voltage_min;
+    uint32_t voltage_max;
+    uint32_t voltage_now;
+    uint32_t current_max;
+    int32_t current_now;
+    uint32_t input_current_limit;
+    uint32_t power_now;
+};
+
+/**
+ * @brief Time a thread spent waiting for the UCSI debugfs channel
+ *
+ * queue_wait_ns is spent behind other threads of the process,
+ * lock_wait_ns behind other processes. max_wait_ns is the longest total
+ * wait of a single transaction.
+ */
+struct libtypec_ucsi_wait_stats
+{
+    uint64_t transactions;
+    uint64_t queue_wait_ns;
+    uint64_t lock_wait_ns;
+    uint64_t max_wait_ns;
+};
+
+/**
+ * @brief Health of a backend serving the composite backend
+ *
+ * Rates and latency are moving averages over the recent calls, counters
+ * cover the whole session. failed_over is set while the backend's calls
+ * are served by another backend.
+ */
+struct libtypec_backend_health
+{
+    const char *name;
+    uint64_t calls;
+    uint64_t errors;
+    uint64_t timeouts;
+    uint64_t failovers;
+    unsigned int error_rate_pct;
+    unsigned int timeout_rate_pct;
+    uint64_t latency_ns;
+    int failed_over;
+};
+
 struct libtypec_cable_property
 {
     unsigned short speed_supported;
@@ -286,9 +353,315 @@ union libtypec_pps_sink
 enum usb_typec_event {
     USBC_DEVICE_CONNECTED,
     USBC_DEVICE_DISCONNECTED,
+    USBC_DEVICE_CHANGED,
+    USBC_BACKEND_FAILOVER,
+    USBC_BACKEND_FAILBACK,
     USBC_EVENT_COUNT
 };
 
+/**
+ * @brief Binary topology snapshot
+ *
+ * A snapshot is a versioned, fixed layout image of the topology meant to
+ * be memory mapped and read in place. All fields are little-endian and all
+ * offsets are in bytes from the start of the snapshot. The image is the
+ * header followed by the port table, the PDO array, the VDO array and the
+ * alternate mode array. Each port owns a contiguous run of PDOs ordered
+ * local sink, local source, partner sink, partner source, a run of twelve
+ * VDOs holding the SOP and SOP' Discover Identity (in the member order of
+ * union libtypec_discovered_identity) and a run of alternate modes ordered
+ * connector, SOP, SOP'. The inline accessors below convert the offsets
+ * and indices they follow, values they point to stay little-endian.
+ */
+#define LIBTYPEC_SNAPSHOT_MAGIC "TYPECSNP"
+#define LIBTYPEC_SNAPSHOT_VERSION 1
+#define LIBTYPEC_SNAPSHOT_ID_VDOS 6
+
+/* libtypec_snapshot_port.valid bits */
+#define LIBTYPEC_SNAPSHOT_CONN_CAP (1 << 0)
+#define LIBTYPEC_SNAPSHOT_CONN_STS (1 << 1)
+#define LIBTYPEC_SNAPSHOT_CABLE (1 << 2)
+#define LIBTYPEC_SNAPSHOT_ID_SOP (1 << 3)
+#define LIBTYPEC_SNAPSHOT_ID_SOP_PR (1 << 4)
+
+struct libtypec_snapshot_header
+{
+    char magic[8];
+    uint16_t version;
+    uint16_t header_size;
+    uint32_t total_size;
+    uint64_t timestamp;
+    uint32_t bmAttributes;
+    uint32_t bmOptionalFeatures;
+    uint16_t bcdBCVersion;
+    uint16_t bcdPDVersion;
+    uint16_t bcdTypeCVersion;
+    uint8_t num_alt_modes;
+    uint8_t num_ports;
+    uint32_t port_offset;
+    uint16_t port_size;
+    uint16_t reserved;
+    uint32_t pdo_offset;
+    uint32_t num_pdos;
+    uint32_t vdo_offset;
+    uint32_t num_vdos;
+    uint32_t altmode_offset;
+    uint32_t num_altmodes;
+};
+
+struct libtypec_snapshot_port
+{
+    uint32_t valid;
+    uint8_t opr_mode;
+    uint8_t cap_flags;          /* provider, consumer, swap2dfp, swap2ufp, swap2src, swap2snk */
+    uint16_t partner_rev;
+    uint16_t cable_rev;
+    uint16_t sts_change;
+    uint32_t rdo;
+    uint8_t pwr_op_mode;
+    uint8_t sts_flags;          /* connect_sts, pwr_dir */
+    uint8_t ptnr_flags;
+    uint8_t ptnr_type;
+    uint16_t bcdPDVer_op_mode;
+    uint8_t bat_chrg_cap_sts;
+    uint8_t cap_ltd_reason;
+    uint16_t cable_speed;
+    uint8_t cable_current;
+    uint8_t cable_type;
+    uint8_t plug_end_type;
+    uint8_t cable_flags;        /* vbus_support, directionality, mode_support */
+    uint8_t cable_latency;
+    uint8_t reserved1;
+    uint8_t num_pdos[4];
+    uint8_t num_altmodes[3];
+    uint8_t reserved2;
+    uint32_t pdo_index;
+    uint32_t altmode_index;
+    uint32_t vdo_index;
+    uint32_t reserved3[3];
+};
+
+struct libtypec_snapshot_altmode
+{
+    uint32_t svid;
+    uint32_t vdo;
+};
+
+/* Snapshot fields to host order, without <endian.h> which strict feature test macros hide */
+static inline uint32_t libtypec_le32(uint32_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap32(v);
+#else
+    return v;
+#endif
+}
+
+static inline uint16_t libtypec_le16(uint16_t v)
+{
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return __builtin_bswap16(v);
+#else
+    return v;
+#endif
+}
+
+static inline const struct libtypec_snapshot_port *libtypec_snapshot_port(const struct libtypec_snapshot_header *snap, int port)
+{
+    return (const struct libtypec_snapshot_port *)((const char *)snap + libtypec_le32(snap->port_offset) + port * libtypec_le16(snap->port_size));
+}
+
+static inline const uint32_t *libtypec_snapshot_pdos(const struct libtypec_snapshot_header *snap, const struct libtypec_snapshot_port *port, int partner, int src_snk, int *num_pdo)
+{
+    int group = (partner << 1) | src_snk;
+    uint32_t index = libtypec_le32(port->pdo_index);
+
+    for (int i = 0; i < group; i++)
+        index += port->num_pdos[i];
+
+    *num_pdo = port->num_pdos[group];
+    return (const uint32_t *)((const char *)snap + libtypec_le32(snap->pdo_offset)) + index;
+}
+
+static inline const uint32_t *libtypec_snapshot_identity(const struct libtypec_snapshot_header *snap, const struct libtypec_snapshot_port *port, int recipient)
+{
+    return (const uint32_t *)((const char *)snap + libtypec_le32(snap->vdo_offset)) + libtypec_le32(port->vdo_index) + (recipient - AM_SOP) * LIBTYPEC_SNAPSHOT_ID_VDOS;
+}
+
+static inline const struct libtypec_snapshot_altmode *libtypec_snapshot_altmodes(const struct libtypec_snapshot_header *snap, const struct libtypec_snapshot_port *port, int recipient, int *num_am)
+{
+    uint32_t index = libtypec_le32(port->altmode_index);
+
+    for (int i = 0; i < recipient; i++)
+        index += port->num_altmodes[i];
+
+    *num_am = port->num_altmodes[recipient];
+    return (const struct libtypec_snapshot_altmode *)((const char *)snap + libtypec_le32(snap->altmode_offset)) + index;
+}
+
+/**
+ * @brief Comparable topology records
+ *
+ * A capture flattens the decoded state into records sorted by
+ * (port, object, field). Ports are numbered from 0, the PPM capability
+ * uses port LIBTYPEC_STATE_PORT_PPM and sorts last. Alternate mode and
+ * PDO objects report their count as field 0 followed by one field per
+ * value (PDO n is field n + 1, alternate mode n has its SVID in field
+ * 2n + 1 and its VDO in field 2n + 2).
+ */
+#define LIBTYPEC_STATE_PORT_PPM 0xff
+#define LIBTYPEC_STATE_RECORDS_PER_PORT 256
+
+enum libtypec_state_object {
+    LIBTYPEC_OBJ_CONN_CAP,          /* valid, opr_mode, provider, consumer, swap2dfp, swap2ufp, swap2src, swap2snk, partner_rev, cable_rev */
+    LIBTYPEC_OBJ_CONN_STATUS,       /* valid, sts_change, pwr_op_mode, connect_sts, pwr_dir, ptnr_flags, ptnr_type, rdo, bat_chrg_cap_sts, cap_ltd_reason, bcdPDVer_op_mode */
+    LIBTYPEC_OBJ_CABLE,             /* valid, speed_supported, current_capability, vbus_support, cable_type, directionality, plug_end_type, mode_support, latency */
+    LIBTYPEC_OBJ_IDENTITY_SOP,      /* valid, cert_stat, id_header, product, product_type_vdo1, product_type_vdo2, product_type_vdo3 */
+    LIBTYPEC_OBJ_IDENTITY_SOP_PR,
+    LIBTYPEC_OBJ_ALTMODE_CONNECTOR,
+    LIBTYPEC_OBJ_ALTMODE_SOP,
+    LIBTYPEC_OBJ_ALTMODE_SOP_PR,
+    LIBTYPEC_OBJ_PDO_SINK,
+    LIBTYPEC_OBJ_PDO_SOURCE,
+    LIBTYPEC_OBJ_PARTNER_PDO_SINK,
+    LIBTYPEC_OBJ_PARTNER_PDO_SOURCE,
+    LIBTYPEC_OBJ_CAPABILITY,        /* bmAttributes, bNumConnectors, bmOptionalFeatures, bNumAltModes, bcdBCVersion, bcdPDVersion, bcdTypeCVersion */
+    LIBTYPEC_OBJ_COUNT
+};
+
+struct libtypec_state_record
+{
+    uint8_t port;
+    uint8_t object;
+    uint16_t field;
+    uint32_t value;
+};
+
+/* libtypec_state_change.flags */
+#define LIBTYPEC_STATE_ADDED (1 << 0)
+#define LIBTYPEC_STATE_REMOVED (1 << 1)
+
+struct libtypec_state_change
+{
+    uint8_t port;
+    uint8_t object;
+    uint16_t field;
+    uint32_t flags;
+    uint32_t old_value;
+    uint32_t new_value;
+};
+
+/**
+ * @brief Decoded VDO and PDO fields
+ *
+ * libtypec_decode_vdo() and libtypec_decode_pdo() split a raw object into
+ * its fields using the tables for the USB PD revision it was sent with.
+ * desc names the value of enumerated fields and is NULL otherwise,
+ * name_len is strlen(name).
+ */
+#define LIBTYPEC_VDO_MAX_FIELDS 16
+
+enum libtypec_vdo_type {
+    LIBTYPEC_VDO_ID_HEADER_PARTNER,
+    LIBTYPEC_VDO_ID_HEADER_CABLE,
+    LIBTYPEC_VDO_CERT_STAT,
+    LIBTYPEC_VDO_PRODUCT,
+    LIBTYPEC_VDO_PASSIVE_CABLE,
+    LIBTYPEC_VDO_ACTIVE_CABLE1,
+    LIBTYPEC_VDO_ACTIVE_CABLE2,
+    LIBTYPEC_VDO_AMA,
+    LIBTYPEC_VDO_VPD,
+    LIBTYPEC_VDO_UFP1,
+    LIBTYPEC_VDO_UFP2,
+    LIBTYPEC_VDO_DFP,
+    LIBTYPEC_VDO_DP_PARTNER,        /* DisplayPort alternate mode VDOs */
+    LIBTYPEC_VDO_DP_CABLE,
+    LIBTYPEC_VDO_TBT3_SOP,          /* Thunderbolt 3 alternate mode VDOs */
+    LIBTYPEC_VDO_TBT3_SOP_PR,
+    LIBTYPEC_VDO_TYPE_COUNT
+};
+
+struct libtypec_vdo_field
+{
+    const char *name;
+    const char *desc;
+    uint32_t value;
+    uint8_t shift;
+    uint8_t name_len;
+    uint32_t mask;
+};
+
+/**
+ * @brief PDOs decoded in bulk by libtypec_decode_pdo_batch()
+ *
+ * Each member points to an array with one entry per PDO and may be NULL.
+ * Voltages are in mV, currents in mA and power in mW. Fixed supplies
+ * report their voltage as both minimum and maximum, battery supplies
+ * report a current of 0. flags holds the PDO bits outside the value
+ * fields, unshifted.
+ */
+struct libtypec_pdo_batch
+{
+    uint32_t *max_voltage;
+    uint32_t *min_voltage;
+    uint32_t *current;
+    uint32_t *power;
+    uint32_t *flags;
+};
+
+/**
+ * @brief One reading of a port's power supply taken by the power sampler
+ *
+ * time_ns is CLOCK_MONOTONIC. Voltage and current are as reported by the
+ * power_supply class, in uV and uA.
+ */
+struct libtypec_power_sample
+{
+    uint64_t time_ns;
+    uint32_t voltage_uv;
+    int32_t current_ua;
+};
+
+/**
+ * @brief Power sampler statistics over a window, see libtypec_power_sampler_stats()
+ *
+ * overruns counts sampling periods missed by the sampler thread across
+ * all ports since it was started.
+ */
+struct libtypec_power_stats
+{
+    uint32_t num_samples;
+    uint64_t duration_ns;
+    uint32_t min_mv;
+    uint32_t max_mv;
+    uint32_t min_mw;
+    uint32_t max_mw;
+    uint32_t mean_mw;
+    uint32_t percentile_mw;
+    uint64_t energy_uj;
+    uint64_t overruns;
+};
+
+enum libtypec_product_type {
+    LIBTYPEC_PRODUCT_TYPE_OTHER = 0,
+    LIBTYPEC_PRODUCT_TYPE_PD2P0_PASSIVE_CABLE = 1,
+    LIBTYPEC_PRODUCT_TYPE_PD2P0_ACTIVE_CABLE = 2,
+    LIBTYPEC_PRODUCT_TYPE_PD2P0_AMA = 3,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_PASSIVE_CABLE = 4,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_ACTIVE_CABLE = 5,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_AMA = 6,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_VPD = 7,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_UFP = 8,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_DFP = 9,
+    LIBTYPEC_PRODUCT_TYPE_PD3P0_DRD = 10,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_PASSIVE_CABLE = 11,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_ACTIVE_CABLE = 12,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_VPD = 13,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_UFP = 14,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_DFP = 15,
+    LIBTYPEC_PRODUCT_TYPE_PD3P1_DRD = 16,
+};
+
 typedef void (*usb_typec_callback_t)(enum usb_typec_event event, void* data);
 
 typedef struct libtypec_notification_list{
@@ -300,6 +673,7 @@ typedef struct libtypec_notification_list{
 
 int libtypec_init(char **session_info);
 int libtypec_exit(void);
+const char *libtypec_get_routing(void);
 
 /**
  * @brief
@@ -314,12 +688,48 @@ int libtypec_get_pdos(int conn_num, int partner, int offset, int *num_pdo, int s
 int libtypec_get_cable_properties(int conn_num, struct libtypec_cable_property *cbl_prop_data);
 int libtypec_get_connector_status(int conn_num, struct libtypec_connector_status *conn_sts);
 int libtypec_get_pd_message(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp);
+int libtypec_get_power_supply_status(int conn_num, struct libtypec_power_supply_status *psy_sts);
+int libtypec_get_power_supply_port(const char *psy_name);
+int libtypec_get_ucsi_wait_stats(struct libtypec_ucsi_wait_stats *stats, int reset);
+int libtypec_get_backend_health(int index, struct libtypec_backend_health *health);
 
 int libtypec_get_bb_status(unsigned int *num_bb_instance);
 int libtypec_get_bb_data(int num_billboards,char* bb_data);
 
 int libtypec_register_typec_notification_callback(enum usb_typec_event event, usb_typec_callback_t cb, void* data);
 int libtypec_unregister_typec_notification_callback(enum usb_typec_event event, usb_typec_callback_t cb);
+int libtypec_get_event_port(void);
 void libtypec_monitor_events(void);
 
+int libtypec_shm_publish_init(void);
+int libtypec_shm_publish_update(int conn_num);
+int libtypec_shm_publish_exit(void);
+
+int libtypec_snapshot_write(int fd);
+const struct libtypec_snapshot_header *libtypec_snapshot_map(const char *path, size_t *size);
+void libtypec_snapshot_unmap(const struct libtypec_snapshot_header *snap, size_t size);
+
+int libtypec_fixture_load(const char *path);
+void libtypec_fixture_unload(void);
+
+int libtypec_state_capture(struct libtypec_state_record *records, int max_records);
+int libtypec_state_capture_snapshot(const struct libtypec_snapshot_header *snap, struct libtypec_state_record *records, int max_records);
+int libtypec_state_diff(const struct libtypec_state_record *old_records, int num_old,
+                        const struct libtypec_state_record *new_records, int num_new,
+                        struct libtypec_state_change *changes, int max_changes);
+
+int libtypec_decode_vdo(unsigned short revision, enum libtypec_vdo_type type, uint32_t vdo, struct libtypec_vdo_field *fields, int max_fields);
+int libtypec_decode_pdo(unsigned short revision, int src_snk, uint32_t pdo, struct libtypec_vdo_field *fields, int max_fields);
+int libtypec_decode_vdo_batch(unsigned short revision, enum libtypec_vdo_type type, const uint32_t *vdos, size_t count,
+                              uint32_t *const *values, int max_fields);
+int libtypec_decode_pdo_batch(unsigned short revision, int type, const uint32_t *pdos, size_t count, struct libtypec_pdo_batch *out);
+int libtypec_power_sampler_start(unsigned int period_us, unsigned int capacity);
+int libtypec_power_sampler_stop(void);
+int libtypec_power_sampler_read(int conn_num, uint64_t since_ns, struct libtypec_power_sample *samples, int max_samples);
+int libtypec_power_sampler_stats(int conn_num, uint64_t window_ns, unsigned int percentile, struct libtypec_power_stats *stats);
+int libtypec_status_poller_start(unsigned int min_interval_ms, unsigned int max_interval_ms);
+int libtypec_status_poller_stop(void);
+enum libtypec_product_type libtypec_get_cable_product_type(unsigned short revision, uint32_t id_header);
+enum libtypec_product_type libtypec_get_partner_product_type(unsigned short revision, uint32_t id_header);
+
 #endif /*LIBTYPEC_H*/
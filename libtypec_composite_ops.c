@@ -0,0 +1,690 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_composite_ops.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Backend routing each operation to the debugfs or sysfs backend
+ *
+ * Every op is served by the first member backend implementing it, so a
+ * call missing from the debugfs vtable falls through to sysfs. Setting
+ * LIBTYPEC_CALIBRATE=1 times every candidate of an op on connector 0 at
+ * init and routes the op to the fastest candidate that succeeded. The
+ * resulting routing is reported through libtypec_composite_routing().
+ *
+ * Every call is accounted to the member serving it. A member whose recent
+ * calls mostly fail, time out or run slow is confirmed with a
+ * GET_CAPABILITY probe from the health thread; when the probe fails too,
+ * its ops fail over to the next member implementing them. Failed members
+ * are probed periodically and take their ops back after consecutive
+ * healthy probes. Both transitions are reported as USBC_BACKEND_FAILOVER
+ * and USBC_BACKEND_FAILBACK notifications.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <stddef.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/eventfd.h>
+
+#define COMPOSITE_CALIBRATE_RUNS 5
+
+/* Health averages weigh the last call 1/8, rates are in 1/65536 units */
+#define COMPOSITE_EWMA_SHIFT 3
+#define COMPOSITE_RATE_ONE 65536
+#define COMPOSITE_MIN_CALLS 8
+#define COMPOSITE_MAX_ERROR_RATE (COMPOSITE_RATE_ONE / 2)
+#define COMPOSITE_MAX_TIMEOUT_RATE (COMPOSITE_RATE_ONE / 5)
+#define COMPOSITE_MAX_LATENCY_NS 250000000ull
+#define COMPOSITE_PROBE_INTERVAL_MS 2000
+#define COMPOSITE_FAILBACK_PROBES 3
+
+enum composite_op {
+	COMPOSITE_OP_CAPABILITY,
+	COMPOSITE_OP_CONN_CAPABILITY,
+	COMPOSITE_OP_ALTERNATE_MODES,
+	COMPOSITE_OP_CAM_SUPPORTED,
+	COMPOSITE_OP_CURRENT_CAM,
+	COMPOSITE_OP_PDOS,
+	COMPOSITE_OP_CABLE_PROPERTIES,
+	COMPOSITE_OP_CONNECTOR_STATUS,
+	COMPOSITE_OP_PD_MESSAGE,
+	COMPOSITE_OP_BB_STATUS,
+	COMPOSITE_OP_BB_DATA,
+	COMPOSITE_OP_MONITOR_EVENTS,
+	COMPOSITE_OP_POWER_SUPPLY_STATUS,
+	COMPOSITE_OP_COUNT
+};
+
+typedef void (*composite_fn)(void);
+
+static const struct
+{
+	const char *name;
+	size_t offset;
+} composite_ops[COMPOSITE_OP_COUNT] = {
+	[COMPOSITE_OP_CAPABILITY] = {"capability", offsetof(struct libtypec_os_backend, get_capability_ops)},
+	[COMPOSITE_OP_CONN_CAPABILITY] = {"conn_capability", offsetof(struct libtypec_os_backend, get_conn_capability_ops)},
+	[COMPOSITE_OP_ALTERNATE_MODES] = {"alternate_modes", offsetof(struct libtypec_os_backend, get_alternate_modes)},
+	[COMPOSITE_OP_CAM_SUPPORTED] = {"cam_supported", offsetof(struct libtypec_os_backend, get_cam_supported_ops)},
+	[COMPOSITE_OP_CURRENT_CAM] = {"current_cam", offsetof(struct libtypec_os_backend, get_current_cam_ops)},
+	[COMPOSITE_OP_PDOS] = {"pdos", offsetof(struct libtypec_os_backend, get_pdos_ops)},
+	[COMPOSITE_OP_CABLE_PROPERTIES] = {"cable_properties", offsetof(struct libtypec_os_backend, get_cable_properties_ops)},
+	[COMPOSITE_OP_CONNECTOR_STATUS] = {"connector_status", offsetof(struct libtypec_os_backend, get_connector_status_ops)},
+	[COMPOSITE_OP_PD_MESSAGE] = {"pd_message", offsetof(struct libtypec_os_backend, get_pd_message_ops)},
+	[COMPOSITE_OP_BB_STATUS] = {"bb_status", offsetof(struct libtypec_os_backend, get_bb_status)},
+	[COMPOSITE_OP_BB_DATA] = {"bb_data", offsetof(struct libtypec_os_backend, get_bb_data)},
+	[COMPOSITE_OP_MONITOR_EVENTS] = {"monitor_events", offsetof(struct libtypec_os_backend, monitor_events)},
+	[COMPOSITE_OP_POWER_SUPPLY_STATUS] = {"power_supply_status", offsetof(struct libtypec_os_backend, get_power_supply_status_ops)},
+};
+
+/* In order of preference */
+static struct
+{
+	const char *name;
+	const struct libtypec_os_backend *backend;
+	int ready;
+} composite_members[] = {
+	{"debugfs", &libtypec_lnx_dbgfs_backend, 0},
+	{"sysfs", &libtypec_lnx_sysfs_backend, 0},
+};
+
+#define COMPOSITE_NUM_MEMBERS (int)(sizeof(composite_members) / sizeof(composite_members[0]))
+
+enum composite_state {
+	COMPOSITE_HEALTHY,
+	COMPOSITE_SUSPECT,	/* degraded, waiting for the confirming probe */
+	COMPOSITE_FAILED,
+};
+
+/*
+ * Averages are updated without locking, concurrent callers may lose an
+ * update which only delays detection by a call.
+ */
+static struct
+{
+	int state;
+	int probes_passed;
+	uint64_t window_calls;
+	uint64_t calls;
+	uint64_t errors;
+	uint64_t timeouts;
+	uint64_t failovers;
+	uint64_t error_rate;
+	uint64_t timeout_rate;
+	uint64_t latency_ns;
+} composite_health[sizeof(composite_members) / sizeof(composite_members[0])];
+
+static int composite_route[COMPOSITE_OP_COUNT];
+static char composite_routing[512];
+static int composite_wake_fd = -1;
+static int composite_stopping;
+static pthread_t composite_health_thread;
+
+static composite_fn composite_op_fn(const struct libtypec_os_backend *backend, int op)
+{
+	return *(const composite_fn *)((const char *)backend + composite_ops[op].offset);
+}
+
+static int composite_state(int m)
+{
+	return __atomic_load_n(&composite_health[m].state, __ATOMIC_ACQUIRE);
+}
+
+/* Routed member of an op, or the first healthy one implementing it once the routed member failed */
+static int composite_member(int op)
+{
+	int m = composite_route[op];
+
+	if (m < 0 || composite_state(m) != COMPOSITE_FAILED)
+		return m;
+
+	for (int alt = 0; alt < COMPOSITE_NUM_MEMBERS; alt++)
+	{
+		if (alt != m && composite_members[alt].ready && composite_state(alt) != COMPOSITE_FAILED &&
+		    composite_op_fn(composite_members[alt].backend, op))
+			return alt;
+	}
+
+	return m;
+}
+
+static const struct libtypec_os_backend *composite_backend(int op)
+{
+	int m = composite_member(op);
+
+	return m < 0 ? NULL : composite_members[m].backend;
+}
+
+static unsigned long long composite_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void composite_ewma(uint64_t *avg, uint64_t sample)
+{
+	int64_t old = __atomic_load_n(avg, __ATOMIC_RELAXED);
+
+	__atomic_store_n(avg, old + (((int64_t)sample - old) >> COMPOSITE_EWMA_SHIFT), __ATOMIC_RELAXED);
+}
+
+static void composite_reset_health(int m)
+{
+	__atomic_store_n(&composite_health[m].window_calls, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&composite_health[m].error_rate, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&composite_health[m].timeout_rate, 0, __ATOMIC_RELAXED);
+	__atomic_store_n(&composite_health[m].latency_ns, 0, __ATOMIC_RELAXED);
+}
+
+/* Picks the member serving an op and starts timing the call */
+static int composite_enter(int op, unsigned long long *t0)
+{
+	*t0 = composite_now_ns();
+	return composite_member(op);
+}
+
+/* Accounts a finished call to its member and hands degraded members to the health thread */
+static int composite_leave(int m, int ret, unsigned long long t0)
+{
+	uint64_t one = 1, latency = composite_now_ns() - t0, window;
+	int expected = COMPOSITE_HEALTHY;
+
+	window = __atomic_add_fetch(&composite_health[m].window_calls, 1, __ATOMIC_RELAXED);
+	__atomic_add_fetch(&composite_health[m].calls, 1, __ATOMIC_RELAXED);
+	if (ret < 0)
+		__atomic_add_fetch(&composite_health[m].errors, 1, __ATOMIC_RELAXED);
+	if (ret == -ETIMEDOUT)
+		__atomic_add_fetch(&composite_health[m].timeouts, 1, __ATOMIC_RELAXED);
+
+	composite_ewma(&composite_health[m].error_rate, ret < 0 ? COMPOSITE_RATE_ONE : 0);
+	composite_ewma(&composite_health[m].timeout_rate, ret == -ETIMEDOUT ? COMPOSITE_RATE_ONE : 0);
+	composite_ewma(&composite_health[m].latency_ns, latency);
+
+	if (window < COMPOSITE_MIN_CALLS || composite_wake_fd < 0)
+		return ret;
+
+	if (__atomic_load_n(&composite_health[m].error_rate, __ATOMIC_RELAXED) > COMPOSITE_MAX_ERROR_RATE ||
+	    __atomic_load_n(&composite_health[m].timeout_rate, __ATOMIC_RELAXED) > COMPOSITE_MAX_TIMEOUT_RATE ||
+	    __atomic_load_n(&composite_health[m].latency_ns, __ATOMIC_RELAXED) > COMPOSITE_MAX_LATENCY_NS)
+	{
+		if (__atomic_compare_exchange_n(&composite_health[m].state, &expected, COMPOSITE_SUSPECT, 0,
+						__ATOMIC_ACQ_REL, __ATOMIC_RELAXED) &&
+		    write(composite_wake_fd, &one, sizeof(one)) != sizeof(one))
+			__atomic_store_n(&composite_health[m].state, COMPOSITE_HEALTHY, __ATOMIC_RELEASE);
+	}
+
+	return ret;
+}
+
+/* Issues one call of a side effect free op against connector 0 */
+static int composite_probe(const struct libtypec_os_backend *backend, int op)
+{
+	static union
+	{
+		struct libtypec_capability_data cap;
+		struct libtypec_connector_cap_data conn_cap;
+		struct altmode_data am[LIBTYPEC_AM_SCRATCH];
+		unsigned int pdos[LIBTYPEC_AM_SCRATCH];
+		struct libtypec_cable_property cable;
+		struct libtypec_connector_status sts;
+		struct libtypec_power_supply_status psy;
+		char buf[256];
+	} scratch;
+	int num;
+
+	switch (op)
+	{
+	case COMPOSITE_OP_CAPABILITY:
+		return backend->get_capability_ops(&scratch.cap);
+	case COMPOSITE_OP_CONN_CAPABILITY:
+		return backend->get_conn_capability_ops(0, &scratch.conn_cap);
+	case COMPOSITE_OP_ALTERNATE_MODES:
+		return backend->get_alternate_modes(AM_CONNECTOR, 0, scratch.am);
+	case COMPOSITE_OP_CAM_SUPPORTED:
+		return backend->get_cam_supported_ops(0, scratch.buf);
+	case COMPOSITE_OP_CURRENT_CAM:
+		return backend->get_current_cam_ops(scratch.buf);
+	case COMPOSITE_OP_PDOS:
+		return backend->get_pdos_ops(0, 0, 0, &num, 1, 0, scratch.pdos);
+	case COMPOSITE_OP_CABLE_PROPERTIES:
+		return backend->get_cable_properties_ops(0, &scratch.cable);
+	case COMPOSITE_OP_CONNECTOR_STATUS:
+		return backend->get_connector_status_ops(0, &scratch.sts);
+	case COMPOSITE_OP_PD_MESSAGE:
+		return backend->get_pd_message_ops(AM_SOP, 0, sizeof(union libtypec_discovered_identity), DISCOVER_ID_REQ, scratch.buf);
+	case COMPOSITE_OP_POWER_SUPPLY_STATUS:
+		return backend->get_power_supply_status_ops(0, &scratch.psy);
+	default:
+		/* Billboard and event ops are not timed */
+		return -EINVAL;
+	}
+}
+
+/**
+ * Times every ready candidate of an op and routes the op to the one with
+ * the lowest best-of-N latency. Candidates failing the probe are skipped,
+ * the default route stays when none succeeds.
+ */
+static void composite_calibrate(int op)
+{
+	unsigned long long best_ns = ~0ull;
+	int best = -1, candidates = 0;
+
+	for (int m = 0; m < COMPOSITE_NUM_MEMBERS; m++)
+	{
+		if (composite_members[m].ready && composite_op_fn(composite_members[m].backend, op))
+			candidates++;
+	}
+
+	if (candidates < 2)
+		return;
+
+	for (int m = 0; m < COMPOSITE_NUM_MEMBERS; m++)
+	{
+		const struct libtypec_os_backend *backend = composite_members[m].backend;
+		unsigned long long min_ns = ~0ull;
+		int run;
+
+		if (!composite_members[m].ready || !composite_op_fn(backend, op))
+			continue;
+
+		for (run = 0; run < COMPOSITE_CALIBRATE_RUNS; run++)
+		{
+			unsigned long long t0 = composite_now_ns(), t;
+
+			if (composite_probe(backend, op) < 0)
+				break;
+
+			t = composite_now_ns() - t0;
+			if (t < min_ns)
+				min_ns = t;
+		}
+
+		if (run == COMPOSITE_CALIBRATE_RUNS && min_ns < best_ns)
+		{
+			best_ns = min_ns;
+			best = m;
+		}
+	}
+
+	if (best >= 0)
+		composite_route[op] = best;
+}
+
+/*
+ * Confirms a suspect member or probes a failed one. Errors on a single op
+ * may well be legitimate, such as PD messages of an absent partner, so
+ * only a failing GET_CAPABILITY takes a member out of service.
+ */
+static void composite_check(int m)
+{
+	unsigned long long t0 = composite_now_ns();
+	int ok, state = composite_state(m);
+
+	ok = composite_probe(composite_members[m].backend, COMPOSITE_OP_CAPABILITY) >= 0 &&
+	     composite_now_ns() - t0 < COMPOSITE_MAX_LATENCY_NS;
+
+	if (state == COMPOSITE_SUSPECT)
+	{
+		if (ok)
+		{
+			composite_reset_health(m);
+			__atomic_store_n(&composite_health[m].state, COMPOSITE_HEALTHY, __ATOMIC_RELEASE);
+			return;
+		}
+
+		composite_health[m].probes_passed = 0;
+		__atomic_add_fetch(&composite_health[m].failovers, 1, __ATOMIC_RELAXED);
+		__atomic_store_n(&composite_health[m].state, COMPOSITE_FAILED, __ATOMIC_RELEASE);
+		libtypec_notify_event(USBC_BACKEND_FAILOVER, -1);
+	}
+	else if (state == COMPOSITE_FAILED)
+	{
+		composite_health[m].probes_passed = ok ? composite_health[m].probes_passed + 1 : 0;
+		if (composite_health[m].probes_passed < COMPOSITE_FAILBACK_PROBES)
+			return;
+
+		composite_reset_health(m);
+		__atomic_store_n(&composite_health[m].state, COMPOSITE_HEALTHY, __ATOMIC_RELEASE);
+		libtypec_notify_event(USBC_BACKEND_FAILBACK, -1);
+	}
+}
+
+static void *composite_health_worker(void *arg)
+{
+	struct pollfd pfd = { .fd = composite_wake_fd, .events = POLLIN };
+	uint64_t val;
+	int ret, timeout;
+
+	while (!__atomic_load_n(&composite_stopping, __ATOMIC_ACQUIRE))
+	{
+		/* Sleep until a member turns suspect, or the next probe of a failed one */
+		timeout = -1;
+		for (int m = 0; m < COMPOSITE_NUM_MEMBERS; m++)
+		{
+			if (composite_state(m) == COMPOSITE_FAILED)
+				timeout = COMPOSITE_PROBE_INTERVAL_MS;
+		}
+
+		ret = poll(&pfd, 1, timeout);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret < 0)
+			break;
+		if (ret > 0 && read(composite_wake_fd, &val, sizeof(val)) < 0)
+			continue;
+
+		for (int m = 0; m < COMPOSITE_NUM_MEMBERS && !__atomic_load_n(&composite_stopping, __ATOMIC_ACQUIRE); m++)
+		{
+			if (composite_members[m].ready && composite_state(m) != COMPOSITE_HEALTHY)
+				composite_check(m);
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * This function reports the health of a composite member backend.
+ *
+ * \param index Member, 0 for debugfs and 1 for sysfs
+ * \param health Filled with the member's counters and recent averages
+ *
+ * \returns 0 on success, -EINVAL past the last member
+ */
+int libtypec_get_backend_health(int index, struct libtypec_backend_health *health)
+{
+	if (index < 0 || index >= COMPOSITE_NUM_MEMBERS || !health)
+		return -EINVAL;
+
+	health->name = composite_members[index].name;
+	health->calls = __atomic_load_n(&composite_health[index].calls, __ATOMIC_RELAXED);
+	health->errors = __atomic_load_n(&composite_health[index].errors, __ATOMIC_RELAXED);
+	health->timeouts = __atomic_load_n(&composite_health[index].timeouts, __ATOMIC_RELAXED);
+	health->failovers = __atomic_load_n(&composite_health[index].failovers, __ATOMIC_RELAXED);
+	health->error_rate_pct = __atomic_load_n(&composite_health[index].error_rate, __ATOMIC_RELAXED) * 100 / COMPOSITE_RATE_ONE;
+	health->timeout_rate_pct = __atomic_load_n(&composite_health[index].timeout_rate, __ATOMIC_RELAXED) * 100 / COMPOSITE_RATE_ONE;
+	health->latency_ns = __atomic_load_n(&composite_health[index].latency_ns, __ATOMIC_RELAXED);
+	health->failed_over = composite_state(index) == COMPOSITE_FAILED;
+
+	return 0;
+}
+
+static int libtypec_composite_exit(void);
+
+static int libtypec_composite_init(char **session_info)
+{
+	const char *calibrate = getenv("LIBTYPEC_CALIBRATE");
+	int num_ready = 0, len = 0;
+
+	for (int m = 0; m < COMPOSITE_NUM_MEMBERS; m++)
+	{
+		const struct libtypec_os_backend *backend = composite_members[m].backend;
+
+		composite_members[m].ready = !backend->init || backend->init(session_info) >= 0;
+		num_ready += composite_members[m].ready;
+	}
+
+	if (!num_ready)
+		return -1;
+
+	for (int op = 0; op < COMPOSITE_OP_COUNT; op++)
+	{
+		composite_route[op] = -1;
+
+		for (int m = 0; m < COMPOSITE_NUM_MEMBERS && composite_route[op] < 0; m++)
+		{
+			if (composite_members[m].ready && composite_op_fn(composite_members[m].backend, op))
+				composite_route[op] = m;
+		}
+
+		if (calibrate && atoi(calibrate) > 0)
+			composite_calibrate(op);
+
+		if (composite_route[op] >= 0 && len < (int)sizeof(composite_routing))
+			len += snprintf(composite_routing + len, sizeof(composite_routing) - len, "%s%s=%s",
+					len ? "," : "", composite_ops[op].name, composite_members[composite_route[op]].name);
+	}
+
+	memset(composite_health, 0, sizeof(composite_health));
+
+	/* Failover needs somewhere to go */
+	if (num_ready > 1)
+	{
+		composite_stopping = 0;
+		composite_wake_fd = eventfd(0, EFD_CLOEXEC);
+		if (composite_wake_fd >= 0 && pthread_create(&composite_health_thread, NULL, composite_health_worker, NULL))
+		{
+			close(composite_wake_fd);
+			composite_wake_fd = -1;
+		}
+	}
+
+	return 0;
+}
+
+static int libtypec_composite_exit(void)
+{
+	uint64_t one = 1;
+
+	if (composite_wake_fd >= 0)
+	{
+		__atomic_store_n(&composite_stopping, 1, __ATOMIC_RELEASE);
+		if (write(composite_wake_fd, &one, sizeof(one)) == sizeof(one))
+			pthread_join(composite_health_thread, NULL);
+		else
+			pthread_detach(composite_health_thread);
+		close(composite_wake_fd);
+		composite_wake_fd = -1;
+	}
+
+	for (int m = 0; m < COMPOSITE_NUM_MEMBERS; m++)
+	{
+		const struct libtypec_os_backend *backend = composite_members[m].backend;
+
+		if (composite_members[m].ready && backend->exit)
+			backend->exit();
+		composite_members[m].ready = 0;
+	}
+	composite_routing[0] = '\0';
+
+	return 0;
+}
+
+/**
+ * This function reports which member backend serves each op, as
+ * comma separated op=backend pairs.
+ */
+const char *libtypec_composite_routing(void)
+{
+	return composite_routing;
+}
+
+static int libtypec_composite_get_capability_ops(struct libtypec_capability_data *cap_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CAPABILITY, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_capability_ops(cap_data), t0);
+}
+
+static int libtypec_composite_get_conn_capability_ops(int conn_num, struct libtypec_connector_cap_data *conn_cap_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CONN_CAPABILITY, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_conn_capability_ops(conn_num, conn_cap_data), t0);
+}
+
+static int libtypec_composite_get_alternate_modes(int recipient, int conn_num, struct altmode_data *alt_mode_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_ALTERNATE_MODES, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_alternate_modes(recipient, conn_num, alt_mode_data), t0);
+}
+
+static int libtypec_composite_get_cam_supported_ops(int conn_num, char *cam_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CAM_SUPPORTED, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_cam_supported_ops(conn_num, cam_data), t0);
+}
+
+static int libtypec_composite_get_current_cam_ops(char *cur_cam_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CURRENT_CAM, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_current_cam_ops(cur_cam_data), t0);
+}
+
+static int libtypec_composite_get_pdos_ops(int conn_num, int partner, int offset, int *num_pdo, int src_snk, int type, unsigned int *pdo_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_PDOS, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_pdos_ops(conn_num, partner, offset, num_pdo, src_snk, type, pdo_data), t0);
+}
+
+static int libtypec_composite_get_cable_properties_ops(int conn_num, struct libtypec_cable_property *cbl_prop_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CABLE_PROPERTIES, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_cable_properties_ops(conn_num, cbl_prop_data), t0);
+}
+
+static int libtypec_composite_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_CONNECTOR_STATUS, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_connector_status_ops(conn_num, conn_sts), t0);
+}
+
+static int libtypec_composite_get_pd_message_ops(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_PD_MESSAGE, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_pd_message_ops(recipient, conn_num, num_bytes, resp_type, pd_msg_resp), t0);
+}
+
+static int libtypec_composite_get_bb_status(unsigned int *num_bb_instance)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_BB_STATUS, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_bb_status(num_bb_instance), t0);
+}
+
+static int libtypec_composite_get_bb_data(int num_billboards, char *bb_data)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_BB_DATA, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_bb_data(num_billboards, bb_data), t0);
+}
+
+static void libtypec_composite_monitor_events(void)
+{
+	const struct libtypec_os_backend *backend = composite_backend(COMPOSITE_OP_MONITOR_EVENTS);
+
+	if (backend)
+		backend->monitor_events();
+}
+
+static int libtypec_composite_get_power_supply_status_ops(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+	unsigned long long t0;
+	int m = composite_enter(COMPOSITE_OP_POWER_SUPPLY_STATUS, &t0);
+
+	if (m < 0)
+		return -EIO;
+
+	return composite_leave(m, composite_members[m].backend->get_power_supply_status_ops(conn_num, psy_sts), t0);
+}
+
+const struct libtypec_os_backend libtypec_composite_backend = {
+	.init = libtypec_composite_init,
+	.exit = libtypec_composite_exit,
+	.get_capability_ops = libtypec_composite_get_capability_ops,
+	.get_conn_capability_ops = libtypec_composite_get_conn_capability_ops,
+	.get_alternate_modes = libtypec_composite_get_alternate_modes,
+	.get_cam_supported_ops = libtypec_composite_get_cam_supported_ops,
+	.get_current_cam_ops = libtypec_composite_get_current_cam_ops,
+	.get_pdos_ops = libtypec_composite_get_pdos_ops,
+	.get_cable_properties_ops = libtypec_composite_get_cable_properties_ops,
+	.get_connector_status_ops = libtypec_composite_get_connector_status_ops,
+	.get_pd_message_ops = libtypec_composite_get_pd_message_ops,
+	.get_bb_status = libtypec_composite_get_bb_status,
+	.get_bb_data = libtypec_composite_get_bb_data,
+	.monitor_events = libtypec_composite_monitor_events,
+	.get_power_supply_status_ops = libtypec_composite_get_power_supply_status_ops,
+};
@@ -42,110 +42,528 @@ SOFTWARE.
 #include <ftw.h>
 #include <fcntl.h>
 #include <unistd.h>
-#include <poll.h>
+#include <pthread.h>
+#include <sys/file.h>
 
-int fp_command;
-int fp_response;
-struct pollfd  pfds;
+#define UCSI_MAX_INSTANCES 8
+#define UCSI_MESSAGE_IN_SIZE 16
 
-int get_ucsi_response(char *data)
+/* "0x", two digits per MESSAGE_IN byte and a newline */
+#define UCSI_RESP_MAX_CHARS (2 + 2 * LIBTYPEC_UCSI_MESSAGE_IN_MAX + 1)
+
+#define UCSI_GET_CAM_SUPPORTED 0x0d
+#define UCSI_GET_CURRENT_CAM 0x0e
+#define UCSI_GET_CABLE_PROPERTY 0x11
+#define UCSI_GET_CONNECTOR_STATUS 0x12
+#define UCSI_GET_PD_MESSAGE 0x15
+
+/* Number of Bytes of GET_PD_MESSAGE is 8 bits wide */
+#define UCSI_PD_CHUNK_MAX 255
+#define UCSI_PD_MESSAGE_MAX 260
+#define UCSI_PD_RESP_TYPES (DISCOVER_ID_REQ + 1)
+#define UCSI_PD_RECIPIENTS (AM_SOP_DPR - AM_SOP + 1)
+#define UCSI_MAX_PORTS 32
+
+/**
+ * @brief One PPM exposed under UCSI_DEBUGFS_PATH
+ *
+ * Connectors are numbered globally across instances in name order, the
+ * instance owns [conn_base, conn_base + num_connectors). Instances are
+ * independent firmware channels, each serializes only its own commands.
+ *
+ * The command and response files carry one transaction at a time for
+ * every process on the system. Threads of this process queue for an
+ * instance in ticket order, the thread being served then takes an
+ * advisory flock on the command file to exclude other processes.
+ */
+struct ucsi_instance
+{
+	char name[64];
+	int fp_command;
+	int fp_response;
+	pthread_mutex_t lock;
+	pthread_cond_t turn;
+	unsigned long next_ticket;
+	unsigned long serving;
+	int conn_base;
+	int num_connectors;
+	struct libtypec_capability_data cap;
+	int cap_ret;
+	int message_in_size;	/* MESSAGE_IN bytes the GET_CAPABILITY response decoded to */
+};
+
+static struct ucsi_instance ucsi_instances[UCSI_MAX_INSTANCES];
+static int num_ucsi_instances;
+
+static __thread struct libtypec_ucsi_wait_stats ucsi_wait_stats;
+
+/**
+ * @brief Reassembled GET_PD_MESSAGE response
+ *
+ * An entry is valid while its generation matches the port's, which
+ * advances on every connector change libtypec observes, and while the
+ * partner or cable it was read from is still attached. Entries and the
+ * last connector status are guarded by the owning instance's lock.
+ */
+struct ucsi_pd_cache
 {
-	char c[64],i=0,j=0;
-	 if(fp_response <=0)
-	 	return -1;
+	unsigned int generation;
+	uint64_t connect_id;
+	int len;
+	unsigned char data[UCSI_PD_MESSAGE_MAX];
+};
+
+static struct ucsi_pd_cache *ucsi_pd_cache[UCSI_MAX_PORTS];
+static unsigned int ucsi_port_generation[UCSI_MAX_PORTS];
+
+/* typec class port number + 1 of each connector, 0 until resolved */
+static int ucsi_typec_port[UCSI_MAX_PORTS];
+static uint32_t ucsi_port_last_status[UCSI_MAX_PORTS];
+
+/* Length of each GET_PD_MESSAGE response type, by libtypec resp_type */
+static const int ucsi_pd_message_len[UCSI_PD_RESP_TYPES] = {
+	[GET_SINK_CAP_EXTENDED] = 24,	/* SKEDB */
+	[GET_SOURCE_CAP_EXTENDED] = 25,	/* SCEDB */
+	[GET_BATTERY_CAP] = 9,		/* BCDB */
+	[GET_BATTERY_STATUS] = 4,	/* BSDO */
+	[DISCOVER_ID_REQ] = 28,		/* VDM header and six VDOs */
+};
 
-	i=poll(&pfds,1,-1);
-	if(i<0)
+static int dbgfs_ready(void)
+{
+	return num_ucsi_instances > 0;
+}
+
+static unsigned long long elapsed_ns(const struct timespec *a, const struct timespec *b)
+{
+	return (b->tv_sec - a->tv_sec) * 1000000000ull + b->tv_nsec - a->tv_nsec;
+}
+
+static unsigned long long ucsi_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Waits for this thread's turn on the instance, then for other processes */
+static void ucsi_engine_acquire(struct ucsi_instance *inst)
+{
+	unsigned long long t0, t1, t2;
+	unsigned long ticket;
+
+	t0 = ucsi_now_ns();
+
+	pthread_mutex_lock(&inst->lock);
+	ticket = inst->next_ticket++;
+	while (ticket != inst->serving)
+		pthread_cond_wait(&inst->turn, &inst->lock);
+	pthread_mutex_unlock(&inst->lock);
+
+	t1 = ucsi_now_ns();
+	while (flock(inst->fp_command, LOCK_EX) < 0 && errno == EINTR)
+		;
+	t2 = ucsi_now_ns();
+
+	ucsi_wait_stats.transactions++;
+	ucsi_wait_stats.queue_wait_ns += t1 - t0;
+	ucsi_wait_stats.lock_wait_ns += t2 - t1;
+	if (t2 - t0 > ucsi_wait_stats.max_wait_ns)
+		ucsi_wait_stats.max_wait_ns = t2 - t0;
+}
+
+static void ucsi_engine_release(struct ucsi_instance *inst)
+{
+	flock(inst->fp_command, LOCK_UN);
+
+	pthread_mutex_lock(&inst->lock);
+	inst->serving++;
+	pthread_cond_broadcast(&inst->turn);
+	pthread_mutex_unlock(&inst->lock);
+}
+
+/* Nibble value of a hex digit, -1 for anything else */
+static const int8_t ucsi_hex[256] = {
+	['0'] = 0x10, ['1'] = 0x11, ['2'] = 0x12, ['3'] = 0x13, ['4'] = 0x14,
+	['5'] = 0x15, ['6'] = 0x16, ['7'] = 0x17, ['8'] = 0x18, ['9'] = 0x19,
+	['a'] = 0x1a, ['b'] = 0x1b, ['c'] = 0x1c, ['d'] = 0x1d, ['e'] = 0x1e, ['f'] = 0x1f,
+	['A'] = 0x1a, ['B'] = 0x1b, ['C'] = 0x1c, ['D'] = 0x1d, ['E'] = 0x1e, ['F'] = 0x1f,
+};
+
+/**
+ * Decodes a debugfs response, "0x" followed by MESSAGE_IN as one hex
+ * number, into MESSAGE_IN bytes, least significant byte first. Table
+ * entries carry bit 4 for valid digits so a whole response is validated
+ * with one test after the loop instead of a branch per character.
+ *
+ * \returns number of bytes decoded, -EPROTO for a malformed response
+ */
+static int ucsi_decode_response(const char *resp, int len, unsigned char *msg)
+{
+	const unsigned char *digits = (const unsigned char *)resp + 2;
+	int num_digits, valid = 0x10;
+
+	while (len > 2 && (resp[len - 1] == '\n' || resp[len - 1] == '\0'))
+		len--;
+
+	num_digits = len - 2;
+	if (len < 2 || resp[0] != '0' || (resp[1] | 0x20) != 'x' ||
+	    num_digits <= 0 || num_digits & 1 || num_digits > 2 * LIBTYPEC_UCSI_MESSAGE_IN_MAX)
+		return -EPROTO;
+
+	for (int i = 0; i < num_digits / 2; i++)
+	{
+		int hi = ucsi_hex[digits[num_digits - 2 - 2 * i]];
+		int lo = ucsi_hex[digits[num_digits - 1 - 2 * i]];
+
+		valid &= hi & lo;
+		msg[i] = (hi & 0xf) << 4 | (lo & 0xf);
+	}
+
+	return valid ? num_digits / 2 : -EPROTO;
+}
+
+/**
+ * Issues one UCSI command to an instance through debugfs and decodes the
+ * whole response into MESSAGE_IN bytes, least significant byte first.
+ * Bytes beyond the response read as zero. Every transaction goes through
+ * here so it can be recorded or replayed.
+ *
+ * \returns number of MESSAGE_IN bytes in the response, the negative errno
+ * of a failed command, -ETIMEDOUT when the PPM did not respond in time,
+ * -EPROTO for a malformed response, -1 on other failures
+ */
+static int ucsi_transaction(struct ucsi_instance *inst, unsigned long long command, unsigned char *data)
+{
+	struct timespec t0, t1, t2;
+	char c[UCSI_RESP_MAX_CHARS], cmd[24];
+	int j, n, len, ret, idx = inst - ucsi_instances;
+
+	memset(data, 0, LIBTYPEC_UCSI_MESSAGE_IN_MAX);
+
+	if (libtypec_ucsi_trace_replaying())
+		return libtypec_ucsi_trace_replay(idx, command, data, LIBTYPEC_UCSI_MESSAGE_IN_MAX);
+
+	if (inst->fp_command <= 0 || inst->fp_response <= 0)
 		return -1;
-	j = read(fp_response, c,64);
-	
-	for(i=2;i<j;i++)
-	{		
-		if(c[i] > '9')
-			data[i-2]=c[i]- 87;
+
+	len = snprintf(cmd, sizeof(cmd), "%llu", command);
+
+	ucsi_engine_acquire(inst);
+
+	/*
+	 * The kernel runs the command synchronously within write(), a PPM
+	 * that does not answer in time fails it with ETIMEDOUT.
+	 */
+	clock_gettime(CLOCK_MONOTONIC, &t0);
+	ret = write(inst->fp_command, cmd, len + 1);
+	if (ret <= 0)
+	{
+		ret = ret < 0 ? -errno : -EIO;
+		ucsi_engine_release(inst);
+		clock_gettime(CLOCK_MONOTONIC, &t1);
+		libtypec_ucsi_trace_record(idx, command, &t0, elapsed_ns(&t0, &t1), 0, NULL, 0, UCSI_TRACE_WRITE_ERR);
+		return ret;
+	}
+
+	/* Wide responses may take more than one read */
+	clock_gettime(CLOCK_MONOTONIC, &t1);
+	j = 0;
+	while (j < (int)sizeof(c) && (n = read(inst->fp_response, c + j, sizeof(c) - j)) > 0)
+		j += n;
+	if (n < 0)
+		j = -1;
+	clock_gettime(CLOCK_MONOTONIC, &t2);
+	lseek(inst->fp_response, 0, SEEK_SET);
+
+	ucsi_engine_release(inst);
+
+	ret = j < 0 ? -1 : ucsi_decode_response(c, j, data);
+
+	libtypec_ucsi_trace_record(idx, command, &t0, elapsed_ns(&t0, &t1), elapsed_ns(&t1, &t2), data, ret,
+				   j < 0 ? UCSI_TRACE_READ_ERR : ret < 0 ? UCSI_TRACE_FORMAT_ERR : UCSI_TRACE_OK);
+
+	return ret;
+}
+
+/**
+ * Extracts a field of up to 32 bits from MESSAGE_IN, counting bit
+ * positions from its least significant bit as in the UCSI specification.
+ */
+static uint32_t ucsi_field(const unsigned char *msg, int offset, int width)
+{
+	uint64_t val = 0;
+
+	for (int i = (offset + width - 1) / 8; i >= offset / 8; i--)
+		val = val << 8 | msg[i];
+
+	return (val >> (offset % 8)) & ((1ull << width) - 1);
+}
+
+/* Instance owning a global connector number, with its local number */
+static struct ucsi_instance *ucsi_connector(int conn_num, int *local_conn)
+{
+	for (int i = 0; i < num_ucsi_instances; i++)
+	{
+		struct ucsi_instance *inst = &ucsi_instances[i];
+
+		if (conn_num >= inst->conn_base && conn_num < inst->conn_base + inst->num_connectors)
+		{
+			*local_conn = conn_num - inst->conn_base;
+			return inst;
+		}
+	}
+
+	return NULL;
+}
+
+static void *ucsi_get_capability(void *arg)
+{
+	struct ucsi_instance *inst = arg;
+	struct libtypec_capability_data cap;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	int ret;
+
+	ret = ucsi_transaction(inst, 6, buf);
+
+	/* A short response leaves the instance without capabilities */
+	if (ret >= 0 && ret < UCSI_MESSAGE_IN_SIZE)
+		ret = -1;
+
+	if (ret >= 0)
+	{
+		memset(&cap, 0, sizeof(cap));
+		cap.bmAttributes = ucsi_field(buf, 0, 32);
+		cap.bNumConnectors = ucsi_field(buf, 32, 8);
+		cap.bmOptionalFeatures = ucsi_field(buf, 40, 24);
+		cap.bNumAltModes = ucsi_field(buf, 64, 8);
+		cap.bcdBCVersion = ucsi_field(buf, 80, 16);
+		cap.bcdPDVersion = ucsi_field(buf, 96, 16);
+		cap.bcdTypeCVersion = ucsi_field(buf, 112, 16);
+	}
+
+	pthread_mutex_lock(&inst->lock);
+	inst->cap_ret = ret;
+	if (ret >= 0)
+	{
+		inst->cap = cap;
+		inst->message_in_size = ret;
+	}
+	pthread_mutex_unlock(&inst->lock);
+
+	return NULL;
+}
+
+/**
+ * Runs GET_CAPABILITY on every instance at once, so the query takes as
+ * long as the slowest PPM rather than the sum of all of them. Called once
+ * from init, the capabilities are served from the instances afterwards.
+ *
+ * \returns 0 when at least one instance answered, -1 otherwise
+ */
+static int ucsi_query_instances(void)
+{
+	pthread_t threads[UCSI_MAX_INSTANCES];
+	int started[UCSI_MAX_INSTANCES] = {0};
+	int ret = -1;
+
+	for (int i = 1; i < num_ucsi_instances; i++)
+		started[i] = pthread_create(&threads[i], NULL, ucsi_get_capability, &ucsi_instances[i]) == 0;
+
+	ucsi_get_capability(&ucsi_instances[0]);
+
+	for (int i = 1; i < num_ucsi_instances; i++)
+	{
+		if (started[i])
+			pthread_join(threads[i], NULL);
 		else
-			data[i-2]=c[i]-'0';
+			ucsi_get_capability(&ucsi_instances[i]);
+	}
 
+	/* One answering PPM is enough, otherwise report why the last one failed */
+	for (int i = 0; i < num_ucsi_instances; i++)
+	{
+		if (ucsi_instances[i].cap_ret >= 0)
+			return 0;
+		ret = ucsi_instances[i].cap_ret;
 	}
-	lseek(fp_response,0,SEEK_SET);
-	return j;
+
+	return ret;
 }
-static int libtypec_dbgfs_init(char **session_info)
+
+static int ucsi_open_instance(struct ucsi_instance *inst, const char *name)
 {
+	char path[512];
 
-   	fp_command = open("/sys/kernel/debug/usb/ucsi/USBC000:00/command", O_WRONLY);
-	
-	if (fp_command <= 0)
+	snprintf(inst->name, sizeof(inst->name), "%s", name);
+	pthread_mutex_init(&inst->lock, NULL);
+	pthread_cond_init(&inst->turn, NULL);
+	inst->next_ticket = 0;
+	inst->serving = 0;
+	inst->fp_command = -1;
+	inst->fp_response = -1;
+
+	/* Replayed transactions never reach the kernel */
+	if (!name[0])
+		return 0;
+
+	snprintf(path, sizeof(path), UCSI_DEBUGFS_PATH "/%s/command", name);
+	inst->fp_command = open(path, O_WRONLY);
+
+	snprintf(path, sizeof(path), UCSI_DEBUGFS_PATH "/%s/response", name);
+	inst->fp_response = open(path, O_RDONLY);
+
+	if (inst->fp_command <= 0 || inst->fp_response <= 0)
+	{
+		if (inst->fp_command > 0)
+			close(inst->fp_command);
+		if (inst->fp_response > 0)
+			close(inst->fp_response);
+		pthread_mutex_destroy(&inst->lock);
+		pthread_cond_destroy(&inst->turn);
 		return -1;
+	}
 
-   	fp_response = open("/sys/kernel/debug/usb/ucsi/USBC000:00/response",O_RDONLY);
-	
-	if (fp_response <= 0)
+
+	return 0;
+}
+
+static int ucsi_filter_instance(const struct dirent *entry)
+{
+	return entry->d_name[0] != '.';
+}
+
+static int libtypec_dbgfs_exit(void);
+
+static int libtypec_dbgfs_init(char **session_info)
+{
+	struct dirent **entries;
+	int ret, num_entries, conn_base = 0;
+
+	ret = libtypec_ucsi_trace_init();
+	if (ret < 0)
+		return ret;
+
+	num_ucsi_instances = 0;
+
+	if (ret > 0)
+	{
+		int num = libtypec_ucsi_trace_instances();
+
+		for (int i = 0; i < num && i < UCSI_MAX_INSTANCES; i++)
+			ucsi_open_instance(&ucsi_instances[num_ucsi_instances++], "");
+	}
+	else
+	{
+		num_entries = scandir(UCSI_DEBUGFS_PATH, &entries, ucsi_filter_instance, alphasort);
+		if (num_entries < 0)
+			return -1;
+
+		for (int i = 0; i < num_entries; i++)
+		{
+			if (num_ucsi_instances < UCSI_MAX_INSTANCES &&
+			    ucsi_open_instance(&ucsi_instances[num_ucsi_instances], entries[i]->d_name) == 0)
+				num_ucsi_instances++;
+			free(entries[i]);
+		}
+		free(entries);
+	}
+
+	if (!num_ucsi_instances || ucsi_query_instances() < 0)
+	{
+		libtypec_dbgfs_exit();
 		return -1;
+	}
+
+	for (int i = 0; i < num_ucsi_instances; i++)
+	{
+		struct ucsi_instance *inst = &ucsi_instances[i];
+
+		inst->conn_base = conn_base;
+		inst->num_connectors = inst->cap_ret >= 0 ? inst->cap.bNumConnectors : 0;
+		conn_base += inst->num_connectors;
+	}
 
-	pfds.fd = fp_response;
-	pfds.events = POLLIN;
-	
 	return 0;
 }
 
 static int libtypec_dbgfs_exit(void)
 {
-	close(fp_command);
-	close(fp_response);
-    fp_command = -1;
-    fp_response = -1;
+	for (int i = 0; i < num_ucsi_instances; i++)
+	{
+		struct ucsi_instance *inst = &ucsi_instances[i];
+
+		if (inst->fp_command > 0)
+			close(inst->fp_command);
+		if (inst->fp_response > 0)
+			close(inst->fp_response);
+		pthread_mutex_destroy(&inst->lock);
+		pthread_cond_destroy(&inst->turn);
+	}
+	num_ucsi_instances = 0;
+
+	for (int i = 0; i < UCSI_MAX_PORTS; i++)
+	{
+		free(ucsi_pd_cache[i]);
+		ucsi_pd_cache[i] = NULL;
+		ucsi_typec_port[i] = 0;
+	}
+
+	libtypec_ucsi_trace_exit();
 	return 0;
 }
 
 static int libtypec_dbgfs_get_capability_ops(struct libtypec_capability_data *cap_data)
 {
-    int ret=-1;
-	char buf[64];
+	int ret = -1, first = 1;
 
-    if(fp_command > 0)
-    {
-        ret = write(fp_command,"6",sizeof("6"));
- 
-        if(ret)
-        {
-            ret = get_ucsi_response(buf);
+	/* Capabilities are fixed per PPM and were read by init */
+	if (dbgfs_ready())
+	{
+		ret = 0;
 
-            if(ret<31)
-                ret = -1;
+		/* Connectors and alternate modes add up, the rest is the first PPM's */
+		for (int i = 0; i < num_ucsi_instances; i++)
+		{
+			struct ucsi_instance *inst = &ucsi_instances[i];
 
-			cap_data->bmAttributes = buf[24] << 28 | buf[25] << 24 | buf[26] << 20 | buf[27] << 16 | buf[28] << 12 | buf[29] <<8 | buf[30] << 4 | buf[31];	
-			cap_data->bNumConnectors = buf[22] << 4 | buf[23] ;
-			cap_data->bmOptionalFeatures = buf[16] << 20 | buf[17] << 16 | buf[18] << 12 | buf[19] << 8 | buf[20] << 4 | buf[21] ;
-			cap_data->bNumAltModes = buf[14] << 4 | buf[15] ;
-			cap_data->bcdBCVersion = buf[8] << 12 | buf[9] << 8 | buf[10] << 4 | buf[11] ;
-			cap_data->bcdPDVersion = buf[4] << 12 | buf[5] << 8 | buf[6] << 4 | buf[7] ;
-			cap_data->bcdTypeCVersion = buf[0] << 12 | buf[1] << 8 | buf[2] << 4 | buf[3] ;
+			if (inst->cap_ret < 0)
+				continue;
+
+			if (first)
+			{
+				*cap_data = inst->cap;
+				cap_data->bNumConnectors = inst->num_connectors;
+				first = 0;
+			}
+			else
+			{
+				cap_data->bNumConnectors += inst->num_connectors;
+				cap_data->bNumAltModes += inst->cap.bNumAltModes;
+			}
+		}
+	}
 
-        }
-    }
-	
 	return ret;
 }
 
 static int libtypec_dbgfs_get_conn_capability_ops(int conn_num, struct libtypec_connector_cap_data *conn_cap_data)
 {
-    int ret=-1;
-	unsigned char buf[64];
+    int ret=-1, local_conn;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	struct ucsi_instance *inst = ucsi_connector(conn_num, &local_conn);
 
 
-    if(fp_command > 0)
+    if(inst)
     {
-		snprintf(buf, sizeof(buf), "%d", (conn_num+1)<<16|7);
-		
-        ret = write(fp_command,buf,sizeof(buf));
-	
-        if(ret)
+        ret = ucsi_transaction(inst, (local_conn+1)<<16|7, buf);
+
+        if(ret >= 0)
         {
-            ret = get_ucsi_response(buf);
-            if(ret<31)
+            if(ret<UCSI_MESSAGE_IN_SIZE)
                 ret = -1;
-			conn_cap_data->opr_mode = buf[28] << 12 | buf[29] <<8 | buf[30] << 4 | buf[31];	
+			conn_cap_data->opr_mode = ucsi_field(buf, 0, 16);
 	}
     }
     
@@ -166,36 +584,32 @@ static int libtypec_dbgfs_get_alternate_modes(int recipient, int conn_num, struc
 		}s;
 	}am_cmd;
 
-	int ret=-1,i=0;
-	unsigned char buf[64];
+	int ret=-1,i=0,local_conn;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	struct ucsi_instance *inst = ucsi_connector(conn_num, &local_conn);
 
-	if(fp_command > 0)
+	if(inst)
 	{
 		do
 		{
+			am_cmd.cmd_val = 0;
 			am_cmd.s.cmd = 0xc;
 			am_cmd.s.len = 0;
 			am_cmd.s.rcp = recipient;
-			am_cmd.s.con = conn_num+1;
+			am_cmd.s.con = local_conn+1;
 			am_cmd.s.offset = i;
 			am_cmd.s.num_am = 0;
 
-			snprintf(buf, sizeof(buf), "%lld", am_cmd.cmd_val);
-			
-			ret = write(fp_command,buf,sizeof(buf));
+			ret = ucsi_transaction(inst, am_cmd.cmd_val, buf);
 
-			if(ret)
-			{
-				ret = get_ucsi_response(buf);
-				if(ret<31)
-					return -1;
-				
-				alt_mode_data[i].svid 	 = buf[28] << 12 | buf[29] <<8 | buf[30] << 4 | buf[31];
-				alt_mode_data[i].vdo 	 = buf[24] << 12 | buf[25] <<8 | buf[26] << 4 | buf[27];	
-				
-				if(alt_mode_data[i].svid == 0)
-					break;
-			}
+			if(ret<UCSI_MESSAGE_IN_SIZE)
+				return ret < 0 ? ret : -1;
+			
+			alt_mode_data[i].svid 	 = ucsi_field(buf, 0, 16);
+			alt_mode_data[i].vdo 	 = ucsi_field(buf, 16, 16);
+			
+			if(alt_mode_data[i].svid == 0)
+				break;
 			i++;
 		}while(1);
 
@@ -221,16 +635,18 @@ static int libtypec_dbgfs_get_pdos_ops(int conn_num, int partner, int offset, in
 		}s;
 	}pdo_cmd;
 
-	int ret=-1,i=0;
-	unsigned char buf[64];
+	int ret=-1,i=0,local_conn;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	struct ucsi_instance *inst = ucsi_connector(conn_num, &local_conn);
 
-	if(fp_command > 0)
+	if(inst)
 	{
 		do
 		{
+			pdo_cmd.cmd_val = 0;
 			pdo_cmd.s.cmd = 0x10;
 			pdo_cmd.s.len = 0;
-			pdo_cmd.s.con = conn_num+1;
+			pdo_cmd.s.con = local_conn+1;
 			pdo_cmd.s.ptnr = partner;
 			pdo_cmd.s.offset = i;
 			pdo_cmd.s.num = 0;
@@ -238,20 +654,13 @@ static int libtypec_dbgfs_get_pdos_ops(int conn_num, int partner, int offset, in
 			pdo_cmd.s.type = type;
 			
 
-			snprintf(buf, sizeof(buf), "%lld", pdo_cmd.cmd_val);
-			//printf("cmd %lld \n",pdo_cmd.cmd_val);
-			
-			ret = write(fp_command,buf,sizeof(buf));
+			ret = ucsi_transaction(inst, pdo_cmd.cmd_val, buf);
 
-			if(ret)
-			{
-				ret = get_ucsi_response(buf);
-				if(ret<31)
-					return -1;
-				pdo_data[i] = buf[24] << 28 | buf[25] << 24 | buf[26] << 20 | buf[27] << 16 | buf[28] << 12 | buf[29] <<8 | buf[30] << 4 | buf[31];					
-				if(pdo_data[i] == 0)
-					break;
-			}
+			if(ret<UCSI_MESSAGE_IN_SIZE)
+				return ret < 0 ? ret : -1;
+			pdo_data[i] = ucsi_field(buf, 0, 32);
+			if(pdo_data[i] == 0)
+				break;
 			i++;
 		}while(1);
 
@@ -263,18 +672,448 @@ static int libtypec_dbgfs_get_pdos_ops(int conn_num, int partner, int offset, in
 
 }
 
+/* Issues a connector command, the connector number goes to bits 22:16 */
+static int ucsi_connector_command(int conn_num, unsigned long long command, unsigned char *buf)
+{
+	struct ucsi_instance *inst;
+	int ret, local_conn;
+
+	inst = ucsi_connector(conn_num, &local_conn);
+	if (!inst)
+		return -1;
+
+	ret = ucsi_transaction(inst, (unsigned long long)(local_conn + 1) << 16 | command, buf);
+	if (ret >= 0 && ret < UCSI_MESSAGE_IN_SIZE)
+		return -1;
+
+	return ret;
+}
+
+static int libtypec_dbgfs_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	struct ucsi_instance *inst;
+	int ret, local_conn;
+
+	ret = ucsi_connector_command(conn_num, UCSI_GET_CONNECTOR_STATUS, buf);
+	if (ret < 0)
+		return ret;
+
+	conn_sts->sts_change = ucsi_field(buf, 0, 16);
+	conn_sts->pwr_op_mode = ucsi_field(buf, 16, 3);
+	conn_sts->connect_sts = ucsi_field(buf, 19, 1);
+	conn_sts->pwr_dir = ucsi_field(buf, 20, 1);
+	conn_sts->ptnr_flags = ucsi_field(buf, 21, 8);
+	conn_sts->ptnr_type = ucsi_field(buf, 29, 3);
+	conn_sts->rdo = ucsi_field(buf, 32, 32);
+	conn_sts->bat_chrg_cap_sts = ucsi_field(buf, 64, 2);
+	conn_sts->cap_ltd_reason = ucsi_field(buf, 66, 4);
+	conn_sts->bcdPDVer_op_mode = ucsi_field(buf, 70, 16);
+
+	/* A change reported by the PPM or a different partner drops cached PD messages */
+	inst = ucsi_connector(conn_num, &local_conn);
+	if (inst && conn_num < UCSI_MAX_PORTS)
+	{
+		pthread_mutex_lock(&inst->lock);
+		if (conn_sts->sts_change || ucsi_field(buf, 16, 16) != ucsi_port_last_status[conn_num])
+		{
+			ucsi_port_last_status[conn_num] = ucsi_field(buf, 16, 16);
+			libtypec_dbgfs_port_changed(conn_num);
+		}
+		pthread_mutex_unlock(&inst->lock);
+	}
+
+	return 0;
+}
+
+static int libtypec_dbgfs_get_cable_properties_ops(int conn_num, struct libtypec_cable_property *cbl_prop_data)
+{
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	int ret;
+
+	ret = ucsi_connector_command(conn_num, UCSI_GET_CABLE_PROPERTY, buf);
+	if (ret < 0)
+		return ret;
+
+	cbl_prop_data->speed_supported = ucsi_field(buf, 0, 16);
+	cbl_prop_data->current_capability = ucsi_field(buf, 16, 8);
+	cbl_prop_data->vbus_support = ucsi_field(buf, 24, 1);
+	cbl_prop_data->cable_type = ucsi_field(buf, 25, 1) ? CABLE_TYPE_ACTIVE : CABLE_TYPE_PASSIVE;
+	cbl_prop_data->directionality = ucsi_field(buf, 26, 1);
+	cbl_prop_data->plug_end_type = ucsi_field(buf, 27, 2);
+	cbl_prop_data->mode_support = ucsi_field(buf, 29, 1);
+	cbl_prop_data->latency = ucsi_field(buf, 32, 4);
+
+	return 0;
+}
+
+/**
+ * bmAlternateModeSupported of a connector, one bit per alternate mode
+ * reported by GET_ALTERNATE_MODES on the connector recipient.
+ *
+ * \returns number of bitmap bytes written, least significant first
+ */
+static int libtypec_dbgfs_get_cam_supported_ops(int conn_num, char *cam_data)
+{
+	struct ucsi_instance *inst;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	int ret, local_conn, len;
+
+	inst = ucsi_connector(conn_num, &local_conn);
+	if (!inst)
+		return -1;
+
+	ret = ucsi_connector_command(conn_num, UCSI_GET_CAM_SUPPORTED, buf);
+	if (ret < 0)
+		return ret;
+
+	len = (inst->cap.bNumAltModes + 7) / 8;
+	if (len < 1)
+		len = 1;
+	if (len > UCSI_MESSAGE_IN_SIZE)
+		len = UCSI_MESSAGE_IN_SIZE;
+
+	memcpy(cam_data, buf, len);
+
+	return len;
+}
+
+/**
+ * GET_CURRENT_CAM is a connector command while this op has no connector
+ * argument, so every connector is queried and reports the offset of its
+ * current alternate mode, 0xff when none is active.
+ *
+ * \returns number of connectors written to cur_cam_data
+ */
+static int libtypec_dbgfs_get_current_cam_ops(char *cur_cam_data)
+{
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	int num = 0;
+
+	for (int i = 0; i < num_ucsi_instances; i++)
+		num += ucsi_instances[i].num_connectors;
+
+	for (int conn = 0; conn < num; conn++)
+	{
+		if (ucsi_connector_command(conn, UCSI_GET_CURRENT_CAM, buf) < 0)
+			return -1;
+
+		cur_cam_data[conn] = buf[0];
+	}
+
+	return num;
+}
+
+/**
+ * Marks the cached PD messages of a connector out of date. Called on
+ * connector changes seen through GET_CONNECTOR_STATUS or typec uevents.
+ *
+ * \param conn_num Connector, -1 for all of them
+ */
+void libtypec_dbgfs_port_changed(int conn_num)
+{
+	for (int i = 0; i < UCSI_MAX_PORTS; i++)
+	{
+		if (conn_num < 0 || i == conn_num)
+			__atomic_add_fetch(&ucsi_port_generation[i], 1, __ATOMIC_RELEASE);
+	}
+}
+
+/**
+ * Same as libtypec_dbgfs_port_changed() for a typec class port number,
+ * which only matches the connector number with a single PPM. Ports not
+ * resolved to a connector yet invalidate every connector.
+ *
+ * \param port typec class port number, -1 for all of them
+ */
+void libtypec_dbgfs_typec_port_changed(int port)
+{
+	int found = 0;
+
+	for (int i = 0; i < UCSI_MAX_PORTS && port >= 0; i++)
+	{
+		if (__atomic_load_n(&ucsi_typec_port[i], __ATOMIC_RELAXED) == port + 1)
+		{
+			libtypec_dbgfs_port_changed(i);
+			found = 1;
+		}
+	}
+
+	if (!found)
+		libtypec_dbgfs_port_changed(-1);
+}
+
+/**
+ * Reads a whole PD message with GET_PD_MESSAGE, as few chunks as the
+ * instance's MESSAGE_IN allows: 16 bytes on UCSI 1.x/2.0 PPMs, up to 255
+ * bytes on PPMs returning a wider MESSAGE_IN.
+ *
+ * \returns message length, or a negative value on failure
+ */
+static int ucsi_read_pd_message(int recipient, int conn_num, int resp_type, unsigned char *msg)
+{
+	struct ucsi_instance *inst;
+	unsigned char buf[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+	unsigned long long command;
+	int ret, local_conn, chunk_max, chunk, len = ucsi_pd_message_len[resp_type];
+
+	inst = ucsi_connector(conn_num, &local_conn);
+	if (!inst)
+		return -1;
+
+	/* The PPM's MESSAGE_IN is as wide as its GET_CAPABILITY response was */
+	chunk_max = inst->message_in_size > UCSI_MESSAGE_IN_SIZE ? inst->message_in_size : UCSI_MESSAGE_IN_SIZE;
+	if (chunk_max > UCSI_PD_CHUNK_MAX)
+		chunk_max = UCSI_PD_CHUNK_MAX;
+
+	for (int offset = 0; offset < len; offset += chunk)
+	{
+		chunk = len - offset < chunk_max ? len - offset : chunk_max;
+
+		/* UCSI numbers recipients from SOP, libtypec from the connector */
+		command = UCSI_GET_PD_MESSAGE |
+			  (unsigned long long)(recipient - AM_SOP) << 23 |
+			  (unsigned long long)offset << 26 |
+			  (unsigned long long)chunk << 34 |
+			  (unsigned long long)resp_type << 42;
+
+		ret = ucsi_connector_command(conn_num, command, buf);
+		if (ret < 0)
+			return ret;
+
+		memcpy(msg + offset, buf, chunk);
+	}
+
+	return len;
+}
+
+/* Whether typec class port is a connector of the PPM behind inst */
+static int ucsi_typec_port_of(const struct ucsi_instance *inst, int port)
+{
+	char path[64], link[256];
+	const char *dev;
+	ssize_t len;
+
+	snprintf(path, sizeof(path), SYSFS_TYPEC_PATH "/port%d/device", port);
+	len = readlink(path, link, sizeof(link) - 1);
+	if (len < 0)
+		return 0;
+	link[len] = '\0';
+
+	/* debugfs names the instance after the device the ports hang off */
+	dev = strrchr(link, '/');
+	return !strcmp(dev ? dev + 1 : link, inst->name);
+}
+
+static int ucsi_filter_typec_port(const struct dirent *entry)
+{
+	int port, end = 0;
+
+	return sscanf(entry->d_name, "port%d%n", &port, &end) == 1 && !entry->d_name[end];
+}
+
+/*
+ * typec class port of a connector. The PPM registers its connectors in
+ * order, so they are its ports sorted by number. Global connector numbers
+ * only equal port numbers with a single PPM.
+ */
+static int ucsi_resolve_typec_port(const struct ucsi_instance *inst, int local_conn, int conn_num)
+{
+	struct dirent **entries;
+	int ports[UCSI_MAX_PORTS], num_ports = 0, num_entries, port;
+
+	port = __atomic_load_n(&ucsi_typec_port[conn_num], __ATOMIC_RELAXED) - 1;
+	if (port >= 0 && ucsi_typec_port_of(inst, port))
+		return port;
+
+	if (!inst->name[0])
+		return -1;
+
+	num_entries = scandir(SYSFS_TYPEC_PATH, &entries, ucsi_filter_typec_port, NULL);
+	if (num_entries < 0)
+		return -1;
+
+	for (int i = 0; i < num_entries; i++)
+	{
+		sscanf(entries[i]->d_name, "port%d", &port);
+		if (num_ports < UCSI_MAX_PORTS && ucsi_typec_port_of(inst, port))
+		{
+			int j = num_ports++;
+
+			for (; j > 0 && ports[j - 1] > port; j--)
+				ports[j] = ports[j - 1];
+			ports[j] = port;
+		}
+		free(entries[i]);
+	}
+	free(entries);
+
+	if (local_conn >= num_ports)
+		return -1;
+
+	__atomic_store_n(&ucsi_typec_port[conn_num], ports[local_conn] + 1, __ATOMIC_RELAXED);
+	return ports[local_conn];
+}
+
+/**
+ * Identifies what is attached to a connector by the inode of its typec
+ * class partner, or cable for SOP' and SOP'', which the kernel creates
+ * anew on every attach. The connector's port is found through the PPM's
+ * own device, afterwards this costs a readlink, a stat and no PPM
+ * transaction.
+ *
+ * \returns 0 with the inode in connect_id, or with 0 when nothing is
+ * attached, -1 when the connector has no typec class port
+ */
+static int ucsi_connect_id(const struct ucsi_instance *inst, int local_conn, int conn_num, int recipient, uint64_t *connect_id)
+{
+	char path[64];
+	struct stat sb;
+	int port;
+
+	port = ucsi_resolve_typec_port(inst, local_conn, conn_num);
+	if (port < 0)
+		return -1;
+
+	snprintf(path, sizeof(path), SYSFS_TYPEC_PATH "/port%d-%s", port, recipient == AM_SOP ? "partner" : "cable");
+	*connect_id = stat(path, &sb) == 0 ? sb.st_ino : 0;
+
+	return 0;
+}
+
+/**
+ * GET_PD_MESSAGE of one response type. Discover Identity fills
+ * union libtypec_discovered_identity and returns 0 like the sysfs backend,
+ * the other types copy up to num_bytes of the raw message and return the
+ * number of bytes copied. Messages are cached per connector until the
+ * next connector change or until a different partner or cable attaches.
+ */
+static int libtypec_dbgfs_get_pd_message_ops(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp)
+{
+	struct libtypec_connector_status sts;
+	struct ucsi_instance *inst;
+	struct ucsi_pd_cache *entry;
+	unsigned char data[UCSI_PD_MESSAGE_MAX];
+	unsigned int generation;
+	uint64_t connect_id;
+	int ret, len = 0, local_conn;
+
+	if (recipient < AM_SOP || recipient > AM_SOP_DPR || num_bytes < 0 ||
+	    resp_type < 0 || resp_type >= UCSI_PD_RESP_TYPES || conn_num < 0 || conn_num >= UCSI_MAX_PORTS)
+		return -1;
+
+	inst = ucsi_connector(conn_num, &local_conn);
+	if (!inst)
+		return -1;
+
+	/* Without a typec class port a status read catches changes through the generation */
+	if (ucsi_connect_id(inst, local_conn, conn_num, recipient, &connect_id) < 0)
+	{
+		ret = libtypec_dbgfs_get_connector_status_ops(conn_num, &sts);
+		if (ret < 0)
+			return ret;
+		connect_id = sts.connect_sts;
+	}
+
+	if (!connect_id)
+		return -1;
+
+	generation = __atomic_load_n(&ucsi_port_generation[conn_num], __ATOMIC_ACQUIRE);
+
+	pthread_mutex_lock(&inst->lock);
+	if (!ucsi_pd_cache[conn_num])
+		ucsi_pd_cache[conn_num] = calloc(UCSI_PD_RECIPIENTS * UCSI_PD_RESP_TYPES, sizeof(struct ucsi_pd_cache));
+
+	entry = ucsi_pd_cache[conn_num] ? &ucsi_pd_cache[conn_num][(recipient - AM_SOP) * UCSI_PD_RESP_TYPES + resp_type] : NULL;
+
+	/* Generation 0 never matches, ports start at 1 */
+	if (entry && entry->len && entry->generation == generation + 1 && entry->connect_id == connect_id)
+	{
+		len = entry->len;
+		memcpy(data, entry->data, len);
+	}
+	pthread_mutex_unlock(&inst->lock);
+
+	if (!len)
+	{
+		/* Read outside the lock, transactions queue on it */
+		ret = ucsi_read_pd_message(recipient, conn_num, resp_type, data);
+		if (ret < 0)
+			return ret;
+		len = ret;
+
+		pthread_mutex_lock(&inst->lock);
+		if (entry)
+		{
+			memcpy(entry->data, data, len);
+			entry->len = len;
+			entry->generation = generation + 1;
+			entry->connect_id = connect_id;
+		}
+		pthread_mutex_unlock(&inst->lock);
+	}
+
+	if (resp_type == DISCOVER_ID_REQ)
+	{
+		union libtypec_discovered_identity *id = (void *)pd_msg_resp;
+		uint32_t vdo[7];
+
+		for (int i = 0; i < 7; i++)
+			vdo[i] = data[4 * i] | data[4 * i + 1] << 8 | data[4 * i + 2] << 16 | (uint32_t)data[4 * i + 3] << 24;
+
+		/* The response starts with the VDM header, the ID header follows */
+		id->disc_id.id_header = vdo[1];
+		id->disc_id.cert_stat = vdo[2];
+		id->disc_id.product = vdo[3];
+		id->disc_id.product_type_vdo1 = vdo[4];
+		id->disc_id.product_type_vdo2 = vdo[5];
+		id->disc_id.product_type_vdo3 = vdo[6];
+
+		return 0;
+	}
+
+	if (num_bytes > len)
+		num_bytes = len;
+	memcpy(pd_msg_resp, data, num_bytes);
+
+	return num_bytes;
+}
+
+/**
+ * This function shall be used to get how long the calling thread waited
+ * for UCSI debugfs transactions issued by other threads and processes
+ *
+ * \param stats Filled with the calling thread's totals
+ *
+ * \param reset Set to TRUE to start counting again from zero
+ *
+ * \returns 0 on success
+ */
+int libtypec_get_ucsi_wait_stats(struct libtypec_ucsi_wait_stats *stats, int reset)
+{
+	if (!stats)
+		return -EINVAL;
+
+	*stats = ucsi_wait_stats;
+	if (reset)
+		memset(&ucsi_wait_stats, 0, sizeof(ucsi_wait_stats));
+
+	return 0;
+}
+
 const struct libtypec_os_backend libtypec_lnx_dbgfs_backend = {
 	.init = libtypec_dbgfs_init,
 	.exit = libtypec_dbgfs_exit,
 	.get_capability_ops = libtypec_dbgfs_get_capability_ops,
 	.get_conn_capability_ops = libtypec_dbgfs_get_conn_capability_ops,
 	.get_alternate_modes = libtypec_dbgfs_get_alternate_modes,
-	.get_cam_supported_ops = NULL,
-	.get_current_cam_ops = NULL,
+	.get_cam_supported_ops = libtypec_dbgfs_get_cam_supported_ops,
+	.get_current_cam_ops = libtypec_dbgfs_get_current_cam_ops,
 	.get_pdos_ops = libtypec_dbgfs_get_pdos_ops,
-	.get_cable_properties_ops = NULL,
-	.get_connector_status_ops = NULL,
-	.get_pd_message_ops = NULL,
+	.get_cable_properties_ops = libtypec_dbgfs_get_cable_properties_ops,
+	.get_connector_status_ops = libtypec_dbgfs_get_connector_status_ops,
+	.get_pd_message_ops = libtypec_dbgfs_get_pd_message_ops,
 	.get_bb_status = NULL,
 	.get_bb_data = NULL,
+	.monitor_events = libtypec_lnx_monitor_udev_events,
 };
@@ -0,0 +1,657 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_decode.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Field level decoding of USB PD VDOs and PDOs
+ *
+ * Decoders are selected by USB PD revision and object type. Decoding
+ * writes into caller provided arrays and never allocates.
+ */
+
+#include "libtypec.h"
+#include "libtypec_decode_fields.h"
+#include <string.h>
+#include <errno.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__SSE4_1__)
+#include <smmintrin.h>
+#endif
+
+/*
+ * One decoder is generated per object from libtypec_decode_fields.h. Shifts,
+ * masks and name lengths are constants, reserved fields generate no code
+ * and every decoder writes all its fields, so there is no loop and no
+ * per-field test. Decoders need room for LIBTYPEC_VDO_MAX_FIELDS fields.
+ */
+typedef int (*decode_fn)(uint32_t obj, struct libtypec_vdo_field *fields);
+
+#define DECODE_FIELD(fname, fshift, fmask) \
+	f->name = fname; \
+	f->name_len = sizeof(fname) - 1; \
+	f->desc = NULL; \
+	f->value = (obj >> (fshift)) & (fmask); \
+	f->shift = fshift; \
+	f->mask = fmask; \
+	f++;
+
+#define DECODE_ENUM(fname, fshift, fmask, ...) \
+	{ \
+		static const char *const desc[LIBTYPEC_VDO_MAX_FIELDS] = { __VA_ARGS__ }; \
+		_Static_assert((fmask) < LIBTYPEC_VDO_MAX_FIELDS, fname " has too many values"); \
+		DECODE_FIELD(fname, fshift, fmask) \
+		f[-1].desc = desc[f[-1].value]; \
+	}
+
+#define DECODE_RESERVED(fname, fshift, fmask)
+
+#define DECODE_UNIT(fname, fshift, fmask, quantity, scale) DECODE_FIELD(fname, fshift, fmask)
+
+#define COUNT_FIELD(...) + 1
+#define COUNT_RESERVED(...)
+
+#define DEFINE_DECODER(object, FIELDS) \
+	_Static_assert(0 FIELDS(COUNT_FIELD, COUNT_FIELD, COUNT_RESERVED, COUNT_FIELD) <= LIBTYPEC_VDO_MAX_FIELDS, #object " has too many fields"); \
+	static int decode_##object(uint32_t obj, struct libtypec_vdo_field *fields) \
+	{ \
+		struct libtypec_vdo_field *f = fields; \
+		FIELDS(DECODE_FIELD, DECODE_ENUM, DECODE_RESERVED, DECODE_UNIT) \
+		return f - fields; \
+	}
+
+LIBTYPEC_DECODE_OBJECTS(DEFINE_DECODER)
+
+// ID Header product type masks
+#define PD_UFP_PRODUCT_TYPE_MASK 0x38000000
+#define PD_DFP_PRODUCT_TYPE_MASK 0x03800000
+
+#define PD2P0_PASSIVE_CABLE 0x20000000
+#define PD2P0_ACTIVE_CABLE 0x18000000
+#define PD2P0_AMA 0x28000000
+#define PD3P0_PASSIVE_CABLE 0x18000000
+#define PD3P0_ACTIVE_CABLE 0x20000000
+#define PD3P0_AMA 0x28000000
+#define PD3P0_VPD 0x30000000
+#define PD3P0_HUB 0x08000000
+#define PD3P0_PERIPHERAL 0x10000000
+#define PD3P0_DFP_HUB 0x00800000
+#define PD3P0_DFP_HOST 0x01000000
+#define PD3P0_POWER_BRICK 0x01800000
+#define PD3P1_PASSIVE_CABLE 0x18000000
+#define PD3P1_ACTIVE_CABLE 0x20000000
+#define PD3P1_VPD 0x30000000
+#define PD3P1_HUB 0x08000000
+#define PD3P1_PERIPHERAL 0x10000000
+#define PD3P1_DFP_HUB 0x00800000
+#define PD3P1_DFP_HOST 0x01000000
+#define PD3P1_POWER_BRICK 0x01800000
+
+enum decode_revision
+{
+	DECODE_PD2P0,
+	DECODE_PD3P0,
+	DECODE_PD3P1,
+	DECODE_REV_COUNT
+};
+
+static const decode_fn vdo_decoders[DECODE_REV_COUNT][LIBTYPEC_VDO_TYPE_COUNT] = {
+	[DECODE_PD2P0] = {
+		[LIBTYPEC_VDO_ID_HEADER_PARTNER] = decode_pd2p0_partner_id_header,
+		[LIBTYPEC_VDO_ID_HEADER_CABLE] = decode_pd2p0_cable_id_header,
+		[LIBTYPEC_VDO_CERT_STAT] = decode_pd2p0_cert_stat,
+		[LIBTYPEC_VDO_PRODUCT] = decode_pd2p0_product,
+		[LIBTYPEC_VDO_PASSIVE_CABLE] = decode_pd2p0_passive_cable,
+		[LIBTYPEC_VDO_ACTIVE_CABLE1] = decode_pd2p0_active_cable,
+		[LIBTYPEC_VDO_AMA] = decode_pd2p0_ama,
+	},
+	[DECODE_PD3P0] = {
+		[LIBTYPEC_VDO_ID_HEADER_PARTNER] = decode_pd3p0_partner_id_header,
+		[LIBTYPEC_VDO_ID_HEADER_CABLE] = decode_pd3p0_cable_id_header,
+		[LIBTYPEC_VDO_CERT_STAT] = decode_pd3p0_cert_stat,
+		[LIBTYPEC_VDO_PRODUCT] = decode_pd3p0_product,
+		[LIBTYPEC_VDO_PASSIVE_CABLE] = decode_pd3p0_passive_cable,
+		[LIBTYPEC_VDO_ACTIVE_CABLE1] = decode_pd3p0_active_cable_vdo1,
+		[LIBTYPEC_VDO_ACTIVE_CABLE2] = decode_pd3p0_active_cable_vdo2,
+		[LIBTYPEC_VDO_AMA] = decode_pd3p0_ama,
+		[LIBTYPEC_VDO_VPD] = decode_pd3p0_vpd,
+		[LIBTYPEC_VDO_UFP1] = decode_pd3p0_ufp_vdo1,
+		[LIBTYPEC_VDO_UFP2] = decode_pd3p0_ufp_vdo2,
+		[LIBTYPEC_VDO_DFP] = decode_pd3p0_dfp,
+	},
+	[DECODE_PD3P1] = {
+		[LIBTYPEC_VDO_ID_HEADER_PARTNER] = decode_pd3p1_partner_id_header,
+		[LIBTYPEC_VDO_ID_HEADER_CABLE] = decode_pd3p1_cable_id_header,
+		[LIBTYPEC_VDO_CERT_STAT] = decode_pd3p1_cert_stat,
+		[LIBTYPEC_VDO_PRODUCT] = decode_pd3p1_product,
+		[LIBTYPEC_VDO_PASSIVE_CABLE] = decode_pd3p1_passive_cable,
+		[LIBTYPEC_VDO_ACTIVE_CABLE1] = decode_pd3p1_active_cable_vdo1,
+		[LIBTYPEC_VDO_ACTIVE_CABLE2] = decode_pd3p1_active_cable_vdo2,
+		[LIBTYPEC_VDO_VPD] = decode_pd3p1_vpd,
+		[LIBTYPEC_VDO_UFP1] = decode_pd3p1_ufp,
+		[LIBTYPEC_VDO_DFP] = decode_pd3p1_dfp,
+	},
+};
+
+/* Alternate mode VDOs are defined by their SVID owner, not the PD revision */
+static const decode_fn altmode_decoders[LIBTYPEC_VDO_TYPE_COUNT] = {
+	[LIBTYPEC_VDO_DP_PARTNER] = decode_dp_alt_mode_partner,
+	[LIBTYPEC_VDO_DP_CABLE] = decode_dp_alt_mode_active_cable,
+	[LIBTYPEC_VDO_TBT3_SOP] = decode_tbt3_sop,
+	[LIBTYPEC_VDO_TBT3_SOP_PR] = decode_tbt3_sop_pr,
+};
+
+/* Indexed by revision, then src_snk << 2 | the PDO type in bits 31:30 */
+#define PDO_SNK(type) (type)
+#define PDO_SRC(type) (4 | (type))
+
+static const decode_fn pdo_decoders[DECODE_REV_COUNT][8] = {
+	[DECODE_PD2P0] = {
+		[PDO_SNK(PDO_FIXED)] = decode_pd2p0_fixed_supply_snk,
+		[PDO_SNK(PDO_BATTERY)] = decode_pd2p0_battery_supply_snk,
+		[PDO_SNK(PDO_VARIABLE)] = decode_pd2p0_variable_supply_snk,
+		[PDO_SRC(PDO_FIXED)] = decode_pd2p0_fixed_supply_src,
+		[PDO_SRC(PDO_BATTERY)] = decode_pd2p0_battery_supply_src,
+		[PDO_SRC(PDO_VARIABLE)] = decode_pd2p0_variable_supply_src,
+	},
+	[DECODE_PD3P0] = {
+		[PDO_SNK(PDO_FIXED)] = decode_pd3p0_fixed_supply_snk,
+		[PDO_SNK(PDO_BATTERY)] = decode_pd3p0_battery_supply_snk,
+		[PDO_SNK(PDO_VARIABLE)] = decode_pd3p0_variable_supply_snk,
+		[PDO_SNK(PDO_AUGMENTED)] = decode_pd3p0_pps_apdo_snk,
+		[PDO_SRC(PDO_FIXED)] = decode_pd3p0_fixed_supply_src,
+		[PDO_SRC(PDO_BATTERY)] = decode_pd3p0_battery_supply_src,
+		[PDO_SRC(PDO_VARIABLE)] = decode_pd3p0_variable_supply_src,
+		[PDO_SRC(PDO_AUGMENTED)] = decode_pd3p0_pps_apdo_src,
+	},
+	[DECODE_PD3P1] = {
+		[PDO_SNK(PDO_FIXED)] = decode_pd3p1_fixed_supply_snk,
+		[PDO_SNK(PDO_BATTERY)] = decode_pd3p1_battery_supply_snk,
+		[PDO_SNK(PDO_VARIABLE)] = decode_pd3p1_variable_supply_snk,
+		[PDO_SNK(PDO_AUGMENTED)] = decode_pd3p1_pps_apdo_snk,
+		[PDO_SRC(PDO_FIXED)] = decode_pd3p1_fixed_supply_src,
+		[PDO_SRC(PDO_BATTERY)] = decode_pd3p1_battery_supply_src,
+		[PDO_SRC(PDO_VARIABLE)] = decode_pd3p1_variable_supply_src,
+		[PDO_SRC(PDO_AUGMENTED)] = decode_pd3p1_pps_apdo_src,
+	},
+};
+
+static int decode_revision(unsigned short revision)
+{
+	switch (revision)
+	{
+	case 0x200:
+		return DECODE_PD2P0;
+	case 0x300:
+		return DECODE_PD3P0;
+	case 0x310:
+		return DECODE_PD3P1;
+	default:
+		return -1;
+	}
+}
+
+static int decode(decode_fn fn, uint32_t obj, struct libtypec_vdo_field *fields, int max_fields)
+{
+	struct libtypec_vdo_field scratch[LIBTYPEC_VDO_MAX_FIELDS];
+	int num;
+
+	if (!fn)
+		return -EINVAL;
+
+	if (max_fields >= LIBTYPEC_VDO_MAX_FIELDS)
+		return fn(obj, fields);
+
+	num = fn(obj, scratch);
+	if (max_fields > 0)
+		memcpy(fields, scratch, (num < max_fields ? num : max_fields) * sizeof(*fields));
+
+	return num;
+}
+
+/**
+ * Decodes one VDO into its fields. Reserved fields are skipped.
+ *
+ * \param revision USB PD revision the VDO was sent with (0x200, 0x300 or
+ *        0x310), ignored for alternate mode VDOs
+ * \param type Object the VDO holds
+ * \param vdo Raw VDO
+ * \param fields Filled with up to max_fields decoded fields
+ * \param max_fields Size of fields
+ *
+ * \returns Number of fields the VDO decodes to, which may exceed
+ *          max_fields, or -EINVAL when the revision has no such object
+ */
+int libtypec_decode_vdo(unsigned short revision, enum libtypec_vdo_type type, uint32_t vdo, struct libtypec_vdo_field *fields, int max_fields)
+{
+	int rev;
+
+	if (type < 0 || type >= LIBTYPEC_VDO_TYPE_COUNT)
+		return -EINVAL;
+
+	if (altmode_decoders[type])
+		return decode(altmode_decoders[type], vdo, fields, max_fields);
+
+	rev = decode_revision(revision);
+	if (rev < 0)
+		return -EINVAL;
+
+	return decode(vdo_decoders[rev][type], vdo, fields, max_fields);
+}
+
+/**
+ * Decodes one PDO into its fields, choosing the decoder from the PDO type
+ * in bits 31:30. Reserved fields are skipped.
+ *
+ * \param revision USB PD revision of the port that sent the PDO
+ * \param src_snk 1 for a source PDO, 0 for a sink PDO
+ * \param pdo Raw PDO
+ * \param fields Filled with up to max_fields decoded fields
+ * \param max_fields Size of fields
+ *
+ * \returns Number of fields the PDO decodes to, which may exceed
+ *          max_fields, or -EINVAL when the revision does not define the
+ *          PDO type
+ */
+int libtypec_decode_pdo(unsigned short revision, int src_snk, uint32_t pdo, struct libtypec_vdo_field *fields, int max_fields)
+{
+	int rev = decode_revision(revision);
+
+	if (rev < 0)
+		return -EINVAL;
+
+	return decode(pdo_decoders[rev][(src_snk ? 4 : 0) | pdo >> 30], pdo, fields, max_fields);
+}
+
+/*
+ * Batch decoding works on blocks small enough to stay in L1 while every
+ * field is extracted from them, four objects per SSE2 instruction.
+ */
+#define BATCH_BLOCK 1024
+
+#if defined(__SSE2__)
+static inline __m128i mullo_epi32(__m128i a, __m128i b)
+{
+#if defined(__SSE4_1__)
+	return _mm_mullo_epi32(a, b);
+#else
+	__m128i even = _mm_mul_epu32(a, b);
+	__m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+
+	return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)),
+				  _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+#endif
+}
+#endif
+
+static void extract_field(const uint32_t *objs, size_t count, uint8_t shift, uint32_t mask, uint32_t *out)
+{
+	size_t i = 0;
+
+#if defined(__SSE2__)
+	__m128i cnt = _mm_cvtsi32_si128(shift);
+	__m128i m = _mm_set1_epi32(mask);
+
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128((const __m128i *)(objs + i));
+
+		_mm_storeu_si128((__m128i *)(out + i), _mm_and_si128(_mm_srl_epi32(v, cnt), m));
+	}
+#endif
+	for (; i < count; i++)
+		out[i] = (objs[i] >> shift) & mask;
+}
+
+/**
+ * Decodes an array of VDOs of one type into one array per field.
+ *
+ * \param revision USB PD revision the VDOs were sent with, ignored for
+ *        alternate mode VDOs
+ * \param type Object every VDO holds
+ * \param vdos Raw VDOs
+ * \param count Number of VDOs
+ * \param values values[n] receives field n of every VDO, in the order
+ *        libtypec_decode_vdo() reports the fields. NULL entries are skipped
+ * \param max_fields Size of values
+ *
+ * \returns Number of fields the VDO type decodes to, or -EINVAL when the
+ *          revision has no such object
+ */
+int libtypec_decode_vdo_batch(unsigned short revision, enum libtypec_vdo_type type, const uint32_t *vdos, size_t count,
+			      uint32_t *const *values, int max_fields)
+{
+	struct libtypec_vdo_field fields[LIBTYPEC_VDO_MAX_FIELDS];
+	int num;
+
+	/* The layout comes from the generated decoder itself */
+	num = libtypec_decode_vdo(revision, type, 0, fields, LIBTYPEC_VDO_MAX_FIELDS);
+	if (num < 0)
+		return num;
+
+	if (max_fields > num)
+		max_fields = num;
+
+	for (size_t base = 0; base < count; base += BATCH_BLOCK)
+	{
+		size_t n = count - base < BATCH_BLOCK ? count - base : BATCH_BLOCK;
+
+		for (int i = 0; i < max_fields; i++)
+		{
+			if (values[i])
+				extract_field(vdos + base, n, fields[i].shift, fields[i].mask, values[i] + base);
+		}
+	}
+
+	return num;
+}
+
+/*
+ * Where each PDO type keeps its values. Power is computed from the raw
+ * fields as (max voltage * current * power_mul) >> power_shift in mW,
+ * battery PDOs carry it directly in the current field.
+ */
+struct pdo_layout
+{
+	uint8_t cur_shift;
+	uint32_t cur_mask;
+	uint32_t cur_scale;
+	uint8_t min_shift;
+	uint32_t min_mask;
+	uint32_t min_scale;
+	uint8_t max_shift;
+	uint32_t max_mask;
+	uint32_t max_scale;
+	uint32_t power_mul;
+	uint8_t power_shift;
+	uint8_t battery;
+	uint32_t value_mask;
+};
+
+/*
+ * Layouts are generated from the U() fields of libtypec_decode_fields.h.
+ * LAYOUT_<quantity> sets the members a field provides, PDO_SCALE() sums
+ * the scale of the fields holding one quantity.
+ */
+enum pdo_quantity
+{
+	PDO_QUANTITY_CURRENT,
+	PDO_QUANTITY_POWER,
+	PDO_QUANTITY_VOLTAGE,
+	PDO_QUANTITY_MIN_VOLTAGE,
+	PDO_QUANTITY_MAX_VOLTAGE,
+};
+
+#define LAYOUT_CURRENT(fshift, fmask, scale) .cur_shift = fshift, .cur_mask = fmask, .cur_scale = scale,
+#define LAYOUT_POWER(fshift, fmask, scale) .cur_shift = fshift, .cur_mask = fmask, .battery = 1,
+#define LAYOUT_MIN_VOLTAGE(fshift, fmask, scale) .min_shift = fshift, .min_mask = fmask, .min_scale = scale,
+#define LAYOUT_MAX_VOLTAGE(fshift, fmask, scale) .max_shift = fshift, .max_mask = fmask, .max_scale = scale,
+#define LAYOUT_VOLTAGE(fshift, fmask, scale) LAYOUT_MIN_VOLTAGE(fshift, fmask, scale) LAYOUT_MAX_VOLTAGE(fshift, fmask, scale)
+
+#define LAYOUT_SKIP(...)
+#define LAYOUT_UNIT(fname, fshift, fmask, quantity, scale) LAYOUT_##quantity(fshift, fmask, scale)
+#define LAYOUT_MASK(fname, fshift, fmask, quantity, scale) | (uint32_t)(fmask) << (fshift)
+
+#define SCALE_CURRENT(fname, fshift, fmask, quantity, scale) + (PDO_QUANTITY_##quantity == PDO_QUANTITY_CURRENT ? (scale) : 0)
+#define SCALE_POWER(fname, fshift, fmask, quantity, scale) + (PDO_QUANTITY_##quantity == PDO_QUANTITY_POWER ? (scale) : 0)
+#define SCALE_MAX_VOLTAGE(fname, fshift, fmask, quantity, scale) \
+	+ (PDO_QUANTITY_##quantity == PDO_QUANTITY_VOLTAGE || PDO_QUANTITY_##quantity == PDO_QUANTITY_MAX_VOLTAGE ? (scale) : 0)
+#define PDO_SCALE(FIELDS, quantity) (0 FIELDS(LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_SKIP, SCALE_##quantity))
+
+/*
+ * mV * mA / 1000 is exact as a multiply by mV * mA / 125 and a shift by 3
+ * for every PD unit, battery PDOs take their power unit as is.
+ */
+#define PDO_POWER_PRODUCT(FIELDS) (PDO_SCALE(FIELDS, CURRENT) * PDO_SCALE(FIELDS, MAX_VOLTAGE))
+#define PDO_LAYOUT(FIELDS) \
+	{ \
+		FIELDS(LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_UNIT) \
+		.power_mul = PDO_SCALE(FIELDS, POWER) + PDO_POWER_PRODUCT(FIELDS) / 125, \
+		.power_shift = PDO_SCALE(FIELDS, POWER) ? 0 : 3, \
+		.value_mask = 0 FIELDS(LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_MASK), \
+	}
+
+#define PDO_LAYOUT_CHECK(SRC_FIELDS, SNK_FIELDS) \
+	_Static_assert(PDO_POWER_PRODUCT(SNK_FIELDS) % 125 == 0, #SNK_FIELDS " power is not exact"); \
+	_Static_assert((0 SRC_FIELDS(LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_MASK)) == \
+		       (0 SNK_FIELDS(LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_SKIP, LAYOUT_MASK)), #SRC_FIELDS " differs from its sink PDO")
+
+/* Source and sink PDOs of a type share the layout, taken from the sink PDO */
+PDO_LAYOUT_CHECK(PD2P0_FIXED_SUPPLY_SRC_FIELDS, PD2P0_FIXED_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD2P0_VARIABLE_SUPPLY_SRC_FIELDS, PD2P0_VARIABLE_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD2P0_BATTERY_SUPPLY_SRC_FIELDS, PD2P0_BATTERY_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P0_FIXED_SUPPLY_SRC_FIELDS, PD3P0_FIXED_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P0_VARIABLE_SUPPLY_SRC_FIELDS, PD3P0_VARIABLE_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P0_BATTERY_SUPPLY_SRC_FIELDS, PD3P0_BATTERY_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P0_PPS_APDO_SRC_FIELDS, PD3P0_PPS_APDO_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P1_FIXED_SUPPLY_SRC_FIELDS, PD3P1_FIXED_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P1_VARIABLE_SUPPLY_SRC_FIELDS, PD3P1_VARIABLE_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P1_BATTERY_SUPPLY_SRC_FIELDS, PD3P1_BATTERY_SUPPLY_SNK_FIELDS);
+PDO_LAYOUT_CHECK(PD3P1_PPS_APDO_SRC_FIELDS, PD3P1_PPS_APDO_SNK_FIELDS);
+
+static const struct pdo_layout pdo_layouts[DECODE_REV_COUNT][4] = {
+	[DECODE_PD2P0] = {
+		[PDO_FIXED] = PDO_LAYOUT(PD2P0_FIXED_SUPPLY_SNK_FIELDS),
+		[PDO_BATTERY] = PDO_LAYOUT(PD2P0_BATTERY_SUPPLY_SNK_FIELDS),
+		[PDO_VARIABLE] = PDO_LAYOUT(PD2P0_VARIABLE_SUPPLY_SNK_FIELDS),
+	},
+	[DECODE_PD3P0] = {
+		[PDO_FIXED] = PDO_LAYOUT(PD3P0_FIXED_SUPPLY_SNK_FIELDS),
+		[PDO_BATTERY] = PDO_LAYOUT(PD3P0_BATTERY_SUPPLY_SNK_FIELDS),
+		[PDO_VARIABLE] = PDO_LAYOUT(PD3P0_VARIABLE_SUPPLY_SNK_FIELDS),
+		[PDO_AUGMENTED] = PDO_LAYOUT(PD3P0_PPS_APDO_SNK_FIELDS),
+	},
+	[DECODE_PD3P1] = {
+		[PDO_FIXED] = PDO_LAYOUT(PD3P1_FIXED_SUPPLY_SNK_FIELDS),
+		[PDO_BATTERY] = PDO_LAYOUT(PD3P1_BATTERY_SUPPLY_SNK_FIELDS),
+		[PDO_VARIABLE] = PDO_LAYOUT(PD3P1_VARIABLE_SUPPLY_SNK_FIELDS),
+		[PDO_AUGMENTED] = PDO_LAYOUT(PD3P1_PPS_APDO_SNK_FIELDS),
+	},
+};
+
+static void pdo_batch_scalar(const struct pdo_layout *l, const uint32_t *pdos, size_t count, struct libtypec_pdo_batch *out, size_t i)
+{
+	for (; i < count; i++)
+	{
+		uint32_t pdo = pdos[i];
+		uint32_t cur = (pdo >> l->cur_shift) & l->cur_mask;
+		uint32_t max = (pdo >> l->max_shift) & l->max_mask;
+
+		if (out->current)
+			out->current[i] = cur * l->cur_scale;
+		if (out->min_voltage)
+			out->min_voltage[i] = ((pdo >> l->min_shift) & l->min_mask) * l->min_scale;
+		if (out->max_voltage)
+			out->max_voltage[i] = max * l->max_scale;
+		if (out->power)
+			out->power[i] = ((l->battery ? 1 : max) * cur * l->power_mul) >> l->power_shift;
+		if (out->flags)
+			out->flags[i] = pdo & ~l->value_mask;
+	}
+}
+
+#if defined(__SSE2__)
+static size_t pdo_batch_sse2(const struct pdo_layout *l, const uint32_t *pdos, size_t count, struct libtypec_pdo_batch *out)
+{
+	__m128i cur_cnt = _mm_cvtsi32_si128(l->cur_shift);
+	__m128i min_cnt = _mm_cvtsi32_si128(l->min_shift);
+	__m128i max_cnt = _mm_cvtsi32_si128(l->max_shift);
+	__m128i power_cnt = _mm_cvtsi32_si128(l->power_shift);
+	__m128i cur_mask = _mm_set1_epi32(l->cur_mask);
+	__m128i min_mask = _mm_set1_epi32(l->min_mask);
+	__m128i max_mask = _mm_set1_epi32(l->max_mask);
+	__m128i cur_scale = _mm_set1_epi32(l->cur_scale);
+	__m128i min_scale = _mm_set1_epi32(l->min_scale);
+	__m128i max_scale = _mm_set1_epi32(l->max_scale);
+	__m128i power_mul = _mm_set1_epi32(l->power_mul);
+	__m128i value_mask = _mm_set1_epi32(l->value_mask);
+	__m128i one = _mm_set1_epi32(1);
+	size_t i;
+
+	for (i = 0; i + 4 <= count; i += 4)
+	{
+		__m128i pdo = _mm_loadu_si128((const __m128i *)(pdos + i));
+		__m128i cur = _mm_and_si128(_mm_srl_epi32(pdo, cur_cnt), cur_mask);
+		__m128i max = _mm_and_si128(_mm_srl_epi32(pdo, max_cnt), max_mask);
+
+		if (out->current)
+			_mm_storeu_si128((__m128i *)(out->current + i), mullo_epi32(cur, cur_scale));
+		if (out->min_voltage)
+			_mm_storeu_si128((__m128i *)(out->min_voltage + i),
+					 mullo_epi32(_mm_and_si128(_mm_srl_epi32(pdo, min_cnt), min_mask), min_scale));
+		if (out->max_voltage)
+			_mm_storeu_si128((__m128i *)(out->max_voltage + i), mullo_epi32(max, max_scale));
+		if (out->power)
+			_mm_storeu_si128((__m128i *)(out->power + i),
+					 _mm_srl_epi32(mullo_epi32(mullo_epi32(l->battery ? one : max, cur), power_mul), power_cnt));
+		if (out->flags)
+			_mm_storeu_si128((__m128i *)(out->flags + i), _mm_andnot_si128(value_mask, pdo));
+	}
+
+	return i;
+}
+#endif
+
+/**
+ * Decodes an array of PDOs of one type into physical units, one array per
+ * quantity. Source and sink PDOs share the layout of their type.
+ *
+ * \param revision USB PD revision of the port that sent the PDOs
+ * \param type PDO type shared by every PDO (PDO_FIXED, PDO_BATTERY,
+ *        PDO_VARIABLE, or PDO_AUGMENTED for PPS APDOs)
+ * \param pdos Raw PDOs
+ * \param count Number of PDOs
+ * \param out Arrays of count entries to fill, NULL members are skipped
+ *
+ * \returns 0 on success, -EINVAL when the revision does not define the
+ *          PDO type
+ */
+int libtypec_decode_pdo_batch(unsigned short revision, int type, const uint32_t *pdos, size_t count, struct libtypec_pdo_batch *out)
+{
+	int rev = decode_revision(revision);
+	size_t i = 0;
+
+	if (rev < 0 || type < PDO_FIXED || type > PDO_AUGMENTED || !pdo_decoders[rev][PDO_SNK(type)])
+		return -EINVAL;
+
+#if defined(__SSE2__)
+	i = pdo_batch_sse2(&pdo_layouts[rev][type], pdos, count, out);
+#endif
+	pdo_batch_scalar(&pdo_layouts[rev][type], pdos, count, out, i);
+
+	return 0;
+}
+
+/**
+ * Classifies a cable from its Discover Identity ID Header.
+ *
+ * \param revision USB PD revision of the cable
+ * \param id_header ID Header VDO
+ *
+ * \returns The product type, LIBTYPEC_PRODUCT_TYPE_OTHER when not decodable
+ */
+enum libtypec_product_type libtypec_get_cable_product_type(unsigned short revision, uint32_t id_header)
+{
+	uint32_t ufp = id_header & PD_UFP_PRODUCT_TYPE_MASK;
+
+	switch (revision)
+	{
+	case 0x200:
+		if (ufp == PD2P0_PASSIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD2P0_PASSIVE_CABLE;
+		if (ufp == PD2P0_ACTIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD2P0_ACTIVE_CABLE;
+		break;
+	case 0x300:
+		if (ufp == PD3P0_PASSIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_PASSIVE_CABLE;
+		if (ufp == PD3P0_ACTIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_ACTIVE_CABLE;
+		break;
+	case 0x310:
+		if (ufp == PD3P1_PASSIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_PASSIVE_CABLE;
+		if (ufp == PD3P1_ACTIVE_CABLE)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_ACTIVE_CABLE;
+		if (ufp == PD3P1_VPD)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_VPD;
+		break;
+	}
+
+	return LIBTYPEC_PRODUCT_TYPE_OTHER;
+}
+
+/**
+ * Classifies a port partner from its Discover Identity ID Header.
+ *
+ * \param revision USB PD revision of the partner
+ * \param id_header ID Header VDO
+ *
+ * \returns The product type, LIBTYPEC_PRODUCT_TYPE_OTHER when not decodable
+ */
+enum libtypec_product_type libtypec_get_partner_product_type(unsigned short revision, uint32_t id_header)
+{
+	uint32_t ufp = id_header & PD_UFP_PRODUCT_TYPE_MASK;
+	uint32_t dfp = id_header & PD_DFP_PRODUCT_TYPE_MASK;
+	int ufp_supported, dfp_supported;
+
+	switch (revision)
+	{
+	case 0x200:
+		return ufp == PD2P0_AMA ? LIBTYPEC_PRODUCT_TYPE_PD2P0_AMA : LIBTYPEC_PRODUCT_TYPE_OTHER;
+	case 0x300:
+		if (ufp == PD3P0_AMA)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_AMA;
+		if (ufp == PD3P0_VPD)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_VPD;
+
+		ufp_supported = ufp == PD3P0_HUB || ufp == PD3P0_PERIPHERAL;
+		dfp_supported = dfp == PD3P0_DFP_HUB || dfp == PD3P0_DFP_HOST || dfp == PD3P0_POWER_BRICK;
+
+		if (ufp_supported && dfp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_DRD;
+		if (ufp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_UFP;
+		if (dfp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P0_DFP;
+		break;
+	case 0x310:
+		ufp_supported = ufp == PD3P1_HUB || ufp == PD3P1_PERIPHERAL;
+		dfp_supported = dfp == PD3P1_DFP_HUB || dfp == PD3P1_DFP_HOST || dfp == PD3P1_POWER_BRICK;
+
+		if (ufp_supported && dfp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_DRD;
+		if (ufp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_UFP;
+		if (dfp_supported)
+			return LIBTYPEC_PRODUCT_TYPE_PD3P1_DFP;
+		break;
+	}
+
+	return LIBTYPEC_PRODUCT_TYPE_OTHER;
+}
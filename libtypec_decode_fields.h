@@ -0,0 +1,675 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_decode_fields.h
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief USB PD VDO and PDO field definitions
+ *
+ * Every object is an X-macro listing its fields from bit 0 upwards. The
+ * caller supplies four macros, each taking the field name, shift and
+ * mask:
+ *   F(name, shift, mask)        field reported as a plain number
+ *   E(name, shift, mask, ...)   enumerated field, followed by the name of
+ *                               every value
+ *   R(name, shift, mask)        reserved or unreported field
+ *   U(name, shift, mask, quantity, scale)
+ *                               PDO field reported as a plain number that
+ *                               holds quantity in units of scale: CURRENT
+ *                               in mA, POWER in mW, or VOLTAGE (fixed
+ *                               supplies), MIN_VOLTAGE and MAX_VOLTAGE in mV
+ *
+ * LIBTYPEC_DECODE_OBJECTS(T) lists every object as T(name, FIELDS_FIELDS).
+ */
+
+#ifndef LIBTYPEC_DECODE_FIELDS_H
+#define LIBTYPEC_DECODE_FIELDS_H
+
+// USB PD 2.0 ID Header VDO (Section 6.4.4.3.1.1)
+#define PD2P0_PARTNER_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x3ff) \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Produt Type (UFP)", 27, 0x7, "Undefined", "PDUSB Hub", "PDUSB Peripheral", "Reserved", "Reserved", "Alternate Mode Adapter", "Reserved", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+#define PD2P0_CABLE_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x3ff) \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Produt Type (UFP)", 27, 0x7, "Undefined", "Reserved", "Reserved", "Passive Cable", "Active Cable", "Reserved", "Reserved", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+// USB PD 2.0 Cert Stat VDO (Section 6.4.4.3.1.2)
+#define PD2P0_CERT_STAT_FIELDS(F, E, R, U) \
+	F("XID", 0, 0xffffffff)
+
+// USB PD 2.0 Product VDO (Section 6.4.4.3.1.3)
+#define PD2P0_PRODUCT_FIELDS(F, E, R, U) \
+	F("bcdDevice", 0, 0xffff) \
+	F("USB Product ID", 16, 0xffff)
+
+// USB PD 2.0 Passive Cable VDO (Section 6.4.4.3.1.4.1)
+#define PD2P0_PASSIVE_CABLE_FIELDS(F, E, R, U) \
+	E("USB SuperSpeed Support", 0, 0x7, "USB 2.0 Only", "USB 3.1 Gen1", "USB 3.1 Gen1 and Gen2", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 3, 0x1) \
+	E("Vbus Through Cable", 4, 0x1, "No", "Yes") \
+	E("Vbus Current Handling", 5, 0x3, "Reserved", "3A", "5A", "Reserved") \
+	E("SSRX2 Support", 7, 0x1, "Fixed", "Configurable") \
+	E("SSRX1 Support", 8, 0x1, "Fixed", "Configurable") \
+	E("SSTX2 Support", 9, 0x1, "Fixed", "Configurable") \
+	E("SSTX1 Support", 10, 0x1, "Fixed", "Configurable") \
+	E("Cable Termination Type", 11, 0x3, "Vconn Not Required", "Vconn Required", "Reserved", "Reserved") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", " 70ns (>~7m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 17, 0x1) \
+	E("USB Type-C plug to", 18, 0x3, "USB Type-A", "USB Type-B", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0xf) \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 2.0 Active Cable VDO (Section 6.4.4.3.1.4.2)
+#define PD2P0_ACTIVE_CABLE_FIELDS(F, E, R, U) \
+	E("USB SuperSpeed Support", 0, 0x7, "USB 2.0 Only", "USB 3.1 Gen1", "USB 3.1 Gen1 and Gen2", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("SOP'' Controller Present", 3, 0x1) \
+	E("Vbus Through Cable", 4, 0x1, "No", "Yes") \
+	E("Vbus Current Handling", 5, 0x3, "Reserved", "3A", "5A", "Reserved") \
+	E("SSRX2 Support", 7, 0x1, "Fixed", "Configurable") \
+	E("SSRX1 Support", 8, 0x1, "Fixed", "Configurable") \
+	E("SSTX2 Support", 9, 0x1, "Fixed", "Configurable") \
+	E("SSTX1 Support", 10, 0x1, "Fixed", "Configurable") \
+	E("Cable Termination Type", 11, 0x3, "Vconn Not Required", "Vconn Required", "Reserved", "Reserved") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", " 70ns (>~7m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 17, 0x1) \
+	E("USB Type-C plug to", 18, 0x3, "USB Type-A", "USB Type-B", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0xf) \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 2.0 AMA VDO (Section 6.4.4.3.1.5)
+#define PD2P0_AMA_FIELDS(F, E, R, U) \
+	E("USB SuperSpeed Support", 0, 0x7, "USB 2.0 Only", "USB 3.1 Gen1", "USB 3.1 Gen1 and Gen2", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("Vbus required", 3, 0x1, "No", "Yes") \
+	E("Vconn required", 4, 0x1, "No", "Yes") \
+	E("Vconn power", 5, 0x7, "1W", "1.5W", "2W", "3W", "4W", "5W", "6W", "Reserved") \
+	E("SSRX2 Support", 8, 0x1, "Fixed", "Configurable") \
+	E("SSRX1 Support", 9, 0x1, "Fixed", "Configurable") \
+	E("SSTX2 Support", 10, 0x1, "Fixed", "Configurable") \
+	E("SSTX1 Support", 11, 0x1, "Fixed", "Configurable") \
+	R("Reserved", 12, 0xfff) \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 2.0 Fixed Supply PDO - Source (Section 6.4.1.2.3)
+#define PD2P0_FIXED_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	F("Peak Current", 20, 0x3) \
+	R("Reserved", 22, 0x7) \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("USB Suspend Supported", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 2.0 Variable Supply PDO - Source (Section 6.4.1.2.4)
+#define PD2P0_VARIABLE_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 2.0 Battery Supply PDO - Source (Section 6.4.1.2.5)
+#define PD2P0_BATTERY_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Allowable Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 2.0 Fixed Supply PDO - Sink (Section 6.4.1.3.1)
+#define PD2P0_FIXED_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	R("Reserved", 20, 0x1f) \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("Higher Capability", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 2.0 Variable Supply PDO - Sink (Section 6.4.1.3.2)
+#define PD2P0_VARIABLE_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 2.0 Battery Supply PDO - Sink (Section 6.4.1.3.3)
+#define PD2P0_BATTERY_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 3.0 ID Header VDO (Section 6.4.4.3.1.1)
+#define PD3P0_PARTNER_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x3f) \
+	E("Product Type (DFP)", 23, 0x7, "Undefined", "PDUSB Hub", "PDUSB Host", "Power Brick", "Alternate Mode Controller", "Reserved", "Reserved", "Reserved") \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Product Type (UFP)", 27, 0x7, "Undefined", "PDUSB Hub", "PDUSB Peripheral", "PSD", "Reserved", "Alternate Mode Adapter", "Vconn Powered USB Device", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+#define PD3P0_CABLE_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x3f) \
+	R("Product Type (DFP)", 23, 0x7) \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Product Type (Cable Plug)", 27, 0x7, "Undefined", "Reserved", "Reserved", "Passive Cable", "Active Cable", "Reserved", "Reserved", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+// USB PD 3.0 Cert Stat VDO (Section 6.4.4.3.1.2)
+#define PD3P0_CERT_STAT_FIELDS(F, E, R, U) \
+	F("XID", 0, 0xffffffff)
+
+// USB PD 3.0 Product VDO (Section 6.4.4.3.1.3)
+#define PD3P0_PRODUCT_FIELDS(F, E, R, U) \
+	F("bcdDevice", 0, 0xffff) \
+	F("USB Product ID", 16, 0xffff)
+
+// USB PD 3.0 Passive Cable VDO (Section 6.4.4.3.1.6)
+#define PD3P0_PASSIVE_CABLE_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 Only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 3, 0x3) \
+	E("Vbus Current Handling", 5, 0x3, "Reserved", "3A", "5A", "Reserved") \
+	R("Reserved", 7, 0x3) \
+	E("Maximum Vbus Voltage", 9, 0x3, "20V", "30V", "40V", "50V") \
+	E("Cable Termination Type", 11, 0x3, "Vconn Not Required", "Vconn Required", "Reserved", "Reserved") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", " 70ns (>~7m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 17, 0x1) \
+	E("Connector Type", 18, 0x3, "Reserved", "Reserved", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0x1) \
+	E("VDO version", 21, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 3.0 Active Cable VDO1/VDO2 (Section 6.4.4.3.1.7)
+#define PD3P0_ACTIVE_CABLE_VDO1_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 Only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("SOP'' Controller Present", 3, 0x1, "No", "Yes") \
+	E("Vbus Through Cable", 4, 0x1, "No", "Yes") \
+	E("Vbus Current Handling", 5, 0x3, "USB Type-C Default Current", "3A", "5A", "Reserved") \
+	E("SBU Type", 7, 0x1, "SBU is passive", "SBU is active") \
+	E("SBU Supported", 8, 0x1, "SBU connections supported", "SBU connections are not supported") \
+	E("Maximum Vbus Voltage", 9, 0x3, "20V", "30V", "40V", "50V") \
+	E("Cable Termination Type", 11, 0x3, "Reserved", "Reserved", "One end active, one end passive, Vconn required", "Both ends active, Vconn required") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", "1000b –1000ns (~100m)", "1001b –2000ns (~200m)", "1010b – 3000ns (~300m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 17, 0x1) \
+	E("Connector Type", 18, 0x3, "Reserved", "Reserved", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0x1) \
+	E("VDO version", 21, 0x7, "Reserved", "Reserved", "Reserved", "Version 1.3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+#define PD3P0_ACTIVE_CABLE_VDO2_FIELDS(F, E, R, U) \
+	E("USB Gen", 0, 0x1, "Gen 1", "Gen 2 or higher") \
+	R("Reserved", 1, 0x1) \
+	E("Optically Isolated Active Cable", 2, 0x1, "No", "Yes") \
+	E("USB Lanes Supported", 3, 0x1, "One Lane", "Two Lanes") \
+	E("USB 3.2 Supported", 4, 0x1, "USB 3.2 SuperSpeed supported", "USB 3.2 SuperSpeed not supported") \
+	E("USB 2.0 Supported", 5, 0x1, "USB 2.0 supported", "USB 2.0 not supported") \
+	F("USB 2.0 Hub Hops Consumed", 6, 0x3) \
+	E("USB4 Supported", 8, 0x1, "USB4 Supported", "USB4 Not Supported") \
+	E("Active element", 9, 0x1, "Active Redriver", "Active Retimer") \
+	E("Physical connection", 10, 0x1, "Copper", "Optical") \
+	E("U3 to U0 transition mode", 11, 0x1, "U3 to U0 direct", "U3 to U0 through U35") \
+	E("U3/Cld Power", 12, 0x7, ">10mW", "5-10mW", "1-5mW", "0.5-1mW", "0.2-0.5mW", "50-200uW", "<50uW", "Reserved") \
+	R("Reserved", 15, 0x1) \
+	F("Shutdown Temperature", 16, 0xff) \
+	F("Maximum Operating Temperature", 24, 0xff)
+
+// USB PD 3.0 AMA VDO (Section 6.4.4.3.1.8)
+#define PD3P0_AMA_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 only", "USB 3.2 Gen1 and USB 2.0", "USB 3.2 Gen1, Gen2 and USB 2.0", "billboard only", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("Vbus required", 3, 0x1, "No", "Yes") \
+	E("Vconn required", 4, 0x1, "No", "Yes") \
+	E("Vconn power", 5, 0x7, "1W", "1.5W", "2W", "3W", "4W", "5W", "6W", "Reserved") \
+	R("Reserved", 8, 0x1fff) \
+	E("VDO Version", 21, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 3.0 VPD VDO (Section 6.4.4.3.1.9)
+#define PD3P0_VPD_FIELDS(F, E, R, U) \
+	E("Charge Through Support", 0, 0x1, "No", "Yes") \
+	F("Ground Impedance", 1, 0x3f) \
+	F("Vbus Impedance", 7, 0x3f) \
+	R("Reserved", 13, 0x3) \
+	E("Charge Through Current Support", 14, 0x1, "3A capable", "5A capable") \
+	E("Maximum Vbus Voltage", 15, 0x3, "20V", "30V", "40V", "50V") \
+	R("Reserved", 17, 0xf) \
+	E("VDO Version", 21, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 3.0 UFP VDO1/VDO2 (Section 6.4.4.3.1.4)
+#define PD3P0_UFP_VDO1_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Alternate Modes", 3, 0x7) \
+	R("Reserved", 6, 0x3ffff) \
+	F("Device Capability", 24, 0xf) \
+	R("Reserved", 28, 0x1) \
+	E("UFP VDO Version", 29, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved")
+
+#define PD3P0_UFP_VDO2_FIELDS(F, E, R, U) \
+	F("USB3 Max Power", 0, 0x7f) \
+	F("USB3 Min Power", 7, 0x7f) \
+	R("Reserved", 14, 0x3) \
+	F("USB4 Max Power", 16, 0x7f) \
+	F("USB4 Min Power", 23, 0x7f) \
+	R("Reserved", 30, 0x3)
+
+// USB PD 3.0 DFP VDO (Section 6.4.4.3.1.5)
+#define PD3P0_DFP_FIELDS(F, E, R, U) \
+	F("Port Number", 0, 0x1f) \
+	R("Reserved", 5, 0x7ffff) \
+	F("Host Capability", 24, 0x7) \
+	R("Reserved", 27, 0x3) \
+	E("DFP VDO Version", 29, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved")
+
+// USB PD 3.0 Fixed Supply PDO - Source (Section 6.4.1.2.2)
+#define PD3P0_FIXED_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	F("Peak Current", 20, 0x3) \
+	R("Reserved", 22, 0x3) \
+	R("Unchunked Extended Messages Supported", 24, 0x1) \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("USB Suspend Supported", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 3.0 Variable Supply PDO - Source (Section 6.4.1.2.3)
+#define PD3P0_VARIABLE_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 3.0 Battery Supply PDO - Source (Section 6.4.1.2.4)
+#define PD3P0_BATTERY_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Allowable Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 3.0 PPS APDO - Source (Section 6.4.1.2.5)
+#define PD3P0_PPS_APDO_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 50mA increments", 0, 0x7f, CURRENT, 50) \
+	R("Reserved", 7, 0x0) \
+	U("Minimum Voltage in 100mV increments", 8, 0xff, MIN_VOLTAGE, 100) \
+	R("Reserved", 16, 0x0) \
+	U("Maximum Voltage in 100mV increments", 17, 0xff, MAX_VOLTAGE, 100) \
+	R("Reserved", 25, 0x0) \
+	F("PPS Power Limited", 27, 0x1) \
+	F("Programable Power Supply", 28, 0x3) \
+	F("Augmented Power Data Object", 30, 0x3)
+
+// USB PD 3.0 Fixed Supply PDO - Sink (Section 6.4.1.3.1)
+#define PD3P0_FIXED_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	R("Reserved", 20, 0x7) \
+	E("Fast Role Swap Required", 23, 0x3, "Fast Swap not supported", "Default USB Power", "1.5A @ 5V", "3.0A @ 5V") \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("Higher Capability", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 3.0 Variable Supply PDO - Sink (Section 6.4.1.3.2)
+#define PD3P0_VARIABLE_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 3.0 Battery Supply PDO - Sink (Section 6.4.1.3.3)
+#define PD3P0_BATTERY_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 3.0 PPS APDO - Sink (Section 6.4.1.3.4)
+#define PD3P0_PPS_APDO_SNK_FIELDS(F, E, R, U) \
+	U("Maximum Current in 50mA increments", 0, 0x7f, CURRENT, 50) \
+	R("Reserved", 7, 0x0) \
+	U("Minimum Voltage in 100mV increments", 8, 0xff, MIN_VOLTAGE, 100) \
+	R("Reserved", 16, 0x0) \
+	U("Maximum Voltage in 100mV increments", 17, 0xff, MAX_VOLTAGE, 100) \
+	R("Reserved", 25, 0x7) \
+	F("Programable Power Supply", 28, 0x3) \
+	F("Augmented Power Data Object", 30, 0x3)
+
+// USB PD 3.1 ID Header VDO (Section 6.4.4.3.1.1)
+#define PD3P1_PARTNER_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x1f) \
+	E("Connector Type", 21, 0x3, "Reserved", "Reserved", "USB Type-C Receptacle", "USB Type-C Plug") \
+	E("Product Type (DFP)", 23, 0x7, "Undefined", "PDUSB Hub", "PDUSB Host", "Power Brick", "Alternate Mode Controller", "Reserved", "Reserved", "Reserved") \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Product Type (UFP)", 27, 0x7, "Undefined", "PDUSB Hub", "PDUSB Peripheral", "PSD", "Reserved", "Alternate Mode Adapter", "Vconn Powered USB Device", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+#define PD3P1_CABLE_ID_HEADER_FIELDS(F, E, R, U) \
+	F("USB Vendor ID", 0, 0xffff) \
+	R("Reserved", 16, 0x1f) \
+	E("Connector Type", 21, 0x3, "Reserved", "Reserved", "USB Type-C Receptacle", "USB Type-C Plug") \
+	R("Product Type (DFP)", 23, 0x7) \
+	E("Modal Operation Supported", 26, 0x1, "No", "Yes") \
+	E("Product Type (Cable Plug)", 27, 0x7, "Undefined", "Reserved", "Reserved", "Passive Cable", "Active Cable", "Reserved", "Reserved", "Reserved") \
+	E("USB Capable as a Device", 30, 0x1, "No", "Yes") \
+	E("USB Capable as a Host", 31, 0x1, "No", "Yes")
+
+// USB PD 3.1 Cert Stat VDO (Section 6.4.4.3.1.2)
+#define PD3P1_CERT_STAT_FIELDS(F, E, R, U) \
+	F("XID", 0, 0xffffffff)
+
+// USB PD 3.1 Product VDO (Section 6.4.4.3.1.3)
+#define PD3P1_PRODUCT_FIELDS(F, E, R, U) \
+	F("bcdDevice", 0, 0xffff) \
+	F("USB Product ID", 16, 0xffff)
+
+// USB PD 3.1 Passive Cable VDO (Section 6.4.4.3.1.6)
+#define PD3P1_PASSIVE_CABLE_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 Only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	R("Reserved", 3, 0x3) \
+	E("Vbus Current Handling", 5, 0x3, "Reserved", "3A", "5A", "Reserved") \
+	R("Reserved", 7, 0x3) \
+	E("Maximum Vbus Voltage", 9, 0x3, "20V", "30V (Deprecated)", "40V (Deprecated)", "50V") \
+	E("Cable Termination Type", 11, 0x3, "Vconn Not Required", "Vconn Required", "Reserved", "Reserved") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", " 70ns (>~7m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("EPR Mode Capable", 17, 0x1, "No", "Yes") \
+	E("Type-C Connector to", 18, 0x3, "Reserved", "Reserved", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0x1) \
+	E("VDO version", 21, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 3.1 Active Cable VDO1/VDO2 (Section 6.4.4.3.1.7)
+#define PD3P1_ACTIVE_CABLE_VDO1_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 Only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("SOP'' Controller Present", 3, 0x1, "No", "Yes") \
+	E("Vbus Through Cable", 4, 0x1, "No", "Yes") \
+	E("Vbus Current Handling", 5, 0x3, "USB Type-C Default Current", "3A", "5A", "Reserved") \
+	E("SBU Type", 7, 0x1, "SBU is passive", "SBU is active") \
+	E("SBU Supported", 8, 0x1, "SBU connections supported", "SBU connections are not supported") \
+	E("Maximum Vbus Voltage", 9, 0x3, "20V", "30V", "40V", "50V") \
+	E("Cable Termination Type", 11, 0x3, "Reserved", "Reserved", "One end active, one end passive, Vconn required", "Both ends active, Vconn required") \
+	E("Cable Latency", 13, 0xf, "Reserved", "<10ns (~1m)", "10ns to 20ns (~2m)", "20ns to 30ns (~3m)", "30ns to 40ns (~4m)", "40ns to 50ns (~5m)", "50ns to 60ns (~6m)", "60ns to 70ns (~7m)", "1000b –1000ns (~100m)", "1001b –2000ns (~200m)", "1010b – 3000ns (~300m)", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("EPR Mode Capable", 17, 0x1, "No", "Yes") \
+	E("USB Type-C to", 18, 0x3, "Reserved", "Reserved", "USB Type-C", "Captive") \
+	R("Reserved", 20, 0x1) \
+	E("VDO version", 21, 0x7, "Reserved", "Reserved", "Reserved", "Version 1.3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+#define PD3P1_ACTIVE_CABLE_VDO2_FIELDS(F, E, R, U) \
+	E("USB Gen", 0, 0x1, "Gen 1", "Gen 2 or higher") \
+	R("Reserved", 1, 0x1) \
+	E("Optically Isolated Active Cable", 2, 0x1, "No", "Yes") \
+	E("USB Lanes Supported", 3, 0x1, "One Lane", "Two Lanes") \
+	E("USB 3.2 Supported", 4, 0x1, "USB 3.2 SuperSpeed supported", "USB 3.2 SuperSpeed not supported") \
+	E("USB 2.0 Supported", 5, 0x1, "USB 2.0 supported", "USB 2.0 not supported") \
+	F("USB 2.0 Hub Hops Consumed", 6, 0x3) \
+	E("USB4 Supported", 8, 0x1, "USB4 Supported", "USB4 Not Supported") \
+	E("Active element", 9, 0x1, "Active Redriver", "Active Retimer") \
+	E("Physical connection", 10, 0x1, "Copper", "Optical") \
+	E("U3 to U0 transition mode", 11, 0x1, "U3 to U0 direct", "U3 to U0 through U35") \
+	E("U3/Cld Power", 12, 0x7, ">10mW", "5-10mW", "1-5mW", "0.5-1mW", "0.2-0.5mW", "50-200uW", "<50uW", "Reserved") \
+	R("Reserved", 15, 0x1) \
+	F("Shutdown Temperature", 16, 0xff) \
+	F("Maximum Operating Temperature", 24, 0xff)
+
+// USB PD 3.1 VPD VDO (Section 6.4.4.3.1.9)
+#define PD3P1_VPD_FIELDS(F, E, R, U) \
+	E("Charge Through Support", 0, 0x1, "No", "Yes") \
+	F("Ground Impedance", 1, 0x3f) \
+	F("Vbus Impedance", 7, 0x3f) \
+	R("Reserved", 13, 0x3) \
+	E("Charge Through Current Support", 14, 0x1, "3A capable", "5A capable") \
+	E("Maximum Vbus Voltage", 15, 0x3, "20V", "30V (Deprecated)", "40V (Deprecated)", "50V (Deprecated)") \
+	R("Reserved", 17, 0xf) \
+	E("VDO Version", 21, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Firmware Version", 24, 0xf) \
+	F("HW Version", 28, 0xf)
+
+// USB PD 3.1 UFP VDO (Section 6.4.4.3.1.4)
+#define PD3P1_UFP_FIELDS(F, E, R, U) \
+	E("USB Highest Speed", 0, 0x7, "USB 2.0 only", "USB 3.2 Gen1", "USB 3.2/USB4 Gen2", "USB4 Gen3", "Reserved", "Reserved", "Reserved", "Reserved") \
+	F("Alternate Modes", 3, 0x7) \
+	E("Vbus Required", 6, 0x1, "Yes", "No") \
+	E("Vconn Required", 7, 0x1, "No", "Yes") \
+	E("Vconn Power", 8, 0x7, "1W", "1.5W", "2W", "3W", "4W", "5W", "6W", "Reserved") \
+	R("Reserved", 11, 0x7ff) \
+	F("Connector Type", 22, 0x3) \
+	F("Device Capability", 24, 0xf) \
+	R("Reserved", 28, 0x1) \
+	E("UFP VDO Version", 29, 0x7, "Reserved", "Reserved", "Reserved", "Version 1.3", "Reserved", "Reserved", "Reserved", "Reserved")
+
+// USB PD 3.1 DFP VDO (Section 6.4.4.3.1.5)
+#define PD3P1_DFP_FIELDS(F, E, R, U) \
+	F("Port Number", 0, 0x1f) \
+	R("Reserved", 5, 0x1ffff) \
+	F("Connector Type", 22, 0x3) \
+	F("Host Capability", 24, 0x7) \
+	R("Reserved", 27, 0x3) \
+	E("DFP VDO Version", 29, 0x7, "Version 1.0", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved", "Reserved")
+
+// USB PD 3.1 Fixed Supply PDO - Source (Section 6.4.1.2.2)
+#define PD3P1_FIXED_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	F("Peak Current", 20, 0x3) \
+	R("Reserved", 22, 0x1) \
+	F("EPR Mode Capable", 23, 0x1) \
+	R("Unchunked Extended Messages Supported", 24, 0x1) \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("USB Suspend Supported", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 3.1 Variable Supply PDO - Source (Section 6.4.1.2.3)
+#define PD3P1_VARIABLE_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 3.1 Battery Supply PDO - Source (Section 6.4.1.2.4)
+#define PD3P1_BATTERY_SUPPLY_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Allowable Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 3.1 PPS APDO - Source (Section 6.4.1.2.5)
+#define PD3P1_PPS_APDO_SRC_FIELDS(F, E, R, U) \
+	U("Maximum Current in 50mA increments", 0, 0x7f, CURRENT, 50) \
+	R("Reserved", 7, 0x0) \
+	U("Minimum Voltage in 100mV increments", 8, 0xff, MIN_VOLTAGE, 100) \
+	R("Reserved", 16, 0x0) \
+	U("Maximum Voltage in 100mV increments", 17, 0xff, MAX_VOLTAGE, 100) \
+	R("Reserved", 25, 0x0) \
+	F("PPS Power Limited", 27, 0x1) \
+	F("SPR PPS", 28, 0x3) \
+	F("Augmented Power Data Object", 30, 0x3)
+
+// USB PD 3.1 Fixed Supply PDO - Sink (Section 6.4.1.3.1)
+#define PD3P1_FIXED_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Voltage in 50mV units", 10, 0x3ff, VOLTAGE, 50) \
+	R("Reserved", 20, 0x7) \
+	E("Fast Role Swap Required", 23, 0x3, "Fast Swap not supported", "Default USB Power", "1.5A @ 5V", "3.0A @ 5V") \
+	F("Dual-Role Data", 25, 0x1) \
+	F("USB Communications Capable", 26, 0x1) \
+	F("Unconstrained Power", 27, 0x1) \
+	F("Higher Capability", 28, 0x1) \
+	F("Daul-Role Power", 29, 0x1) \
+	F("Fixed supply", 30, 0x3)
+
+// USB PD 3.1 Variable Supply PDO - Sink (Section 6.4.1.3.2)
+#define PD3P1_VARIABLE_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Current in 10mA units", 0, 0x3ff, CURRENT, 10) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Variable Supply", 30, 0x3)
+
+// USB PD 3.1 Battery Supply PDO - Sink (Section 6.4.1.3.3)
+#define PD3P1_BATTERY_SUPPLY_SNK_FIELDS(F, E, R, U) \
+	U("Operational Power in 250mW units", 0, 0x3ff, POWER, 250) \
+	U("Minimum Voltage in 50mV units", 10, 0x3ff, MIN_VOLTAGE, 50) \
+	U("Maximum Voltage in 50mV units", 20, 0x3ff, MAX_VOLTAGE, 50) \
+	F("Battery", 30, 0x3)
+
+// USB PD 3.1 PPS APDO - Sink (Section 6.4.1.3.4)
+#define PD3P1_PPS_APDO_SNK_FIELDS(F, E, R, U) \
+	U("Maximum Current in 50mA increments", 0, 0x7f, CURRENT, 50) \
+	R("Reserved", 7, 0x0) \
+	U("Minimum Voltage in 100mV increments", 8, 0xff, MIN_VOLTAGE, 100) \
+	R("Reserved", 16, 0x0) \
+	U("Maximum Voltage in 100mV increments", 17, 0xff, MAX_VOLTAGE, 100) \
+	R("Reserved", 25, 0x7) \
+	F("SPR PPS", 28, 0x3) \
+	F("Augmented Power Data Object", 30, 0x3)
+
+// Alternate mode VDOs
+#define DP_ALT_MODE_PARTNER_FIELDS(F, E, R, U) \
+	E("Port Capability", 0, 0x3, "Reserved", "DP Sink Deice Capable", "DP Source Device Capable", "Both Sink and Source Device Capable") \
+	F("Signaling for Transport of DisplaPort Protocol", 2, 0xf) \
+	E("Receptacle Indication", 6, 0x1, "DP interface presents as a plug", "DP interface presents as a receptacle") \
+	E("USB 2.0 Signaling Not Used", 7, 0x1, "USB 2.0 may be needed", "USB 2.0 not needed") \
+	F("DP Source Device Pin Supported", 8, 0xff) \
+	F("DP Sink Device Pin Supported", 16, 0xff) \
+	R("Reserved", 24, 0xff)
+
+#define DP_ALT_MODE_ACTIVE_CABLE_FIELDS(F, E, R, U) \
+	R("Reserved", 0, 0x3) \
+	F("Signaling for Transport of DisplaPort Protocol", 2, 0xf) \
+	R("Reserved", 6, 0x3) \
+	F("DP Source Device Pin Assignments Supported", 8, 0xff) \
+	F("DP Sink Device Pin Assignments Supported", 16, 0xff) \
+	R("Reserved", 24, 0xff)
+
+#define TBT3_SOP_FIELDS(F, E, R, U) \
+	F("TBT Alternate Mode", 0, 0xffff) \
+	E("TBT Adapter", 16, 0x1, "TBT3 Adapter", "TBT2 Legacy Adapter") \
+	F("Reserved", 17, 0x1ff) \
+	E("Intel Specific B0", 26, 0x1, "Not Supported", "Supported") \
+	F("Reserved", 27, 0x7) \
+	E("Vendor Specific B0", 30, 0x1, "Not Supported", "Supported") \
+	E("Vendor Specific B1", 31, 0x1, "Not Supported", "Supported")
+
+#define TBT3_SOP_PR_FIELDS(F, E, R, U) \
+	F("TBT Alternate Mode", 0, 0xffff) \
+	E("Cable Speed", 16, 0x7, "Reserved", "USB 3.1 Gen1 (10 Gbps TBT Support)", "10 Gbps (USB 3.2 Gen1 and Gen2 passive cables)", "10 Gbps and 20 Gbps (TBT 3rd Gen active cables and 20 Gbps passive cables)", "Reserved", "Reserved", "Reserved", "Reserved") \
+	E("TBT Rounded Support", 19, 0x3, "3rd Gen Non-Rounded TBT", "3rd & 4th Gen Rounded and Non-Rounded TBT", "Reserved", "Reserved") \
+	E("Cable Type", 21, 0x1, "Non-Optical", "Optical") \
+	E("Re-timer", 22, 0x1, "Not re-timer", "Re-timer") \
+	E("Active Cable Plug Link Training", 23, 0x1, "Active with bi-directional LSRX", "Active with uni-directional LSRX") \
+	R("Reserved", 24, 0x1) \
+	E("Active_Passive", 25, 0x1, "Passive Cable", "Active Cable") \
+	R("Reserved", 26, 0x3f)
+
+#define LIBTYPEC_DECODE_OBJECTS(T) \
+	T(pd2p0_partner_id_header, PD2P0_PARTNER_ID_HEADER_FIELDS) \
+	T(pd2p0_cable_id_header, PD2P0_CABLE_ID_HEADER_FIELDS) \
+	T(pd2p0_cert_stat, PD2P0_CERT_STAT_FIELDS) \
+	T(pd2p0_product, PD2P0_PRODUCT_FIELDS) \
+	T(pd2p0_passive_cable, PD2P0_PASSIVE_CABLE_FIELDS) \
+	T(pd2p0_active_cable, PD2P0_ACTIVE_CABLE_FIELDS) \
+	T(pd2p0_ama, PD2P0_AMA_FIELDS) \
+	T(pd2p0_fixed_supply_src, PD2P0_FIXED_SUPPLY_SRC_FIELDS) \
+	T(pd2p0_variable_supply_src, PD2P0_VARIABLE_SUPPLY_SRC_FIELDS) \
+	T(pd2p0_battery_supply_src, PD2P0_BATTERY_SUPPLY_SRC_FIELDS) \
+	T(pd2p0_fixed_supply_snk, PD2P0_FIXED_SUPPLY_SNK_FIELDS) \
+	T(pd2p0_variable_supply_snk, PD2P0_VARIABLE_SUPPLY_SNK_FIELDS) \
+	T(pd2p0_battery_supply_snk, PD2P0_BATTERY_SUPPLY_SNK_FIELDS) \
+	T(pd3p0_partner_id_header, PD3P0_PARTNER_ID_HEADER_FIELDS) \
+	T(pd3p0_cable_id_header, PD3P0_CABLE_ID_HEADER_FIELDS) \
+	T(pd3p0_cert_stat, PD3P0_CERT_STAT_FIELDS) \
+	T(pd3p0_product, PD3P0_PRODUCT_FIELDS) \
+	T(pd3p0_passive_cable, PD3P0_PASSIVE_CABLE_FIELDS) \
+	T(pd3p0_active_cable_vdo1, PD3P0_ACTIVE_CABLE_VDO1_FIELDS) \
+	T(pd3p0_active_cable_vdo2, PD3P0_ACTIVE_CABLE_VDO2_FIELDS) \
+	T(pd3p0_ama, PD3P0_AMA_FIELDS) \
+	T(pd3p0_vpd, PD3P0_VPD_FIELDS) \
+	T(pd3p0_ufp_vdo1, PD3P0_UFP_VDO1_FIELDS) \
+	T(pd3p0_ufp_vdo2, PD3P0_UFP_VDO2_FIELDS) \
+	T(pd3p0_dfp, PD3P0_DFP_FIELDS) \
+	T(pd3p0_fixed_supply_src, PD3P0_FIXED_SUPPLY_SRC_FIELDS) \
+	T(pd3p0_variable_supply_src, PD3P0_VARIABLE_SUPPLY_SRC_FIELDS) \
+	T(pd3p0_battery_supply_src, PD3P0_BATTERY_SUPPLY_SRC_FIELDS) \
+	T(pd3p0_pps_apdo_src, PD3P0_PPS_APDO_SRC_FIELDS) \
+	T(pd3p0_fixed_supply_snk, PD3P0_FIXED_SUPPLY_SNK_FIELDS) \
+	T(pd3p0_variable_supply_snk, PD3P0_VARIABLE_SUPPLY_SNK_FIELDS) \
+	T(pd3p0_battery_supply_snk, PD3P0_BATTERY_SUPPLY_SNK_FIELDS) \
+	T(pd3p0_pps_apdo_snk, PD3P0_PPS_APDO_SNK_FIELDS) \
+	T(pd3p1_partner_id_header, PD3P1_PARTNER_ID_HEADER_FIELDS) \
+	T(pd3p1_cable_id_header, PD3P1_CABLE_ID_HEADER_FIELDS) \
+	T(pd3p1_cert_stat, PD3P1_CERT_STAT_FIELDS) \
+	T(pd3p1_product, PD3P1_PRODUCT_FIELDS) \
+	T(pd3p1_passive_cable, PD3P1_PASSIVE_CABLE_FIELDS) \
+	T(pd3p1_active_cable_vdo1, PD3P1_ACTIVE_CABLE_VDO1_FIELDS) \
+	T(pd3p1_active_cable_vdo2, PD3P1_ACTIVE_CABLE_VDO2_FIELDS) \
+	T(pd3p1_vpd, PD3P1_VPD_FIELDS) \
+	T(pd3p1_ufp, PD3P1_UFP_FIELDS) \
+	T(pd3p1_dfp, PD3P1_DFP_FIELDS) \
+	T(pd3p1_fixed_supply_src, PD3P1_FIXED_SUPPLY_SRC_FIELDS) \
+	T(pd3p1_variable_supply_src, PD3P1_VARIABLE_SUPPLY_SRC_FIELDS) \
+	T(pd3p1_battery_supply_src, PD3P1_BATTERY_SUPPLY_SRC_FIELDS) \
+	T(pd3p1_pps_apdo_src, PD3P1_PPS_APDO_SRC_FIELDS) \
+	T(pd3p1_fixed_supply_snk, PD3P1_FIXED_SUPPLY_SNK_FIELDS) \
+	T(pd3p1_variable_supply_snk, PD3P1_VARIABLE_SUPPLY_SNK_FIELDS) \
+	T(pd3p1_battery_supply_snk, PD3P1_BATTERY_SUPPLY_SNK_FIELDS) \
+	T(pd3p1_pps_apdo_snk, PD3P1_PPS_APDO_SNK_FIELDS) \
+	T(dp_alt_mode_partner, DP_ALT_MODE_PARTNER_FIELDS) \
+	T(dp_alt_mode_active_cable, DP_ALT_MODE_ACTIVE_CABLE_FIELDS) \
+	T(tbt3_sop, TBT3_SOP_FIELDS) \
+	T(tbt3_sop_pr, TBT3_SOP_PR_FIELDS)
+
+#endif /*LIBTYPEC_DECODE_FIELDS_H*/
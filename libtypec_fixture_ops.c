@@ -0,0 +1,289 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_fixture_ops.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Fixture backend replaying a recorded topology
+ *
+ * A fixture is a binary topology snapshot, as written by
+ * libtypec_snapshot_write() or "lstypec --record". It is expanded once at
+ * load time and every query is then served from memory, which makes the
+ * library deterministic and hardware free for benchmarking and for
+ * reproducing topologies captured on other machines.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <endian.h>
+
+static struct libtypec_capability_data fixture_cap;
+static struct libtypec_port_state *fixture_port;
+static int fixture_num_ports;
+
+/**
+ * This function loads a recorded topology. Once loaded, the next
+ * libtypec_init() selects the fixture backend regardless of the platform.
+ * Naming a snapshot in the LIBTYPEC_FIXTURE environment variable has the
+ * same effect.
+ *
+ * \param path Snapshot file to replay
+ *
+ * \returns 0 on success, negative errno otherwise
+ */
+int libtypec_fixture_load(const char *path)
+{
+	const struct libtypec_snapshot_header *snap;
+	struct libtypec_port_state *port;
+	size_t size;
+	int i;
+
+	errno = 0;
+	snap = libtypec_snapshot_map(path, &size);
+	if (!snap)
+		return errno ? -errno : -EINVAL;
+
+	port = calloc(snap->num_ports ? snap->num_ports : 1, sizeof(*port));
+	if (!port)
+	{
+		libtypec_snapshot_unmap(snap, size);
+		return -ENOMEM;
+	}
+
+	for (i = 0; i < snap->num_ports; i++)
+		libtypec_snapshot_port_state(snap, i, &port[i]);
+
+	libtypec_fixture_unload();
+
+	memset(&fixture_cap, 0, sizeof(fixture_cap));
+	fixture_cap.bmAttributes = le32toh(snap->bmAttributes);
+	fixture_cap.bNumConnectors = snap->num_ports;
+	fixture_cap.bmOptionalFeatures = le32toh(snap->bmOptionalFeatures);
+	fixture_cap.bNumAltModes = snap->num_alt_modes;
+	fixture_cap.bcdBCVersion = le16toh(snap->bcdBCVersion);
+	fixture_cap.bcdPDVersion = le16toh(snap->bcdPDVersion);
+	fixture_cap.bcdTypeCVersion = le16toh(snap->bcdTypeCVersion);
+
+	fixture_port = port;
+	fixture_num_ports = snap->num_ports;
+
+	libtypec_snapshot_unmap(snap, size);
+
+	return 0;
+}
+
+/**
+ * This function releases a topology loaded by libtypec_fixture_load().
+ */
+void libtypec_fixture_unload(void)
+{
+	free(fixture_port);
+	fixture_port = NULL;
+	fixture_num_ports = 0;
+}
+
+int libtypec_fixture_attach(void)
+{
+	const char *path;
+
+	if (fixture_port)
+		return 0;
+
+	path = getenv("LIBTYPEC_FIXTURE");
+	if (!path)
+		return -ENOENT;
+
+	return libtypec_fixture_load(path);
+}
+
+static const struct libtypec_port_state *fixture_state(int conn_num)
+{
+	if (!fixture_port || conn_num < 0 || conn_num >= fixture_num_ports)
+		return NULL;
+
+	return &fixture_port[conn_num];
+}
+
+static int libtypec_fixture_init(char **session_info)
+{
+	return fixture_port ? 0 : -EIO;
+}
+
+static int libtypec_fixture_exit(void)
+{
+	libtypec_fixture_unload();
+
+	return 0;
+}
+
+static int libtypec_fixture_get_capability_ops(struct libtypec_capability_data *cap_data)
+{
+	if (!fixture_port)
+		return -EIO;
+
+	*cap_data = fixture_cap;
+
+	return 0;
+}
+
+static int libtypec_fixture_get_conn_capability_ops(int conn_num, struct libtypec_connector_cap_data *conn_cap_data)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+
+	if (!p)
+		return -EIO;
+
+	*conn_cap_data = p->conn_cap;
+
+	return (p->valid & LIBTYPEC_STATE_CONN_CAP) ? 0 : -1;
+}
+
+static int libtypec_fixture_get_alternate_modes(int recipient, int conn_num, struct altmode_data *alt_mode_data)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+
+	if (!p || recipient < AM_CONNECTOR || recipient > AM_SOP_PR)
+		return -EIO;
+
+	memcpy(alt_mode_data, p->am[recipient], p->num_am[recipient] * sizeof(struct altmode_data));
+
+	return p->num_am[recipient];
+}
+
+static int libtypec_fixture_get_cam_supported_ops(int conn_num, char *cam_data)
+{
+	/* Not part of the recorded topology */
+	return -EIO;
+}
+
+static int libtypec_fixture_get_current_cam_ops(char *cur_cam_data)
+{
+	return -EIO;
+}
+
+static int libtypec_fixture_get_pdos_ops(int conn_num, int partner, int offset, int *num_pdo, int src_snk, int type, unsigned int *pdo_data)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+	int idx = ((partner ? 1 : 0) << 1) | (src_snk ? 1 : 0);
+	int num;
+
+	if (!p || offset < 0 || offset >= LIBTYPEC_MAX_PDOS || type != 0)
+		return -EIO;
+
+	num = p->num_pdos[idx] - offset;
+	if (num < 0)
+		num = 0;
+	memcpy(pdo_data, &p->pdos[idx][offset], num * sizeof(unsigned int));
+
+	*num_pdo = num;
+	return num;
+}
+
+static int libtypec_fixture_get_cable_properties_ops(int conn_num, struct libtypec_cable_property *cbl_prop_data)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+
+	if (!p)
+		return -EIO;
+
+	*cbl_prop_data = p->cable_prop;
+
+	return (p->valid & LIBTYPEC_STATE_CABLE) ? 0 : -1;
+}
+
+static int libtypec_fixture_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+
+	if (!p)
+		return -EIO;
+
+	*conn_sts = p->conn_sts;
+
+	return (p->valid & LIBTYPEC_STATE_CONN_STS) ? 0 : -1;
+}
+
+static int libtypec_fixture_get_pd_message_ops(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp)
+{
+	const struct libtypec_port_state *p = fixture_state(conn_num);
+	unsigned int bit;
+
+	if (!p || resp_type != DISCOVER_ID_REQ || (recipient != AM_SOP && recipient != AM_SOP_PR))
+		return -EIO;
+
+	bit = (recipient == AM_SOP) ? LIBTYPEC_STATE_ID_SOP : LIBTYPEC_STATE_ID_SOP_PR;
+	if (!(p->valid & bit))
+		return -1;
+
+	if (num_bytes > (int)sizeof(p->id[0]) || num_bytes < 0)
+		num_bytes = sizeof(p->id[0]);
+	memcpy(pd_msg_resp, p->id[recipient - 1].buf_disc_id, num_bytes);
+
+	return 0;
+}
+
+static int libtypec_fixture_get_bb_status(unsigned int *num_bb_instance)
+{
+	*num_bb_instance = 0;
+
+	return 0;
+}
+
+static int libtypec_fixture_get_bb_data(int num_billboards, char *bb_data)
+{
+	return -EIO;
+}
+
+static void libtypec_fixture_monitor_events(void)
+{
+	/* A recorded topology never changes */
+}
+
+static int libtypec_fixture_get_power_supply_status_ops(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+	/* Fixtures record the typec topology, not power supplies */
+	return -EOPNOTSUPP;
+}
+
+const struct libtypec_os_backend libtypec_fixture_backend = {
+	.init = libtypec_fixture_init,
+	.exit = libtypec_fixture_exit,
+	.get_capability_ops = libtypec_fixture_get_capability_ops,
+	.get_conn_capability_ops = libtypec_fixture_get_conn_capability_ops,
+	.get_alternate_modes = libtypec_fixture_get_alternate_modes,
+	.get_cam_supported_ops = libtypec_fixture_get_cam_supported_ops,
+	.get_current_cam_ops = libtypec_fixture_get_current_cam_ops,
+	.get_pdos_ops = libtypec_fixture_get_pdos_ops,
+	.get_cable_properties_ops = libtypec_fixture_get_cable_properties_ops,
+	.get_connector_status_ops = libtypec_fixture_get_connector_status_ops,
+	.get_pd_message_ops = libtypec_fixture_get_pd_message_ops,
+	.get_bb_status = libtypec_fixture_get_bb_status,
+	.get_bb_data = libtypec_fixture_get_bb_data,
+	.monitor_events = libtypec_fixture_monitor_events,
+	.get_power_supply_status_ops = libtypec_fixture_get_power_supply_status_ops,
+};
@@ -34,10 +34,26 @@ SOFTWARE.
 #define LIBTYPEC_OPS_H
 
 #include "libtypec.h"
+#include <time.h>
+#include <pthread.h>
 
 #define SYSFS_TYPEC_PATH "/sys/class/typec"
 #define SYSFS_PSY_PATH "/sys/class/power_supply"
-#define UCSI_DEBUGFS_PATH "/sys/kernel/debug/usb/ucsi/USBC000:00"
+#define UCSI_DEBUGFS_PATH "/sys/kernel/debug/usb/ucsi"
+#define LIBTYPEC_SHM_PATH "/dev/shm/libtypec"
+#define TYPECD_SOCKET_PATH "/run/typecd.sock"
+
+#define LIBTYPEC_MAX_PDOS 16
+#define LIBTYPEC_MAX_ALTMODES 16
+#define LIBTYPEC_AM_SCRATCH 64
+#define LIBTYPEC_BB_DATA_MAX 512
+
+/* libtypec_port_state.valid bits */
+#define LIBTYPEC_STATE_CONN_CAP (1 << 0)
+#define LIBTYPEC_STATE_CONN_STS (1 << 1)
+#define LIBTYPEC_STATE_CABLE (1 << 2)
+#define LIBTYPEC_STATE_ID_SOP (1 << 3)
+#define LIBTYPEC_STATE_ID_SOP_PR (1 << 4)
 
 /**
  * @brief
@@ -45,7 +61,15 @@ SOFTWARE.
  */
 extern const struct libtypec_os_backend libtypec_lnx_dbgfs_backend;
 extern const struct libtypec_os_backend libtypec_lnx_sysfs_backend;
+extern const struct libtypec_os_backend libtypec_shm_backend;
+extern const struct libtypec_os_backend libtypec_typecd_backend;
+extern const struct libtypec_os_backend libtypec_fixture_backend;
+extern const struct libtypec_os_backend libtypec_composite_backend;
 extern libtypec_notification_list_t* registered_callbacks[USBC_EVENT_COUNT];
+extern pthread_mutex_t registered_callbacks_lock;
+void libtypec_notify_event(enum usb_typec_event event, int port);
+
+void libtypec_lnx_monitor_udev_events(void);
 
 struct libtypec_os_backend
 {
@@ -76,6 +100,109 @@ struct libtypec_os_backend
     int (*get_bb_data)(int num_billboards,char* bb_data);
 
     void (*monitor_events)(void);
+
+    int (*get_power_supply_status_ops)(int conn_num, struct libtypec_power_supply_status *psy_sts);
+};
+
+/**
+ * @brief Decoded state of one connector as seen through a backend.
+ *
+ * Altmodes are indexed by recipient (AM_CONNECTOR, AM_SOP, AM_SOP_PR),
+ * identities by recipient - 1 and PDOs by (partner << 1 | src_snk).
+ */
+struct libtypec_port_state
+{
+    unsigned int valid;
+    struct libtypec_connector_cap_data conn_cap;
+    struct libtypec_connector_status conn_sts;
+    struct libtypec_cable_property cable_prop;
+    union libtypec_discovered_identity id[2];
+    int num_am[3];
+    struct altmode_data am[3][LIBTYPEC_MAX_ALTMODES];
+    int num_pdos[4];
+    unsigned int pdos[4][LIBTYPEC_MAX_PDOS];
 };
 
+const struct libtypec_os_backend *libtypec_get_backend(void);
+const struct libtypec_os_backend *libtypec_get_native_backend(int *ops_method);
+const char *libtypec_composite_routing(void);
+void libtypec_put_native_backend(void);
+
+int libtypec_collect_port_state(const struct libtypec_os_backend *backend, int conn_num, struct libtypec_port_state *state);
+
+void libtypec_snapshot_port_state(const struct libtypec_snapshot_header *snap, int conn_num, struct libtypec_port_state *state);
+
+void libtypec_dbgfs_port_changed(int conn_num);
+void libtypec_dbgfs_typec_port_changed(int port);
+
+void libtypec_psy_map_invalidate(void);
+int libtypec_psy_map_lookup(int conn_num, char *path, size_t len);
+
+int libtypec_shm_attach(void);
+int libtypec_typecd_attach(void);
+int libtypec_fixture_attach(void);
+
+/* Largest MESSAGE_IN of UCSI 2.x */
+#define LIBTYPEC_UCSI_MESSAGE_IN_MAX 256
+
+/* UCSI debugfs transaction trace, see libtypec_ucsi_trace.c */
+
+enum ucsi_trace_status {
+    UCSI_TRACE_OK,
+    UCSI_TRACE_WRITE_ERR,
+    UCSI_TRACE_POLL_ERR,
+    UCSI_TRACE_READ_ERR,
+    UCSI_TRACE_FORMAT_ERR,
+};
+
+int libtypec_ucsi_trace_init(void);
+void libtypec_ucsi_trace_exit(void);
+int libtypec_ucsi_trace_replaying(void);
+int libtypec_ucsi_trace_instances(void);
+void libtypec_ucsi_trace_record(int instance, unsigned long long command, const struct timespec *start,
+                                unsigned long long write_ns, unsigned long long read_ns,
+                                const unsigned char *msg, int msg_len, int status);
+int libtypec_ucsi_trace_replay(int instance, unsigned long long command, unsigned char *msg, int max_len);
+
+/**
+ * @brief typecd protocol
+ *
+ * One request and one response per SOCK_SEQPACKET message. Arguments are
+ * the libtypec API arguments in declaration order, output buffers travel
+ * back in the response payload.
+ */
+#define TYPECD_MAX_PAYLOAD 1024
+
+enum typecd_op {
+    TYPECD_OP_CAPABILITY,
+    TYPECD_OP_CONN_CAPABILITY,
+    TYPECD_OP_ALTERNATE_MODES,
+    TYPECD_OP_CAM_SUPPORTED,
+    TYPECD_OP_CURRENT_CAM,
+    TYPECD_OP_PDOS,
+    TYPECD_OP_CABLE_PROPERTIES,
+    TYPECD_OP_CONNECTOR_STATUS,
+    TYPECD_OP_PD_MESSAGE,
+    TYPECD_OP_BB_STATUS,
+    TYPECD_OP_BB_DATA,
+    TYPECD_OP_POWER_SUPPLY_STATUS,
+    TYPECD_OP_COUNT
+};
+
+struct typecd_request
+{
+    unsigned int op;
+    int args[6];
+};
+
+struct typecd_response
+{
+    int ret;
+    int num;
+    unsigned int len;
+    unsigned char data[TYPECD_MAX_PAYLOAD];
+};
+
+#define TYPECD_RESPONSE_HDR_LEN (sizeof(struct typecd_response) - TYPECD_MAX_PAYLOAD)
+
 #endif /*LIBTYPEC_OPS_H*/
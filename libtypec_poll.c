@@ -0,0 +1,259 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_poll.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Adaptive connector status polling for backends without change events
+ *
+ * A poller thread reads GET_CONNECTOR_STATUS of each connector on its own
+ * schedule. A connector that changed is polled again after the minimum
+ * interval, every stable poll doubles its interval up to the maximum. One
+ * timerfd is armed for the earliest deadline and every connector due within
+ * a quarter of its interval is polled on the same wake-up, so stable ports
+ * drift into a common, rare wake-up. Changes are delivered to the callbacks
+ * registered with libtypec_register_typec_notification_callback().
+ */
+
+#include "libtypec_ops.h"
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+#define POLL_MAX_PORTS 32
+
+struct poll_port
+{
+	uint64_t deadline_ns;
+	uint64_t interval_ns;
+	int valid;
+	struct libtypec_connector_status sts;
+};
+
+static struct poll_port poll_ports[POLL_MAX_PORTS];
+static int poll_num_ports;
+static uint64_t poll_min_ns, poll_max_ns;
+static int poll_timer_fd = -1;
+static int poll_stop_fd = -1;
+static pthread_t poll_thread;
+
+static uint64_t poll_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+/* Maps a status transition to the event reported for it, -1 when nothing changed */
+static int poll_status_event(const struct libtypec_connector_status *old, const struct libtypec_connector_status *new)
+{
+	if (old->connect_sts != new->connect_sts)
+		return new->connect_sts ? USBC_DEVICE_CONNECTED : USBC_DEVICE_DISCONNECTED;
+
+	if (new->sts_change ||
+	    old->pwr_op_mode != new->pwr_op_mode ||
+	    old->pwr_dir != new->pwr_dir ||
+	    old->ptnr_flags != new->ptnr_flags ||
+	    old->ptnr_type != new->ptnr_type ||
+	    old->rdo != new->rdo ||
+	    old->bat_chrg_cap_sts != new->bat_chrg_cap_sts ||
+	    old->cap_ltd_reason != new->cap_ltd_reason ||
+	    old->bcdPDVer_op_mode != new->bcdPDVer_op_mode)
+		return USBC_DEVICE_CHANGED;
+
+	return -1;
+}
+
+static void poll_connector(struct poll_port *port, int conn_num, uint64_t now)
+{
+	struct libtypec_connector_status sts;
+	int event = -1;
+
+	memset(&sts, 0, sizeof(sts));
+	if (libtypec_get_connector_status(conn_num, &sts) < 0)
+	{
+		/* Failing ports are retried at the slowest rate */
+		port->interval_ns = poll_max_ns;
+		port->deadline_ns = now + port->interval_ns;
+		return;
+	}
+
+	if (port->valid)
+		event = poll_status_event(&port->sts, &sts);
+
+	port->sts = sts;
+	port->valid = 1;
+
+	if (event >= 0)
+		port->interval_ns = poll_min_ns;
+	else if (port->interval_ns < poll_max_ns)
+		port->interval_ns = port->interval_ns * 2 < poll_max_ns ? port->interval_ns * 2 : poll_max_ns;
+	port->deadline_ns = now + port->interval_ns;
+
+	if (event >= 0)
+		libtypec_notify_event(event, conn_num);
+}
+
+static void *poll_worker(void *arg)
+{
+	struct pollfd pfd[2] = {
+		{ .fd = poll_timer_fd, .events = POLLIN },
+		{ .fd = poll_stop_fd, .events = POLLIN },
+	};
+	struct itimerspec its = {0};
+	uint64_t expirations, now, next;
+
+	while (1)
+	{
+		now = poll_now_ns();
+		next = UINT64_MAX;
+
+		for (int i = 0; i < poll_num_ports; i++)
+		{
+			struct poll_port *port = &poll_ports[i];
+
+			/* Coalesce every port due before a quarter of its interval elapses */
+			if (port->deadline_ns <= now + port->interval_ns / 4)
+				poll_connector(port, i, now);
+
+			if (port->deadline_ns < next)
+				next = port->deadline_ns;
+		}
+
+		/* Absolute deadline, a port polled late is not made up for */
+		its.it_value.tv_sec = next / 1000000000ull;
+		its.it_value.tv_nsec = next % 1000000000ull;
+		if (timerfd_settime(poll_timer_fd, TFD_TIMER_ABSTIME, &its, NULL) < 0)
+			break;
+
+		while (poll(pfd, 2, -1) < 0 && errno == EINTR)
+			;
+
+		if (pfd[1].revents)
+			break;
+
+		if (pfd[0].revents & POLLIN)
+			while (read(poll_timer_fd, &expirations, sizeof(expirations)) < 0 && errno == EINTR)
+				;
+	}
+
+	return NULL;
+}
+
+/**
+ * Starts polling the status of every connector and reporting changes to the
+ * registered notification callbacks. Meant for backends that cannot deliver
+ * change events, such as UCSI debugfs.
+ *
+ * The poller calls libtypec_get_connector_status() from its own thread
+ * while the application keeps making library calls. Every backend guards
+ * the state those calls share: the typecd connection, the cached power
+ * supply files and the debugfs instances. Stop the poller before
+ * libtypec_exit().
+ *
+ * \param min_interval_ms Interval after a change
+ * \param max_interval_ms Interval a stable connector backs off to
+ *
+ * \returns 0 on success, -EBUSY when already running, -EINVAL for bad
+ *          arguments or a negative errno
+ */
+int libtypec_status_poller_start(unsigned int min_interval_ms, unsigned int max_interval_ms)
+{
+	struct libtypec_capability_data cap;
+	uint64_t now;
+	int ret;
+
+	if (poll_timer_fd >= 0)
+		return -EBUSY;
+
+	if (!min_interval_ms || max_interval_ms < min_interval_ms)
+		return -EINVAL;
+
+	ret = libtypec_get_capability(&cap);
+	if (ret < 0)
+		return ret;
+
+	poll_min_ns = min_interval_ms * 1000000ull;
+	poll_max_ns = max_interval_ms * 1000000ull;
+	poll_num_ports = cap.bNumConnectors < POLL_MAX_PORTS ? cap.bNumConnectors : POLL_MAX_PORTS;
+
+	/* The first pass only records the current status */
+	now = poll_now_ns();
+	memset(poll_ports, 0, sizeof(poll_ports));
+	for (int i = 0; i < poll_num_ports; i++)
+	{
+		poll_ports[i].interval_ns = poll_min_ns;
+		poll_ports[i].deadline_ns = now;
+	}
+
+	poll_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	poll_stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (poll_timer_fd < 0 || poll_stop_fd < 0)
+	{
+		ret = -errno;
+		goto err;
+	}
+
+	ret = -pthread_create(&poll_thread, NULL, poll_worker, NULL);
+	if (ret < 0)
+		goto err;
+
+	return 0;
+
+err:
+	if (poll_timer_fd >= 0)
+		close(poll_timer_fd);
+	if (poll_stop_fd >= 0)
+		close(poll_stop_fd);
+	poll_timer_fd = poll_stop_fd = -1;
+	return ret;
+}
+
+/**
+ * Stops the connector status poller.
+ *
+ * \returns 0 on success, -EINVAL when not running
+ */
+int libtypec_status_poller_stop(void)
+{
+	uint64_t one = 1;
+
+	if (poll_timer_fd < 0)
+		return -EINVAL;
+
+	if (write(poll_stop_fd, &one, sizeof(one)) != sizeof(one))
+		return -errno;
+	pthread_join(poll_thread, NULL);
+
+	close(poll_timer_fd);
+	close(poll_stop_fd);
+	poll_timer_fd = poll_stop_fd = -1;
+	return 0;
+}
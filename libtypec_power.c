@@ -0,0 +1,400 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_power.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Fixed rate sampling of per-port power supply telemetry
+ *
+ * A sampler thread wakes on a timerfd at the configured period and reads
+ * voltage_now and current_now of every port's power supply through file
+ * descriptors opened once. Samples go to a per-port ring: the sampler is
+ * the only writer and publishes a sample by advancing head with release
+ * semantics, readers copy slots without locking and discard any slot the
+ * writer may have reused while they were copying.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/timerfd.h>
+#include <sys/eventfd.h>
+
+#define POWER_MAX_PORTS 32
+
+struct power_ring
+{
+	int volt_fd;
+	int curr_fd;
+	uint64_t head;		/* samples ever written, slot is head % capacity */
+	struct libtypec_power_sample *slots;
+};
+
+static struct power_ring power_rings[POWER_MAX_PORTS];
+static int power_num_ports;
+static unsigned int power_capacity;
+static uint64_t power_overruns;
+static int power_timer_fd = -1;
+static int power_stop_fd = -1;
+static pthread_t power_thread;
+
+static uint64_t power_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int power_read_long(int fd, long *val)
+{
+	char buf[32];
+	ssize_t len;
+
+	len = pread(fd, buf, sizeof(buf) - 1, 0);
+	if (len <= 0)
+		return -1;
+
+	buf[len] = '\0';
+	*val = strtol(buf, NULL, 10);
+	return 0;
+}
+
+static void power_sample_port(struct power_ring *ring)
+{
+	struct libtypec_power_sample *slot;
+	long volt, curr;
+	uint64_t head;
+
+	if (power_read_long(ring->volt_fd, &volt) < 0 || power_read_long(ring->curr_fd, &curr) < 0)
+		return;
+
+	head = ring->head;
+	slot = &ring->slots[head % power_capacity];
+	slot->time_ns = power_now_ns();
+	slot->voltage_uv = volt;
+	slot->current_ua = curr;
+
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void *power_sampler(void *arg)
+{
+	struct pollfd pfd[2] = {
+		{ .fd = power_timer_fd, .events = POLLIN },
+		{ .fd = power_stop_fd, .events = POLLIN },
+	};
+	uint64_t expirations;
+
+	while (poll(pfd, 2, -1) >= 0 || errno == EINTR)
+	{
+		if (pfd[1].revents)
+			break;
+
+		if (!(pfd[0].revents & POLLIN) || read(power_timer_fd, &expirations, sizeof(expirations)) != sizeof(expirations))
+			continue;
+
+		/* Missed ticks are counted, not made up for */
+		if (expirations > 1)
+			__atomic_add_fetch(&power_overruns, expirations - 1, __ATOMIC_RELAXED);
+
+		for (int i = 0; i < power_num_ports; i++)
+		{
+			if (power_rings[i].slots)
+				power_sample_port(&power_rings[i]);
+		}
+	}
+
+	return NULL;
+}
+
+static void power_close_rings(void)
+{
+	for (int i = 0; i < POWER_MAX_PORTS; i++)
+	{
+		struct power_ring *ring = &power_rings[i];
+
+		if (ring->volt_fd > 0)
+			close(ring->volt_fd);
+		if (ring->curr_fd > 0)
+			close(ring->curr_fd);
+		free(ring->slots);
+		memset(ring, 0, sizeof(*ring));
+	}
+	power_num_ports = 0;
+}
+
+/**
+ * Starts sampling the power supply of every connector.
+ *
+ * \param period_us Sampling period in microseconds
+ * \param capacity Ring slots per port, the newest capacity - 1 samples
+ *        can be read back
+ *
+ * \returns 0 on success, -EBUSY when already running, -EINVAL for bad
+ *          arguments, -ENODEV when no port has a readable power supply
+ *          or a negative errno
+ */
+int libtypec_power_sampler_start(unsigned int period_us, unsigned int capacity)
+{
+	struct libtypec_capability_data cap;
+	struct itimerspec its = {0};
+	char dir[512], path[512 + 16];
+	int num_sampled = 0, ret;
+
+	if (power_timer_fd >= 0)
+		return -EBUSY;
+
+	if (!period_us || capacity < 2)
+		return -EINVAL;
+
+	ret = libtypec_get_capability(&cap);
+	if (ret < 0)
+		return ret;
+
+	power_capacity = capacity;
+	power_num_ports = cap.bNumConnectors < POWER_MAX_PORTS ? cap.bNumConnectors : POWER_MAX_PORTS;
+	power_overruns = 0;
+
+	for (int i = 0; i < power_num_ports; i++)
+	{
+		struct power_ring *ring = &power_rings[i];
+
+		if (libtypec_psy_map_lookup(i, dir, sizeof(dir)) < 0)
+			continue;
+
+		snprintf(path, sizeof(path), "%s/voltage_now", dir);
+		ring->volt_fd = open(path, O_RDONLY | O_CLOEXEC);
+		snprintf(path, sizeof(path), "%s/current_now", dir);
+		ring->curr_fd = open(path, O_RDONLY | O_CLOEXEC);
+
+		if (ring->volt_fd < 0 || ring->curr_fd < 0)
+			continue;
+
+		ring->slots = calloc(capacity, sizeof(*ring->slots));
+		if (!ring->slots)
+		{
+			ret = -ENOMEM;
+			goto err;
+		}
+		num_sampled++;
+	}
+
+	if (!num_sampled)
+	{
+		ret = -ENODEV;
+		goto err;
+	}
+
+	power_timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC);
+	power_stop_fd = eventfd(0, EFD_CLOEXEC);
+	if (power_timer_fd < 0 || power_stop_fd < 0)
+	{
+		ret = -errno;
+		goto err;
+	}
+
+	its.it_interval.tv_sec = period_us / 1000000;
+	its.it_interval.tv_nsec = (period_us % 1000000) * 1000;
+	its.it_value = its.it_interval;
+	if (timerfd_settime(power_timer_fd, 0, &its, NULL) < 0)
+	{
+		ret = -errno;
+		goto err;
+	}
+
+	ret = -pthread_create(&power_thread, NULL, power_sampler, NULL);
+	if (ret < 0)
+		goto err;
+
+	return 0;
+
+err:
+	if (power_timer_fd >= 0)
+		close(power_timer_fd);
+	if (power_stop_fd >= 0)
+		close(power_stop_fd);
+	power_timer_fd = power_stop_fd = -1;
+	power_close_rings();
+	return ret;
+}
+
+/**
+ * Stops the sampler and releases every ring.
+ *
+ * \returns 0 on success, -EINVAL when not running
+ */
+int libtypec_power_sampler_stop(void)
+{
+	uint64_t one = 1;
+
+	if (power_timer_fd < 0)
+		return -EINVAL;
+
+	if (write(power_stop_fd, &one, sizeof(one)) != sizeof(one))
+		return -errno;
+	pthread_join(power_thread, NULL);
+
+	close(power_timer_fd);
+	close(power_stop_fd);
+	power_timer_fd = power_stop_fd = -1;
+	power_close_rings();
+	return 0;
+}
+
+/**
+ * Copies the most recent samples of a port, oldest first.
+ *
+ * \param conn_num Connector
+ * \param since_ns Only samples taken after this CLOCK_MONOTONIC time, 0
+ *        for every sample still in the ring
+ * \param samples Filled with up to max_samples samples
+ * \param max_samples Size of samples
+ *
+ * \returns Number of samples copied, or -EINVAL when the port is not
+ *          sampled
+ */
+int libtypec_power_sampler_read(int conn_num, uint64_t since_ns, struct libtypec_power_sample *samples, int max_samples)
+{
+	struct power_ring *ring;
+	uint64_t first, end, copied, oldest;
+	int num = 0;
+
+	if (power_timer_fd < 0 || conn_num < 0 || conn_num >= power_num_ports || !power_rings[conn_num].slots || max_samples <= 0)
+		return -EINVAL;
+
+	/*
+	 * The writer fills slot head % capacity before publishing head + 1, so
+	 * the slot of the oldest sample may be under rewrite at any time and at
+	 * most capacity - 1 samples are stable.
+	 */
+	ring = &power_rings[conn_num];
+	end = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	first = end >= power_capacity ? end - (power_capacity - 1) : 0;
+	if (end - first > (uint64_t)max_samples)
+		first = end - max_samples;
+
+	copied = end - first;
+	for (uint64_t i = 0; i < copied; i++)
+		samples[i] = ring->slots[(first + i) % power_capacity];
+
+	/* Samples below head + 1 - capacity may have been rewritten while copied */
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+	end = __atomic_load_n(&ring->head, __ATOMIC_RELAXED) + 1;
+	oldest = end > first + power_capacity ? end - power_capacity - first : 0;
+
+	for (uint64_t i = oldest; i < copied; i++)
+	{
+		if (samples[i].time_ns > since_ns)
+			samples[num++] = samples[i];
+	}
+
+	return num;
+}
+
+static int power_cmp(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+/**
+ * Summarizes the samples of a port over a window ending now.
+ *
+ * \param conn_num Connector
+ * \param window_ns Window length, 0 for every sample still in the ring
+ * \param percentile Percentile of power to report, 0 to 100
+ * \param stats Filled with the summary
+ *
+ * \returns Number of samples in the window, or -EINVAL
+ */
+int libtypec_power_sampler_stats(int conn_num, uint64_t window_ns, unsigned int percentile, struct libtypec_power_stats *stats)
+{
+	struct libtypec_power_sample *samples;
+	uint32_t *power;
+	uint64_t now = power_now_ns(), sum = 0;
+	int num;
+
+	if (percentile > 100 || !stats || power_timer_fd < 0)
+		return -EINVAL;
+
+	samples = malloc(power_capacity * sizeof(*samples));
+	power = malloc(power_capacity * sizeof(*power));
+	if (!samples || !power)
+	{
+		free(samples);
+		free(power);
+		return -ENOMEM;
+	}
+
+	num = libtypec_power_sampler_read(conn_num, window_ns && window_ns < now ? now - window_ns : 0, samples, power_capacity);
+
+	memset(stats, 0, sizeof(*stats));
+	if (num > 0)
+	{
+		stats->num_samples = num;
+		stats->min_mw = UINT32_MAX;
+		stats->min_mv = UINT32_MAX;
+
+		for (int i = 0; i < num; i++)
+		{
+			int64_t mw = (int64_t)samples[i].voltage_uv * samples[i].current_ua / 1000000000;
+
+			power[i] = mw > 0 ? mw : 0;
+			sum += power[i];
+
+			if (power[i] < stats->min_mw)
+				stats->min_mw = power[i];
+			if (power[i] > stats->max_mw)
+				stats->max_mw = power[i];
+			if (samples[i].voltage_uv / 1000 < stats->min_mv)
+				stats->min_mv = samples[i].voltage_uv / 1000;
+			if (samples[i].voltage_uv / 1000 > stats->max_mv)
+				stats->max_mv = samples[i].voltage_uv / 1000;
+
+			/* Trapezoidal integration, mW * ns = 1e-12 J */
+			if (i)
+				stats->energy_uj += (uint64_t)(power[i] + power[i - 1]) * (samples[i].time_ns - samples[i - 1].time_ns) / 2000000;
+		}
+
+		stats->mean_mw = sum / num;
+		stats->duration_ns = samples[num - 1].time_ns - samples[0].time_ns;
+
+		qsort(power, num, sizeof(*power), power_cmp);
+		stats->percentile_mw = power[(uint64_t)(num - 1) * percentile / 100];
+	}
+	stats->overruns = __atomic_load_n(&power_overruns, __ATOMIC_RELAXED);
+
+	free(samples);
+	free(power);
+	return num;
+}
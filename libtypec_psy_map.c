@@ -0,0 +1,331 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_psy_map.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Association of power_supply devices with Type-C ports
+ *
+ * Port controllers register the power supply of a connector under their
+ * own device (UCSI, TCPM) or under a sibling of the device carrying the
+ * typec ports (cros_ec). The map pairs every group of typec ports sharing
+ * a parent device with the group of USB power supplies whose device is
+ * the closest relative of that parent, in port and supply number order.
+ * It is built once and rebuilt lazily after power_supply or typec
+ * uevents, when reading a mapped supply fails, and at most once a second
+ * while a looked up port has no supply, which may register late (TCPM,
+ * modules loaded after init).
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <time.h>
+
+#define PSY_MAP_MAX_PORTS 32
+#define PSY_MAP_MAX_SUPPLIES 64
+#define PSY_NAME_LEN 64
+
+#define PSY_MAP_RETRY_NS 1000000000ull
+
+/* Ancestors shallower than /sys/devices/<bus>/<device> relate everything */
+#define PSY_MIN_COMMON_DEPTH 4
+
+struct psy_map_dev
+{
+	char name[PSY_NAME_LEN];
+	char parent[PATH_MAX];
+	int num;
+	int rank;
+};
+
+static char psy_map[PSY_MAP_MAX_PORTS][PSY_NAME_LEN];
+static int psy_map_stale = 1;
+static uint64_t psy_map_built_ns;
+static pthread_mutex_t psy_map_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* Trailing number of a sysfs name, port3 -> 3, CROS_USBPD_CHARGER1 -> 1 */
+static int psy_map_name_num(const char *name)
+{
+	const char *p = name + strlen(name);
+
+	while (p > name && isdigit((unsigned char)p[-1]))
+		p--;
+
+	return *p ? atoi(p) : 0;
+}
+
+/* Device owning a class device, <dev>/<class>/<name> -> <dev> */
+static int psy_map_parent(const char *class_path, const char *name, char *parent)
+{
+	char link[PATH_MAX], *p;
+
+	snprintf(link, sizeof(link), "%s/%s", class_path, name);
+	if (!realpath(link, parent))
+		return -1;
+
+	for (int i = 0; i < 2; i++)
+	{
+		p = strrchr(parent, '/');
+		if (!p || p == parent)
+			return -1;
+		*p = '\0';
+	}
+
+	return 0;
+}
+
+static int psy_map_is_usb(const char *name)
+{
+	char path[PATH_MAX], type[16] = {0};
+	FILE *fp;
+
+	snprintf(path, sizeof(path), SYSFS_PSY_PATH "/%s/type", name);
+	fp = fopen(path, "r");
+	if (!fp)
+		return 0;
+
+	if (!fgets(type, sizeof(type), fp))
+		type[0] = '\0';
+	fclose(fp);
+
+	return strncmp(type, "USB", 3) == 0;
+}
+
+/* Number of leading path components two sysfs paths have in common */
+static int psy_map_common_depth(const char *a, const char *b)
+{
+	int depth = 0;
+
+	while (1)
+	{
+		size_t len_a, len_b;
+
+		while (*a == '/')
+			a++;
+		while (*b == '/')
+			b++;
+
+		len_a = strcspn(a, "/");
+		len_b = strcspn(b, "/");
+		if (!len_a || len_a != len_b || memcmp(a, b, len_a))
+			return depth;
+
+		depth++;
+		a += len_a;
+		b += len_b;
+	}
+}
+
+/* Rank every entry among those sharing its parent, by trailing number */
+static void psy_map_rank(struct psy_map_dev *devs, int num)
+{
+	for (int i = 0; i < num; i++)
+	{
+		devs[i].rank = 0;
+		for (int j = 0; j < num; j++)
+		{
+			if (strcmp(devs[i].parent, devs[j].parent) == 0 && devs[j].num < devs[i].num)
+				devs[i].rank++;
+		}
+	}
+}
+
+static int psy_map_scan(const char *class_path, int (*filter)(const char *), struct psy_map_dev *devs, int max)
+{
+	DIR *dir = opendir(class_path);
+	struct dirent *entry;
+	int num = 0;
+
+	if (!dir)
+		return 0;
+
+	while ((entry = readdir(dir)) && num < max)
+	{
+		if (entry->d_name[0] == '.' || strlen(entry->d_name) >= PSY_NAME_LEN)
+			continue;
+
+		if (!filter(entry->d_name))
+			continue;
+
+		if (psy_map_parent(class_path, entry->d_name, devs[num].parent) < 0)
+			continue;
+
+		strcpy(devs[num].name, entry->d_name);
+		devs[num].num = psy_map_name_num(entry->d_name);
+		num++;
+	}
+	closedir(dir);
+
+	psy_map_rank(devs, num);
+	return num;
+}
+
+static int psy_map_is_port(const char *name)
+{
+	int port;
+	char c;
+
+	return sscanf(name, "port%d%c", &port, &c) == 1 && port < PSY_MAP_MAX_PORTS;
+}
+
+static uint64_t psy_map_now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static void psy_map_build(void)
+{
+	struct psy_map_dev *ports, *psys;
+	int num_ports, num_psys;
+
+	psy_map_built_ns = psy_map_now_ns();
+
+	memset(psy_map, 0, sizeof(psy_map));
+
+	ports = calloc(PSY_MAP_MAX_PORTS, sizeof(*ports));
+	psys = calloc(PSY_MAP_MAX_SUPPLIES, sizeof(*psys));
+	if (!ports || !psys)
+		goto out;
+
+	num_ports = psy_map_scan(SYSFS_TYPEC_PATH, psy_map_is_port, ports, PSY_MAP_MAX_PORTS);
+	num_psys = psy_map_scan(SYSFS_PSY_PATH, psy_map_is_usb, psys, PSY_MAP_MAX_SUPPLIES);
+
+	for (int i = 0; i < num_ports; i++)
+	{
+		int best = -1, best_depth = PSY_MIN_COMMON_DEPTH - 1;
+
+		/* Closest supply group first, then the supply of the same rank */
+		for (int j = 0; j < num_psys; j++)
+		{
+			int depth = psy_map_common_depth(ports[i].parent, psys[j].parent);
+
+			if (depth > best_depth)
+			{
+				best_depth = depth;
+				best = -1;
+			}
+			if (depth == best_depth && psys[j].rank == ports[i].rank)
+				best = j;
+		}
+
+		if (best >= 0)
+			strcpy(psy_map[ports[i].num], psys[best].name);
+	}
+
+out:
+	free(ports);
+	free(psys);
+	__atomic_store_n(&psy_map_stale, 0, __ATOMIC_RELEASE);
+}
+
+/**
+ * Marks the power supply map out of date, it is rebuilt on next lookup.
+ */
+void libtypec_psy_map_invalidate(void)
+{
+	__atomic_store_n(&psy_map_stale, 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * Looks up the power supply of a Type-C port.
+ *
+ * \param conn_num Connector
+ * \param path Filled with the power supply's sysfs directory
+ * \param len Size of path
+ *
+ * The path is not checked, callers invalidate the map when reading the
+ * supply fails.
+ *
+ * \returns 0 on success, -ENODEV when no supply is associated with the port
+ */
+int libtypec_psy_map_lookup(int conn_num, char *path, size_t len)
+{
+	int ret = -ENODEV;
+
+	if (conn_num < 0 || conn_num >= PSY_MAP_MAX_PORTS)
+		return -EINVAL;
+
+	pthread_mutex_lock(&psy_map_lock);
+
+	if (__atomic_load_n(&psy_map_stale, __ATOMIC_ACQUIRE) ||
+	    (!psy_map[conn_num][0] && psy_map_now_ns() - psy_map_built_ns >= PSY_MAP_RETRY_NS))
+		psy_map_build();
+
+	if (psy_map[conn_num][0])
+	{
+		snprintf(path, len, SYSFS_PSY_PATH "/%s", psy_map[conn_num]);
+		ret = 0;
+	}
+
+	pthread_mutex_unlock(&psy_map_lock);
+	return ret;
+}
+
+/**
+ * This function shall be used to find the Type-C port a power supply
+ * belongs to
+ *
+ * \param psy_name Name of the power_supply class device
+ *
+ * \returns Connector number, or -ENODEV when the supply is not a port's
+ */
+int libtypec_get_power_supply_port(const char *psy_name)
+{
+	int ret = -ENODEV;
+
+	pthread_mutex_lock(&psy_map_lock);
+
+	/* An unknown USB supply may be new, other supplies never map */
+	for (int pass = 0; pass < 2 && ret < 0; pass++)
+	{
+		if (pass && !psy_map_is_usb(psy_name))
+			break;
+
+		if (pass || __atomic_load_n(&psy_map_stale, __ATOMIC_ACQUIRE))
+			psy_map_build();
+
+		for (int i = 0; i < PSY_MAP_MAX_PORTS; i++)
+		{
+			if (psy_map[i][0] && strcmp(psy_map[i], psy_name) == 0)
+			{
+				ret = i;
+				break;
+			}
+		}
+	}
+
+	pthread_mutex_unlock(&psy_map_lock);
+	return ret;
+}
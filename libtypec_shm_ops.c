@@ -0,0 +1,621 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_shm_ops.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Shared memory publication of decoded port state
+ *
+ * One publisher process collects the topology through the native backend
+ * and stores it in a memory mapped region. Every other libtypec session on
+ * the host maps the same region read-only and serves queries from it. Each
+ * port is guarded by its own sequence lock, so a reader costs a handful of
+ * cache line loads and never enters the kernel. When no publisher is alive
+ * readers fall back to the native backend.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+
+#define LIBTYPEC_SHM_MAGIC 0x43505954	/* "TYPC" */
+#define LIBTYPEC_SHM_VERSION 1
+#define LIBTYPEC_SHM_MAX_PORTS 16
+#define LIBTYPEC_SHM_MAX_SPIN 100000
+#define LIBTYPEC_SHM_LIVENESS_NS 1000000000ull
+
+struct libtypec_shm_port
+{
+	unsigned int seq;
+	struct libtypec_port_state state;
+} __attribute__((aligned(64)));
+
+struct libtypec_shm_region
+{
+	unsigned int magic;
+	unsigned int version;
+	unsigned int size;
+	int publisher_pid;
+	unsigned int online;
+	unsigned int num_ports;
+	unsigned int seq;
+	struct libtypec_capability_data cap;
+	struct libtypec_shm_port port[LIBTYPEC_SHM_MAX_PORTS];
+};
+
+static struct libtypec_shm_region *shm_region;
+static const struct libtypec_os_backend *shm_fallback;
+static uint64_t shm_checked_ns;
+static int shm_publisher_gone;
+
+static struct libtypec_shm_region *pub_region;
+static const struct libtypec_os_backend *pub_backend;
+static int pub_fd = -1;
+
+/*
+ * Sequence lock helpers. The writer makes the sequence odd while it
+ * updates the data, readers retry until they see the same even value
+ * before and after their copy.
+ */
+static void shm_write_begin(unsigned int *seq)
+{
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void shm_write_end(unsigned int *seq)
+{
+	__atomic_store_n(seq, *seq + 1, __ATOMIC_RELEASE);
+}
+
+static int shm_read_begin(const unsigned int *seq, unsigned int *start)
+{
+	int spin = 0;
+
+	while ((*start = __atomic_load_n(seq, __ATOMIC_ACQUIRE)) & 1)
+	{
+		/* A publisher that died mid update leaves the lock odd */
+		if (++spin > LIBTYPEC_SHM_MAX_SPIN)
+			return -EAGAIN;
+	}
+
+	return 0;
+}
+
+static int shm_read_retry(const unsigned int *seq, unsigned int start)
+{
+	__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+	return __atomic_load_n(seq, __ATOMIC_RELAXED) != start;
+}
+
+static int shm_read(const unsigned int *seq, void *dst, const void *src, size_t len)
+{
+	unsigned int start;
+
+	do
+	{
+		if (shm_read_begin(seq, &start) < 0)
+			return -EAGAIN;
+
+		memcpy(dst, src, len);
+
+	} while (shm_read_retry(seq, start));
+
+	return 0;
+}
+
+static int shm_publisher_alive(int pid)
+{
+	return pid > 0 && (kill(pid, 0) == 0 || errno == EPERM);
+}
+
+/*
+ * A publisher that crashed never clears online, so its pid is checked
+ * again once a second. The coarse clock is read without a syscall.
+ */
+static int shm_online(void)
+{
+	struct timespec ts;
+	uint64_t now;
+
+	if (!shm_region || __atomic_load_n(&shm_publisher_gone, __ATOMIC_RELAXED) ||
+	    !__atomic_load_n(&shm_region->online, __ATOMIC_ACQUIRE))
+		return 0;
+
+	clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+	now = (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+
+	if (now - __atomic_load_n(&shm_checked_ns, __ATOMIC_RELAXED) >= LIBTYPEC_SHM_LIVENESS_NS)
+	{
+		__atomic_store_n(&shm_checked_ns, now, __ATOMIC_RELAXED);
+		if (!shm_publisher_alive(shm_region->publisher_pid))
+		{
+			__atomic_store_n(&shm_publisher_gone, 1, __ATOMIC_RELAXED);
+			return 0;
+		}
+	}
+
+	return 1;
+}
+
+static const struct libtypec_shm_port *shm_port(int conn_num)
+{
+	if (!shm_online() || conn_num < 0 || conn_num >= (int)shm_region->num_ports ||
+	    conn_num >= LIBTYPEC_SHM_MAX_PORTS)
+		return NULL;
+
+	return &shm_region->port[conn_num];
+}
+
+/**
+ * Maps the published region if a live publisher exists. Only a region
+ * owned by root or by the caller and writable by nobody else is trusted,
+ * every count read from it is still clamped before use.
+ *
+ * \returns 0 when the shared memory backend can be used
+ */
+int libtypec_shm_attach(void)
+{
+	struct libtypec_shm_region *region;
+	struct stat sb;
+	int fd;
+
+	fd = open(LIBTYPEC_SHM_PATH, O_RDONLY | O_CLOEXEC | O_NOFOLLOW);
+	if (fd < 0)
+		return -1;
+
+	if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode) || (sb.st_uid != 0 && sb.st_uid != geteuid()) ||
+	    (sb.st_mode & (S_IWGRP | S_IWOTH)) || sb.st_size < (off_t)sizeof(struct libtypec_shm_region))
+	{
+		close(fd);
+		return -1;
+	}
+
+	region = mmap(NULL, sizeof(*region), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (region == MAP_FAILED)
+		return -1;
+
+	if (region->magic != LIBTYPEC_SHM_MAGIC || region->version != LIBTYPEC_SHM_VERSION ||
+	    region->size != sizeof(*region) || !region->online ||
+	    !shm_publisher_alive(region->publisher_pid))
+	{
+		munmap(region, sizeof(*region));
+		return -1;
+	}
+
+	shm_region = region;
+	shm_publisher_gone = 0;
+	shm_checked_ns = 0;
+
+	return 0;
+}
+
+static int libtypec_shm_init(char **session_info)
+{
+	int method;
+
+	/* Only needed when the publisher goes away or for uncached ops */
+	shm_fallback = libtypec_get_native_backend(&method);
+
+	return 0;
+}
+
+static int libtypec_shm_exit(void)
+{
+	if (shm_region)
+		munmap(shm_region, sizeof(*shm_region));
+	shm_region = NULL;
+
+	if (shm_fallback)
+		libtypec_put_native_backend();
+	shm_fallback = NULL;
+
+	return 0;
+}
+
+static int libtypec_shm_get_capability_ops(struct libtypec_capability_data *cap_data)
+{
+	if (shm_online() && shm_read(&shm_region->seq, cap_data, &shm_region->cap, sizeof(*cap_data)) == 0)
+		return 0;
+
+	if (!shm_fallback || !shm_fallback->get_capability_ops)
+		return -EIO;
+
+	return shm_fallback->get_capability_ops(cap_data);
+}
+
+static int libtypec_shm_get_conn_capability_ops(int conn_num, struct libtypec_connector_cap_data *conn_cap_data)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+
+	if (p && shm_read(&p->seq, conn_cap_data, &p->state.conn_cap, sizeof(*conn_cap_data)) == 0)
+		return 0;
+
+	if (!shm_fallback || !shm_fallback->get_conn_capability_ops)
+		return -EIO;
+
+	return shm_fallback->get_conn_capability_ops(conn_num, conn_cap_data);
+}
+
+static int libtypec_shm_get_alternate_modes(int recipient, int conn_num, struct altmode_data *alt_mode_data)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+	unsigned int seq;
+	int num = 0;
+
+	if (p && recipient >= AM_CONNECTOR && recipient <= AM_SOP_PR)
+	{
+		do
+		{
+			if (shm_read_begin(&p->seq, &seq) < 0)
+				goto fallback;
+
+			num = p->state.num_am[recipient];
+			if (num < 0)
+				num = 0;
+			if (num > LIBTYPEC_MAX_ALTMODES)
+				num = LIBTYPEC_MAX_ALTMODES;
+			memcpy(alt_mode_data, p->state.am[recipient], num * sizeof(struct altmode_data));
+
+		} while (shm_read_retry(&p->seq, seq));
+
+		return num;
+	}
+
+fallback:
+
+	if (!shm_fallback || !shm_fallback->get_alternate_modes)
+		return -EIO;
+
+	return shm_fallback->get_alternate_modes(recipient, conn_num, alt_mode_data);
+}
+
+static int libtypec_shm_get_cam_supported_ops(int conn_num, char *cam_data)
+{
+	if (!shm_fallback || !shm_fallback->get_cam_supported_ops)
+		return -EIO;
+
+	return shm_fallback->get_cam_supported_ops(conn_num, cam_data);
+}
+
+static int libtypec_shm_get_current_cam_ops(char *cur_cam_data)
+{
+	if (!shm_fallback || !shm_fallback->get_current_cam_ops)
+		return -EIO;
+
+	return shm_fallback->get_current_cam_ops(cur_cam_data);
+}
+
+static int libtypec_shm_get_pdos_ops(int conn_num, int partner, int offset, int *num_pdo, int src_snk, int type, unsigned int *pdo_data)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+	int idx = ((partner ? 1 : 0) << 1) | (src_snk ? 1 : 0);
+	unsigned int seq;
+	int num = 0;
+
+	if (p && offset >= 0 && offset < LIBTYPEC_MAX_PDOS && type == 0)
+	{
+		do
+		{
+			if (shm_read_begin(&p->seq, &seq) < 0)
+				goto fallback;
+
+			num = p->state.num_pdos[idx];
+			if (num > LIBTYPEC_MAX_PDOS)
+				num = LIBTYPEC_MAX_PDOS;
+			num -= offset;
+			if (num < 0)
+				num = 0;
+			memcpy(pdo_data, &p->state.pdos[idx][offset], num * sizeof(unsigned int));
+
+		} while (shm_read_retry(&p->seq, seq));
+
+		*num_pdo = num;
+		return num;
+	}
+
+fallback:
+
+	if (!shm_fallback || !shm_fallback->get_pdos_ops)
+		return -EIO;
+
+	return shm_fallback->get_pdos_ops(conn_num, partner, offset, num_pdo, src_snk, type, pdo_data);
+}
+
+static int libtypec_shm_get_cable_properties_ops(int conn_num, struct libtypec_cable_property *cbl_prop_data)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+	unsigned int seq, valid;
+
+	if (p)
+	{
+		do
+		{
+			if (shm_read_begin(&p->seq, &seq) < 0)
+				goto fallback;
+
+			valid = p->state.valid;
+			*cbl_prop_data = p->state.cable_prop;
+
+		} while (shm_read_retry(&p->seq, seq));
+
+		return (valid & LIBTYPEC_STATE_CABLE) ? 0 : -1;
+	}
+
+fallback:
+
+	if (!shm_fallback || !shm_fallback->get_cable_properties_ops)
+		return -EIO;
+
+	return shm_fallback->get_cable_properties_ops(conn_num, cbl_prop_data);
+}
+
+static int libtypec_shm_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+
+	if (p && shm_read(&p->seq, conn_sts, &p->state.conn_sts, sizeof(*conn_sts)) == 0)
+		return 0;
+
+	if (!shm_fallback || !shm_fallback->get_connector_status_ops)
+		return -EIO;
+
+	return shm_fallback->get_connector_status_ops(conn_num, conn_sts);
+}
+
+static int libtypec_shm_get_pd_message_ops(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp)
+{
+	const struct libtypec_shm_port *p = shm_port(conn_num);
+	union libtypec_discovered_identity id;
+	unsigned int seq, valid, bit;
+
+	if (p && resp_type == DISCOVER_ID_REQ && (recipient == AM_SOP || recipient == AM_SOP_PR))
+	{
+		bit = (recipient == AM_SOP) ? LIBTYPEC_STATE_ID_SOP : LIBTYPEC_STATE_ID_SOP_PR;
+
+		do
+		{
+			if (shm_read_begin(&p->seq, &seq) < 0)
+				goto fallback;
+
+			valid = p->state.valid;
+			id = p->state.id[recipient - 1];
+
+		} while (shm_read_retry(&p->seq, seq));
+
+		if (!(valid & bit))
+			return -1;
+
+		if (num_bytes > (int)sizeof(id) || num_bytes < 0)
+			num_bytes = sizeof(id);
+		memcpy(pd_msg_resp, id.buf_disc_id, num_bytes);
+		return 0;
+	}
+
+fallback:
+
+	if (!shm_fallback || !shm_fallback->get_pd_message_ops)
+		return -EIO;
+
+	return shm_fallback->get_pd_message_ops(recipient, conn_num, num_bytes, resp_type, pd_msg_resp);
+}
+
+static int libtypec_shm_get_bb_status(unsigned int *num_bb_instance)
+{
+	if (!shm_fallback || !shm_fallback->get_bb_status)
+		return -EIO;
+
+	return shm_fallback->get_bb_status(num_bb_instance);
+}
+
+static int libtypec_shm_get_bb_data(int num_billboards, char *bb_data)
+{
+	if (!shm_fallback || !shm_fallback->get_bb_data)
+		return -EIO;
+
+	return shm_fallback->get_bb_data(num_billboards, bb_data);
+}
+
+static void libtypec_shm_monitor_events(void)
+{
+	if (!shm_fallback || !shm_fallback->monitor_events)
+		return;
+
+	shm_fallback->monitor_events();
+}
+
+static int libtypec_shm_get_power_supply_status_ops(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+	if (!shm_fallback || !shm_fallback->get_power_supply_status_ops)
+		return -EIO;
+
+	return shm_fallback->get_power_supply_status_ops(conn_num, psy_sts);
+}
+
+/**
+ * This function creates the shared memory region and makes the calling
+ * process the publisher of port state for all other libtypec sessions.
+ *
+ * \returns 0 on success
+ */
+int libtypec_shm_publish_init(void)
+{
+	struct libtypec_shm_region *region;
+	struct stat sb;
+	int method, fd;
+
+	if (pub_region)
+		return 0;
+
+	pub_backend = libtypec_get_native_backend(&method);
+	if (!pub_backend)
+		return -EIO;
+
+	fd = open(LIBTYPEC_SHM_PATH, O_RDWR | O_CREAT | O_CLOEXEC | O_NOFOLLOW, 0644);
+	if (fd < 0)
+		goto err_backend;
+
+	/* A region planted by another user is not ours to publish into */
+	if (fstat(fd, &sb) < 0 || !S_ISREG(sb.st_mode) || sb.st_uid != geteuid() || fchmod(fd, 0644) < 0)
+		goto err_fd;
+
+	if (ftruncate(fd, sizeof(*region)) < 0)
+		goto err_fd;
+
+	region = mmap(NULL, sizeof(*region), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (region == MAP_FAILED)
+		goto err_fd;
+
+	/* Readers reject the region until magic and online are both set */
+	__atomic_store_n(&region->online, 0, __ATOMIC_RELEASE);
+	region->magic = LIBTYPEC_SHM_MAGIC;
+	region->version = LIBTYPEC_SHM_VERSION;
+	region->size = sizeof(*region);
+	region->publisher_pid = getpid();
+
+	pub_region = region;
+	pub_fd = fd;
+
+	libtypec_shm_publish_update(-1);
+
+	__atomic_store_n(&region->online, 1, __ATOMIC_RELEASE);
+
+	return 0;
+
+err_fd:
+	close(fd);
+err_backend:
+	libtypec_put_native_backend();
+	pub_backend = NULL;
+	return -EIO;
+}
+
+/**
+ * This function refreshes the published state. Publishers call it from
+ * their event handler so readers always see the current topology.
+ *
+ * \param conn_num Connector to refresh, or -1 for the capability and all
+ * connectors
+ *
+ * \returns 0 on success
+ */
+int libtypec_shm_publish_update(int conn_num)
+{
+	struct libtypec_capability_data cap;
+	struct libtypec_port_state state;
+	unsigned int num_ports;
+	int i;
+
+	if (!pub_region)
+		return -EIO;
+
+	if (conn_num < 0)
+	{
+		memset(&cap, 0, sizeof(cap));
+		if (pub_backend->get_capability_ops && pub_backend->get_capability_ops(&cap) < 0)
+			return -EIO;
+
+		num_ports = cap.bNumConnectors;
+		if (num_ports > LIBTYPEC_SHM_MAX_PORTS)
+			num_ports = LIBTYPEC_SHM_MAX_PORTS;
+
+		shm_write_begin(&pub_region->seq);
+		pub_region->cap = cap;
+		pub_region->num_ports = num_ports;
+		shm_write_end(&pub_region->seq);
+
+		for (i = 0; i < (int)num_ports; i++)
+			libtypec_shm_publish_update(i);
+
+		return 0;
+	}
+
+	if (conn_num >= (int)pub_region->num_ports)
+		return -EINVAL;
+
+	/* Collect outside of the lock, readers only wait for the copy */
+	libtypec_collect_port_state(pub_backend, conn_num, &state);
+
+	shm_write_begin(&pub_region->port[conn_num].seq);
+	pub_region->port[conn_num].state = state;
+	shm_write_end(&pub_region->port[conn_num].seq);
+
+	return 0;
+}
+
+/**
+ * This function withdraws the published state. Readers switch to their
+ * native backend on their next query.
+ *
+ * \returns 0 on success
+ */
+int libtypec_shm_publish_exit(void)
+{
+	if (!pub_region)
+		return 0;
+
+	__atomic_store_n(&pub_region->online, 0, __ATOMIC_RELEASE);
+	unlink(LIBTYPEC_SHM_PATH);
+
+	munmap(pub_region, sizeof(*pub_region));
+	close(pub_fd);
+	pub_region = NULL;
+	pub_fd = -1;
+
+	libtypec_put_native_backend();
+	pub_backend = NULL;
+
+	return 0;
+}
+
+const struct libtypec_os_backend libtypec_shm_backend = {
+	.init = libtypec_shm_init,
+	.exit = libtypec_shm_exit,
+	.get_capability_ops = libtypec_shm_get_capability_ops,
+	.get_conn_capability_ops = libtypec_shm_get_conn_capability_ops,
+	.get_alternate_modes = libtypec_shm_get_alternate_modes,
+	.get_cam_supported_ops = libtypec_shm_get_cam_supported_ops,
+	.get_current_cam_ops = libtypec_shm_get_current_cam_ops,
+	.get_pdos_ops = libtypec_shm_get_pdos_ops,
+	.get_cable_properties_ops = libtypec_shm_get_cable_properties_ops,
+	.get_connector_status_ops = libtypec_shm_get_connector_status_ops,
+	.get_pd_message_ops = libtypec_shm_get_pd_message_ops,
+	.get_bb_status = libtypec_shm_get_bb_status,
+	.get_bb_data = libtypec_shm_get_bb_data,
+	.monitor_events = libtypec_shm_monitor_events,
+	.get_power_supply_status_ops = libtypec_shm_get_power_supply_status_ops,
+};
@@ -0,0 +1,402 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_snapshot.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Writing and mapping of binary topology snapshots
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <endian.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+_Static_assert(sizeof(struct libtypec_snapshot_header) == 72, "snapshot header layout");
+_Static_assert(sizeof(struct libtypec_snapshot_port) == 64, "snapshot port layout");
+_Static_assert(sizeof(struct libtypec_snapshot_altmode) == 8, "snapshot altmode layout");
+
+static void snapshot_fill_port(const struct libtypec_port_state *state, struct libtypec_snapshot_port *port,
+			       uint32_t pdo_index, uint32_t altmode_index, uint32_t vdo_index)
+{
+	const struct libtypec_connector_cap_data *cap = &state->conn_cap;
+	const struct libtypec_connector_status *sts = &state->conn_sts;
+	const struct libtypec_cable_property *cbl = &state->cable_prop;
+	int i;
+
+	memset(port, 0, sizeof(*port));
+
+	port->valid = htole32(state->valid);
+
+	port->opr_mode = cap->opr_mode;
+	port->cap_flags = cap->provider | cap->consumer << 1 | cap->swap2dfp << 2 |
+			  cap->swap2ufp << 3 | cap->swap2src << 4 | cap->swap2snk << 5;
+	port->partner_rev = htole16(cap->partner_rev);
+	port->cable_rev = htole16(cap->cable_rev);
+
+	port->sts_change = htole16(sts->sts_change);
+	port->rdo = htole32((uint32_t)sts->rdo);
+	port->pwr_op_mode = sts->pwr_op_mode;
+	port->sts_flags = sts->connect_sts | sts->pwr_dir << 1;
+	port->ptnr_flags = sts->ptnr_flags;
+	port->ptnr_type = sts->ptnr_type;
+	port->bcdPDVer_op_mode = htole16(sts->bcdPDVer_op_mode);
+	port->bat_chrg_cap_sts = sts->bat_chrg_cap_sts;
+	port->cap_ltd_reason = sts->cap_ltd_reason;
+
+	port->cable_speed = htole16(cbl->speed_supported);
+	port->cable_current = cbl->current_capability;
+	port->cable_type = cbl->cable_type;
+	port->plug_end_type = cbl->plug_end_type;
+	port->cable_flags = cbl->vbus_support | cbl->directionality << 1 | cbl->mode_support << 2;
+	port->cable_latency = cbl->latency;
+
+	for (i = 0; i < 4; i++)
+		port->num_pdos[i] = state->num_pdos[i];
+	for (i = 0; i < 3; i++)
+		port->num_altmodes[i] = state->num_am[i];
+
+	port->pdo_index = htole32(pdo_index);
+	port->altmode_index = htole32(altmode_index);
+	port->vdo_index = htole32(vdo_index);
+}
+
+/**
+ * This function captures the topology through the current backend and
+ * writes it to @fd as a binary snapshot.
+ *
+ * \param fd File descriptor opened for writing
+ *
+ * \returns size of the snapshot in bytes on success
+ */
+int libtypec_snapshot_write(int fd)
+{
+	const struct libtypec_os_backend *backend = libtypec_get_backend();
+	struct libtypec_capability_data cap;
+	struct libtypec_snapshot_header *hdr;
+	struct libtypec_port_state *states;
+	uint32_t *pdos, *vdos;
+	struct libtypec_snapshot_altmode *ams;
+	uint32_t num_pdos = 0, num_altmodes = 0, pdo_i = 0, am_i = 0;
+	size_t size, written = 0;
+	char *buf;
+	int num_ports, i, j, k, ret;
+
+	if (!backend || !backend->get_capability_ops)
+		return -EIO;
+
+	memset(&cap, 0, sizeof(cap));
+	if (backend->get_capability_ops(&cap) < 0)
+		return -EIO;
+
+	num_ports = cap.bNumConnectors;
+
+	states = calloc(num_ports ? num_ports : 1, sizeof(*states));
+	if (!states)
+		return -ENOMEM;
+
+	for (i = 0; i < num_ports; i++)
+	{
+		libtypec_collect_port_state(backend, i, &states[i]);
+
+		for (j = 0; j < 4; j++)
+			num_pdos += states[i].num_pdos[j];
+		for (j = 0; j < 3; j++)
+			num_altmodes += states[i].num_am[j];
+	}
+
+	size = sizeof(*hdr) + num_ports * sizeof(struct libtypec_snapshot_port) +
+	       num_pdos * sizeof(uint32_t) +
+	       num_ports * 2 * LIBTYPEC_SNAPSHOT_ID_VDOS * sizeof(uint32_t) +
+	       num_altmodes * sizeof(struct libtypec_snapshot_altmode);
+
+	buf = calloc(1, size);
+	if (!buf)
+	{
+		free(states);
+		return -ENOMEM;
+	}
+
+	hdr = (struct libtypec_snapshot_header *)buf;
+	memcpy(hdr->magic, LIBTYPEC_SNAPSHOT_MAGIC, sizeof(hdr->magic));
+	hdr->version = htole16(LIBTYPEC_SNAPSHOT_VERSION);
+	hdr->header_size = htole16(sizeof(*hdr));
+	hdr->total_size = htole32(size);
+	hdr->timestamp = htole64(time(NULL));
+	hdr->bmAttributes = htole32(cap.bmAttributes);
+	hdr->bmOptionalFeatures = htole32(cap.bmOptionalFeatures);
+	hdr->bcdBCVersion = htole16(cap.bcdBCVersion);
+	hdr->bcdPDVersion = htole16(cap.bcdPDVersion);
+	hdr->bcdTypeCVersion = htole16(cap.bcdTypeCVersion);
+	hdr->num_alt_modes = cap.bNumAltModes;
+	hdr->num_ports = num_ports;
+	hdr->port_offset = htole32(sizeof(*hdr));
+	hdr->port_size = htole16(sizeof(struct libtypec_snapshot_port));
+	hdr->pdo_offset = htole32(sizeof(*hdr) + num_ports * sizeof(struct libtypec_snapshot_port));
+	hdr->num_pdos = htole32(num_pdos);
+	hdr->vdo_offset = htole32(le32toh(hdr->pdo_offset) + num_pdos * sizeof(uint32_t));
+	hdr->num_vdos = htole32(num_ports * 2 * LIBTYPEC_SNAPSHOT_ID_VDOS);
+	hdr->altmode_offset = htole32(le32toh(hdr->vdo_offset) + le32toh(hdr->num_vdos) * sizeof(uint32_t));
+	hdr->num_altmodes = htole32(num_altmodes);
+
+	pdos = (uint32_t *)(buf + le32toh(hdr->pdo_offset));
+	vdos = (uint32_t *)(buf + le32toh(hdr->vdo_offset));
+	ams = (struct libtypec_snapshot_altmode *)(buf + le32toh(hdr->altmode_offset));
+
+	for (i = 0; i < num_ports; i++)
+	{
+		struct libtypec_port_state *state = &states[i];
+		struct libtypec_snapshot_port *port = (struct libtypec_snapshot_port *)(buf + sizeof(*hdr)) + i;
+
+		snapshot_fill_port(state, port, pdo_i, am_i, i * 2 * LIBTYPEC_SNAPSHOT_ID_VDOS);
+
+		for (j = 0; j < 4; j++)
+			for (k = 0; k < state->num_pdos[j]; k++)
+				pdos[pdo_i++] = htole32(state->pdos[j][k]);
+
+		for (j = 0; j < 2; j++)
+		{
+			const struct discovered_identity *id = &state->id[j].disc_id;
+			uint32_t *vdo = &vdos[(i * 2 + j) * LIBTYPEC_SNAPSHOT_ID_VDOS];
+
+			vdo[0] = htole32(id->cert_stat);
+			vdo[1] = htole32(id->id_header);
+			vdo[2] = htole32(id->product);
+			vdo[3] = htole32(id->product_type_vdo1);
+			vdo[4] = htole32(id->product_type_vdo2);
+			vdo[5] = htole32(id->product_type_vdo3);
+		}
+
+		for (j = 0; j < 3; j++)
+			for (k = 0; k < state->num_am[j]; k++)
+			{
+				ams[am_i].svid = htole32(state->am[j][k].svid);
+				ams[am_i].vdo = htole32(state->am[j][k].vdo);
+				am_i++;
+			}
+	}
+
+	free(states);
+
+	while (written < size)
+	{
+		ret = write(fd, buf + written, size - written);
+		if (ret < 0 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+		{
+			free(buf);
+			return -EIO;
+		}
+		written += ret;
+	}
+
+	free(buf);
+
+	return size;
+}
+
+/**
+ * Expands one port of a mapped snapshot back into the decoded state
+ * collected by libtypec_collect_port_state().
+ */
+void libtypec_snapshot_port_state(const struct libtypec_snapshot_header *snap, int conn_num, struct libtypec_port_state *state)
+{
+	const struct libtypec_snapshot_port *port = libtypec_snapshot_port(snap, conn_num);
+	const struct libtypec_snapshot_altmode *am;
+	const uint32_t *pdos, *vdo;
+	int i, j, num;
+
+	memset(state, 0, sizeof(*state));
+
+	state->valid = le32toh(port->valid);
+
+	state->conn_cap.opr_mode = port->opr_mode;
+	state->conn_cap.provider = port->cap_flags & 1;
+	state->conn_cap.consumer = (port->cap_flags >> 1) & 1;
+	state->conn_cap.swap2dfp = (port->cap_flags >> 2) & 1;
+	state->conn_cap.swap2ufp = (port->cap_flags >> 3) & 1;
+	state->conn_cap.swap2src = (port->cap_flags >> 4) & 1;
+	state->conn_cap.swap2snk = (port->cap_flags >> 5) & 1;
+	state->conn_cap.partner_rev = le16toh(port->partner_rev);
+	state->conn_cap.cable_rev = le16toh(port->cable_rev);
+
+	state->conn_sts.sts_change = le16toh(port->sts_change);
+	state->conn_sts.pwr_op_mode = port->pwr_op_mode;
+	state->conn_sts.connect_sts = port->sts_flags & 1;
+	state->conn_sts.pwr_dir = (port->sts_flags >> 1) & 1;
+	state->conn_sts.ptnr_flags = port->ptnr_flags;
+	state->conn_sts.ptnr_type = port->ptnr_type;
+	state->conn_sts.rdo = le32toh(port->rdo);
+	state->conn_sts.bat_chrg_cap_sts = port->bat_chrg_cap_sts;
+	state->conn_sts.cap_ltd_reason = port->cap_ltd_reason;
+	state->conn_sts.bcdPDVer_op_mode = le16toh(port->bcdPDVer_op_mode);
+
+	state->cable_prop.speed_supported = le16toh(port->cable_speed);
+	state->cable_prop.current_capability = port->cable_current;
+	state->cable_prop.vbus_support = port->cable_flags & 1;
+	state->cable_prop.cable_type = port->cable_type;
+	state->cable_prop.directionality = (port->cable_flags >> 1) & 1;
+	state->cable_prop.plug_end_type = port->plug_end_type;
+	state->cable_prop.mode_support = (port->cable_flags >> 2) & 1;
+	state->cable_prop.latency = port->cable_latency;
+
+	for (i = 0; i < 2; i++)
+	{
+		vdo = libtypec_snapshot_identity(snap, port, AM_SOP + i);
+
+		state->id[i].disc_id.cert_stat = le32toh(vdo[0]);
+		state->id[i].disc_id.id_header = le32toh(vdo[1]);
+		state->id[i].disc_id.product = le32toh(vdo[2]);
+		state->id[i].disc_id.product_type_vdo1 = le32toh(vdo[3]);
+		state->id[i].disc_id.product_type_vdo2 = le32toh(vdo[4]);
+		state->id[i].disc_id.product_type_vdo3 = le32toh(vdo[5]);
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		am = libtypec_snapshot_altmodes(snap, port, i, &num);
+		if (num > LIBTYPEC_MAX_ALTMODES)
+			num = LIBTYPEC_MAX_ALTMODES;
+
+		for (j = 0; j < num; j++)
+		{
+			state->am[i][j].svid = le32toh(am[j].svid);
+			state->am[i][j].vdo = le32toh(am[j].vdo);
+		}
+		state->num_am[i] = num;
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		pdos = libtypec_snapshot_pdos(snap, port, i >> 1, i & 1, &num);
+		if (num > LIBTYPEC_MAX_PDOS)
+			num = LIBTYPEC_MAX_PDOS;
+
+		for (j = 0; j < num; j++)
+			state->pdos[i][j] = le32toh(pdos[j]);
+		state->num_pdos[i] = num;
+	}
+}
+
+static int snapshot_range_ok(size_t size, uint32_t offset, uint32_t count, size_t elem)
+{
+	return offset <= size && (size - offset) / elem >= count;
+}
+
+static int snapshot_ports_ok(const struct libtypec_snapshot_header *hdr)
+{
+	uint64_t pdos, ams;
+	int i, j;
+
+	for (i = 0; i < hdr->num_ports; i++)
+	{
+		const struct libtypec_snapshot_port *port = libtypec_snapshot_port(hdr, i);
+
+		pdos = le32toh(port->pdo_index);
+		for (j = 0; j < 4; j++)
+			pdos += port->num_pdos[j];
+
+		ams = le32toh(port->altmode_index);
+		for (j = 0; j < 3; j++)
+			ams += port->num_altmodes[j];
+
+		if (pdos > le32toh(hdr->num_pdos) || ams > le32toh(hdr->num_altmodes) ||
+		    (uint64_t)le32toh(port->vdo_index) + 2 * LIBTYPEC_SNAPSHOT_ID_VDOS > le32toh(hdr->num_vdos))
+			return 0;
+	}
+
+	return 1;
+}
+
+/**
+ * This function maps a snapshot file read-only and validates its layout.
+ * The returned image is accessed in place with the libtypec_snapshot_*()
+ * helpers.
+ *
+ * \param path Snapshot file
+ * \param size Returns the mapped size, needed by libtypec_snapshot_unmap()
+ *
+ * \returns mapped snapshot on success, NULL otherwise
+ */
+const struct libtypec_snapshot_header *libtypec_snapshot_map(const char *path, size_t *size)
+{
+	const struct libtypec_snapshot_header *hdr;
+	struct stat sb;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &sb) < 0 || sb.st_size < (off_t)sizeof(*hdr))
+	{
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+
+	if (map == MAP_FAILED)
+		return NULL;
+
+	hdr = map;
+
+	if (memcmp(hdr->magic, LIBTYPEC_SNAPSHOT_MAGIC, sizeof(hdr->magic)) ||
+	    le16toh(hdr->version) != LIBTYPEC_SNAPSHOT_VERSION ||
+	    le16toh(hdr->header_size) < sizeof(*hdr) ||
+	    le32toh(hdr->total_size) > (size_t)sb.st_size ||
+	    le16toh(hdr->port_size) < sizeof(struct libtypec_snapshot_port) ||
+	    !snapshot_range_ok(sb.st_size, le32toh(hdr->port_offset), hdr->num_ports, le16toh(hdr->port_size)) ||
+	    !snapshot_range_ok(sb.st_size, le32toh(hdr->pdo_offset), le32toh(hdr->num_pdos), sizeof(uint32_t)) ||
+	    !snapshot_range_ok(sb.st_size, le32toh(hdr->vdo_offset), le32toh(hdr->num_vdos), sizeof(uint32_t)) ||
+	    le32toh(hdr->num_vdos) < hdr->num_ports * 2u * LIBTYPEC_SNAPSHOT_ID_VDOS ||
+	    !snapshot_range_ok(sb.st_size, le32toh(hdr->altmode_offset), le32toh(hdr->num_altmodes), sizeof(struct libtypec_snapshot_altmode)) ||
+	    !snapshot_ports_ok(hdr))
+	{
+		munmap(map, sb.st_size);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	*size = sb.st_size;
+
+	return hdr;
+}
+
+void libtypec_snapshot_unmap(const struct libtypec_snapshot_header *snap, size_t size)
+{
+	if (snap)
+		munmap((void *)snap, size);
+}
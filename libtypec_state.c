@@ -0,0 +1,381 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_state.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Collection of decoded per-connector state from a backend
+ */
+
+#include "libtypec_ops.h"
+#include <string.h>
+#include <errno.h>
+#include <endian.h>
+
+static void collect_altmodes(const struct libtypec_os_backend *backend, int recipient, int conn_num, struct libtypec_port_state *state)
+{
+	struct altmode_data am[LIBTYPEC_AM_SCRATCH];
+	int num;
+
+	num = backend->get_alternate_modes(recipient, conn_num, am);
+	if (num <= 0)
+		return;
+
+	if (num > LIBTYPEC_MAX_ALTMODES)
+		num = LIBTYPEC_MAX_ALTMODES;
+
+	memcpy(state->am[recipient], am, num * sizeof(struct altmode_data));
+	state->num_am[recipient] = num;
+}
+
+static void collect_pdos(const struct libtypec_os_backend *backend, int conn_num, int partner, int src_snk, struct libtypec_port_state *state)
+{
+	unsigned int pdos[LIBTYPEC_MAX_PDOS * 2];
+	int idx = (partner << 1) | src_snk;
+	int num = 0;
+
+	if (backend->get_pdos_ops(conn_num, partner, 0, &num, src_snk, 0, pdos) <= 0)
+		return;
+
+	if (num > LIBTYPEC_MAX_PDOS)
+		num = LIBTYPEC_MAX_PDOS;
+
+	memcpy(state->pdos[idx], pdos, num * sizeof(unsigned int));
+	state->num_pdos[idx] = num;
+}
+
+/**
+ * Collects everything a backend reports about one connector into @state.
+ * The structure is cleared first so that two collections of an unchanged
+ * connector compare equal byte for byte.
+ *
+ * \param backend Backend to query
+ * \param conn_num Connector to collect
+ * \param state Destination
+ *
+ * \returns 0 on success
+ */
+int libtypec_collect_port_state(const struct libtypec_os_backend *backend, int conn_num, struct libtypec_port_state *state)
+{
+	memset(state, 0, sizeof(*state));
+
+	if (!backend)
+		return -1;
+
+	if (backend->get_conn_capability_ops &&
+	    backend->get_conn_capability_ops(conn_num, &state->conn_cap) >= 0)
+		state->valid |= LIBTYPEC_STATE_CONN_CAP;
+
+	if (backend->get_connector_status_ops &&
+	    backend->get_connector_status_ops(conn_num, &state->conn_sts) >= 0)
+		state->valid |= LIBTYPEC_STATE_CONN_STS;
+
+	state->cable_prop.cable_type = CABLE_TYPE_UNKNOWN;
+	state->cable_prop.plug_end_type = PLUG_TYPE_OTH;
+
+	if (backend->get_cable_properties_ops &&
+	    backend->get_cable_properties_ops(conn_num, &state->cable_prop) >= 0)
+		state->valid |= LIBTYPEC_STATE_CABLE;
+
+	if (backend->get_alternate_modes)
+	{
+		collect_altmodes(backend, AM_CONNECTOR, conn_num, state);
+		collect_altmodes(backend, AM_SOP, conn_num, state);
+		collect_altmodes(backend, AM_SOP_PR, conn_num, state);
+	}
+
+	if (backend->get_pd_message_ops)
+	{
+		if (backend->get_pd_message_ops(AM_SOP, conn_num, sizeof(state->id[0]), DISCOVER_ID_REQ, state->id[0].buf_disc_id) >= 0)
+			state->valid |= LIBTYPEC_STATE_ID_SOP;
+
+		if (backend->get_pd_message_ops(AM_SOP_PR, conn_num, sizeof(state->id[1]), DISCOVER_ID_REQ, state->id[1].buf_disc_id) >= 0)
+			state->valid |= LIBTYPEC_STATE_ID_SOP_PR;
+	}
+
+	if (backend->get_pdos_ops)
+	{
+		collect_pdos(backend, conn_num, 0, 0, state);
+		collect_pdos(backend, conn_num, 0, 1, state);
+		collect_pdos(backend, conn_num, 1, 0, state);
+		collect_pdos(backend, conn_num, 1, 1, state);
+	}
+
+	return 0;
+}
+
+struct state_emitter
+{
+	struct libtypec_state_record *records;
+	int max;
+	int num;
+};
+
+static void emit(struct state_emitter *e, int port, int object, int field, uint32_t value)
+{
+	if (e->num < e->max)
+	{
+		e->records[e->num].port = port;
+		e->records[e->num].object = object;
+		e->records[e->num].field = field;
+		e->records[e->num].value = value;
+	}
+	e->num++;
+}
+
+static void emit_port(struct state_emitter *e, int port, const struct libtypec_port_state *state)
+{
+	const struct libtypec_connector_cap_data *cap = &state->conn_cap;
+	const struct libtypec_connector_status *sts = &state->conn_sts;
+	const struct libtypec_cable_property *cbl = &state->cable_prop;
+	int i, j, f;
+
+	/* Emission order is record order, objects and fields ascending */
+	f = 0;
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, !!(state->valid & LIBTYPEC_STATE_CONN_CAP));
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->opr_mode);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->provider);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->consumer);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->swap2dfp);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->swap2ufp);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->swap2src);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->swap2snk);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->partner_rev);
+	emit(e, port, LIBTYPEC_OBJ_CONN_CAP, f++, cap->cable_rev);
+
+	f = 0;
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, !!(state->valid & LIBTYPEC_STATE_CONN_STS));
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->sts_change);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->pwr_op_mode);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->connect_sts);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->pwr_dir);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->ptnr_flags);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->ptnr_type);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, (uint32_t)sts->rdo);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->bat_chrg_cap_sts);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->cap_ltd_reason);
+	emit(e, port, LIBTYPEC_OBJ_CONN_STATUS, f++, sts->bcdPDVer_op_mode);
+
+	f = 0;
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, !!(state->valid & LIBTYPEC_STATE_CABLE));
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->speed_supported);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->current_capability);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->vbus_support);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->cable_type);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->directionality);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->plug_end_type);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->mode_support);
+	emit(e, port, LIBTYPEC_OBJ_CABLE, f++, cbl->latency);
+
+	for (i = 0; i < 2; i++)
+	{
+		const struct discovered_identity *id = &state->id[i].disc_id;
+		int obj = LIBTYPEC_OBJ_IDENTITY_SOP + i;
+		unsigned int bit = i ? LIBTYPEC_STATE_ID_SOP_PR : LIBTYPEC_STATE_ID_SOP;
+
+		f = 0;
+		emit(e, port, obj, f++, !!(state->valid & bit));
+		emit(e, port, obj, f++, id->cert_stat);
+		emit(e, port, obj, f++, id->id_header);
+		emit(e, port, obj, f++, id->product);
+		emit(e, port, obj, f++, id->product_type_vdo1);
+		emit(e, port, obj, f++, id->product_type_vdo2);
+		emit(e, port, obj, f++, id->product_type_vdo3);
+	}
+
+	for (i = 0; i < 3; i++)
+	{
+		emit(e, port, LIBTYPEC_OBJ_ALTMODE_CONNECTOR + i, 0, state->num_am[i]);
+
+		for (j = 0; j < state->num_am[i]; j++)
+		{
+			emit(e, port, LIBTYPEC_OBJ_ALTMODE_CONNECTOR + i, 2 * j + 1, state->am[i][j].svid);
+			emit(e, port, LIBTYPEC_OBJ_ALTMODE_CONNECTOR + i, 2 * j + 2, state->am[i][j].vdo);
+		}
+	}
+
+	for (i = 0; i < 4; i++)
+	{
+		emit(e, port, LIBTYPEC_OBJ_PDO_SINK + i, 0, state->num_pdos[i]);
+
+		for (j = 0; j < state->num_pdos[i]; j++)
+			emit(e, port, LIBTYPEC_OBJ_PDO_SINK + i, j + 1, state->pdos[i][j]);
+	}
+}
+
+static void emit_capability(struct state_emitter *e, const struct libtypec_capability_data *cap)
+{
+	int f = 0;
+
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bmAttributes);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bNumConnectors);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bmOptionalFeatures);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bNumAltModes);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bcdBCVersion);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bcdPDVersion);
+	emit(e, LIBTYPEC_STATE_PORT_PPM, LIBTYPEC_OBJ_CAPABILITY, f++, cap->bcdTypeCVersion);
+}
+
+static int emit_result(struct state_emitter *e)
+{
+	return e->num > e->max ? -ENOSPC : e->num;
+}
+
+/**
+ * This function captures the decoded state of all connectors as a sorted
+ * record set suitable for libtypec_state_diff(). Size @records with
+ * LIBTYPEC_STATE_RECORDS_PER_PORT per connector plus one port for the PPM.
+ *
+ * \param records Caller provided record buffer
+ * \param max_records Capacity of @records
+ *
+ * \returns number of records on success, -ENOSPC when @records is too small
+ */
+int libtypec_state_capture(struct libtypec_state_record *records, int max_records)
+{
+	const struct libtypec_os_backend *backend = libtypec_get_backend();
+	struct state_emitter e = { records, max_records, 0 };
+	struct libtypec_capability_data cap;
+	struct libtypec_port_state state;
+	int i;
+
+	if (!backend || !backend->get_capability_ops)
+		return -EIO;
+
+	memset(&cap, 0, sizeof(cap));
+	if (backend->get_capability_ops(&cap) < 0)
+		return -EIO;
+
+	for (i = 0; i < cap.bNumConnectors; i++)
+	{
+		libtypec_collect_port_state(backend, i, &state);
+		emit_port(&e, i, &state);
+	}
+
+	emit_capability(&e, &cap);
+
+	return emit_result(&e);
+}
+
+/**
+ * This function captures a mapped binary snapshot as a record set, so
+ * archived topologies can be compared with each other or with a live
+ * capture.
+ *
+ * \returns number of records on success, -ENOSPC when @records is too small
+ */
+int libtypec_state_capture_snapshot(const struct libtypec_snapshot_header *snap, struct libtypec_state_record *records, int max_records)
+{
+	struct state_emitter e = { records, max_records, 0 };
+	struct libtypec_capability_data cap;
+	struct libtypec_port_state state;
+	int i;
+
+	if (!snap)
+		return -EINVAL;
+
+	for (i = 0; i < snap->num_ports; i++)
+	{
+		libtypec_snapshot_port_state(snap, i, &state);
+		emit_port(&e, i, &state);
+	}
+
+	memset(&cap, 0, sizeof(cap));
+	cap.bmAttributes = le32toh(snap->bmAttributes);
+	cap.bNumConnectors = snap->num_ports;
+	cap.bmOptionalFeatures = le32toh(snap->bmOptionalFeatures);
+	cap.bNumAltModes = snap->num_alt_modes;
+	cap.bcdBCVersion = le16toh(snap->bcdBCVersion);
+	cap.bcdPDVersion = le16toh(snap->bcdPDVersion);
+	cap.bcdTypeCVersion = le16toh(snap->bcdTypeCVersion);
+	emit_capability(&e, &cap);
+
+	return emit_result(&e);
+}
+
+static uint32_t record_key(const struct libtypec_state_record *r)
+{
+	return (uint32_t)r->port << 24 | (uint32_t)r->object << 16 | r->field;
+}
+
+static void diff_emit(struct libtypec_state_change *changes, int max_changes, int num,
+		      const struct libtypec_state_record *r, uint32_t flags, uint32_t old_value, uint32_t new_value)
+{
+	if (num >= max_changes)
+		return;
+
+	changes[num].port = r->port;
+	changes[num].object = r->object;
+	changes[num].field = r->field;
+	changes[num].flags = flags;
+	changes[num].old_value = old_value;
+	changes[num].new_value = new_value;
+}
+
+/**
+ * This function compares two record sets and reports every field whose
+ * value differs, or which exists in only one of them. Both sets are sorted
+ * by construction so the comparison is a single merge pass and allocates
+ * nothing.
+ *
+ * \param changes Caller provided change buffer
+ * \param max_changes Capacity of @changes
+ *
+ * \returns total number of changes, which exceeds @max_changes when the
+ * buffer was too small to hold all of them
+ */
+int libtypec_state_diff(const struct libtypec_state_record *old_records, int num_old,
+			const struct libtypec_state_record *new_records, int num_new,
+			struct libtypec_state_change *changes, int max_changes)
+{
+	int i = 0, j = 0, num = 0;
+	uint32_t ka, kb;
+
+	while (i < num_old || j < num_new)
+	{
+		ka = (i < num_old) ? record_key(&old_records[i]) : UINT32_MAX;
+		kb = (j < num_new) ? record_key(&new_records[j]) : UINT32_MAX;
+
+		if (i < num_old && (j >= num_new || ka < kb))
+		{
+			diff_emit(changes, max_changes, num++, &old_records[i], LIBTYPEC_STATE_REMOVED, old_records[i].value, 0);
+			i++;
+		}
+		else if (j < num_new && (i >= num_old || kb < ka))
+		{
+			diff_emit(changes, max_changes, num++, &new_records[j], LIBTYPEC_STATE_ADDED, 0, new_records[j].value);
+			j++;
+		}
+		else
+		{
+			if (old_records[i].value != new_records[j].value)
+				diff_emit(changes, max_changes, num++, &new_records[j], 0, old_records[i].value, new_records[j].value);
+			i++;
+			j++;
+		}
+	}
+
+	return num;
+}
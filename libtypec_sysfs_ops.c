@@ -49,6 +49,8 @@ SOFTWARE.
 #include <fcntl.h>
 #include <unistd.h>
 #include <libudev.h>
+#include <poll.h>
+#include <stddef.h>
 
 #define MAX_PORT_STR 7		/* port%d with 7 bit numPorts */
 #define MAX_PORT_MODE_STR 7 /* port%d with 5+2 bit numPorts */
@@ -59,6 +61,30 @@ static int num_bb_if;
 
 char bb_dev_path[MAX_BB_PATH_STORED][512];
 
+#define MAX_PSY_PORTS 16
+#define PSY_UEVENT_LEN 1024
+
+/* uevent of each connector's power supply, kept open between polls */
+static pthread_mutex_t psy_uevent_lock = PTHREAD_MUTEX_INITIALIZER;
+static int psy_uevent_fd[MAX_PSY_PORTS];
+
+static const struct
+{
+	const char *key;
+	size_t offset;
+	uint32_t bit;
+} psy_props[] = {
+	{"ONLINE=", offsetof(struct libtypec_power_supply_status, online), LIBTYPEC_PSY_ONLINE},
+	{"PRESENT=", offsetof(struct libtypec_power_supply_status, present), LIBTYPEC_PSY_PRESENT},
+	{"VOLTAGE_MIN=", offsetof(struct libtypec_power_supply_status, voltage_min), LIBTYPEC_PSY_VOLTAGE_MIN},
+	{"VOLTAGE_MAX=", offsetof(struct libtypec_power_supply_status, voltage_max), LIBTYPEC_PSY_VOLTAGE_MAX},
+	{"VOLTAGE_NOW=", offsetof(struct libtypec_power_supply_status, voltage_now), LIBTYPEC_PSY_VOLTAGE_NOW},
+	{"CURRENT_MAX=", offsetof(struct libtypec_power_supply_status, current_max), LIBTYPEC_PSY_CURRENT_MAX},
+	{"CURRENT_NOW=", offsetof(struct libtypec_power_supply_status, current_now), LIBTYPEC_PSY_CURRENT_NOW},
+	{"INPUT_CURRENT_LIMIT=", offsetof(struct libtypec_power_supply_status, input_current_limit), LIBTYPEC_PSY_INPUT_CURRENT_LIMIT},
+	{"POWER_NOW=", offsetof(struct libtypec_power_supply_status, power_now), LIBTYPEC_PSY_POWER_NOW},
+};
+
 static int get_os_type(void)
 {
 	FILE *fp = fopen("/etc/os-release", "r");
@@ -544,9 +570,11 @@ static int read_bb_bos_descriptor(int num_billboards,char * bb_data)
 	msg.timeout = 5000;
 	ret = ioctl(fd1,USBDEVFS_CONTROL,&msg);
 	len = (bb_data[3] << 8 | bb_data[2]);
+	if (len > LIBTYPEC_BB_DATA_MAX)
+		len = LIBTYPEC_BB_DATA_MAX;
 
 	memset(&msg,0,sizeof(struct usbdevfs_ctrltransfer));
-	memset(bb_data,0,512);
+	memset(bb_data,0,LIBTYPEC_BB_DATA_MAX);
 
 	msg.bRequestType = 0x80;
 	msg.bRequest = 6;
@@ -570,6 +598,15 @@ static int libtypec_sysfs_init(char **session_info)
 
 static int libtypec_sysfs_exit(void)
 {
+	pthread_mutex_lock(&psy_uevent_lock);
+	for (int i = 0; i < MAX_PSY_PORTS; i++)
+	{
+		if (psy_uevent_fd[i] > 0)
+			close(psy_uevent_fd[i]);
+		psy_uevent_fd[i] = 0;
+	}
+	pthread_mutex_unlock(&psy_uevent_lock);
+
 	return 0;
 }
 
@@ -808,64 +845,133 @@ static int libtypec_sysfs_get_cable_properties_ops(int conn_num, struct libtypec
 	return 0;
 }
 
-static int libtypec_sysfs_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+static int psy_uevent_read(int conn_num, char *buf, size_t len)
 {
-	struct stat sb;
-	struct dirent *port_entry;
-	char path_str[512], port_content[512 + 64];
-	int ret;
+	char path_str[512];
+	ssize_t ret = -1;
 
-	snprintf(path_str, sizeof(path_str), SYSFS_TYPEC_PATH "/port%d", conn_num);
+	/* The fd is shared with other threads, which may close and reopen it */
+	pthread_mutex_lock(&psy_uevent_lock);
 
-	if (lstat(path_str, &sb) == -1)
+	/* A supply that went away leaves a stale fd behind, reopen once */
+	for (int retry = 0; retry < 2 && ret < 0; retry++)
 	{
-		printf("Incorrect connector number : failed to open, %s\n", path_str);
-		return -1;
+		if (psy_uevent_fd[conn_num] <= 0)
+		{
+			if (libtypec_psy_map_lookup(conn_num, path_str, sizeof(path_str) - 7) < 0)
+				break;
+			strcat(path_str, "/uevent");
+
+			psy_uevent_fd[conn_num] = open(path_str, O_RDONLY);
+			if (psy_uevent_fd[conn_num] < 0)
+			{
+				/* The mapped supply is gone, look again with a fresh map */
+				psy_uevent_fd[conn_num] = 0;
+				libtypec_psy_map_invalidate();
+				continue;
+			}
+		}
+
+		ret = pread(psy_uevent_fd[conn_num], buf, len - 1, 0);
+		if (ret < 0)
+		{
+			close(psy_uevent_fd[conn_num]);
+			psy_uevent_fd[conn_num] = 0;
+			libtypec_psy_map_invalidate();
+		}
 	}
 
-	snprintf(path_str, sizeof(path_str), SYSFS_TYPEC_PATH "/port%d/port%d-partner", conn_num, conn_num);
+	pthread_mutex_unlock(&psy_uevent_lock);
 
-	conn_sts->connect_sts = (lstat(path_str, &sb) == -1) ? 0 : 1;
+	if (ret < 0)
+		return -ENODEV;
 
-	snprintf(path_str, sizeof(path_str), SYSFS_PSY_PATH "/ucsi-source-psy-USBC000:00%d", conn_num + 1);
+	buf[ret] = '\0';
+	return ret;
+}
 
-	if (lstat(path_str, &sb) == -1)
-	{
-		printf("Non UCSI based Type-C connector Class - PSY not supported\n:%s\n", path_str);
-		return 0;
-	}
-	else
+static int libtypec_sysfs_get_power_supply_status_ops(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+	char buf[PSY_UEVENT_LEN], *line, *next;
+	int ret;
+
+	if (conn_num < 0 || conn_num >= MAX_PSY_PORTS)
+		return -EINVAL;
+
+	ret = psy_uevent_read(conn_num, buf, sizeof(buf));
+	if (ret < 0)
+		return ret;
+
+	memset(psy_sts, 0, sizeof(*psy_sts));
+
+	for (line = buf; *line; line = next)
 	{
-		snprintf(port_content, sizeof(port_content), "%s/%s", path_str, "online");
+		next = strchr(line, '\n');
+		if (next)
+			*next++ = '\0';
+		else
+			next = line + strlen(line);
 
-		ret = get_hex_dword_from_path(port_content);
+		if (strncmp(line, "POWER_SUPPLY_", 13))
+			continue;
+		line += 13;
 
-		if (ret)
+		for (size_t i = 0; i < sizeof(psy_props) / sizeof(psy_props[0]); i++)
 		{
-			unsigned long cur, volt, op_mw, max_mw;
+			size_t key_len = strlen(psy_props[i].key);
+			char *end;
+			long val;
+
+			if (strncmp(line, psy_props[i].key, key_len))
+				continue;
 
-			snprintf(port_content, sizeof(port_content), "%s/%s", path_str, "current_now");
+			val = strtol(line + key_len, &end, 10);
+			if (end != line + key_len)
+			{
+				*(uint32_t *)((char *)psy_sts + psy_props[i].offset) = val;
+				psy_sts->valid |= psy_props[i].bit;
+			}
+			break;
+		}
+	}
 
-			cur = get_dword_from_path(port_content) / 1000;
+	return 0;
+}
+
+static int libtypec_sysfs_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	struct libtypec_power_supply_status psy;
+	struct stat sb;
+	char path_str[512];
 
-			snprintf(port_content, sizeof(port_content), "%s/%s", path_str, "voltage_now");
+	snprintf(path_str, sizeof(path_str), SYSFS_TYPEC_PATH "/port%d", conn_num);
 
-			volt = get_dword_from_path(port_content) / 1000;
+	if (lstat(path_str, &sb) == -1)
+	{
+		printf("Incorrect connector number : failed to open, %s\n", path_str);
+		return -1;
+	}
 
-			op_mw = (cur * volt) / (250 * 1000);
+	snprintf(path_str, sizeof(path_str), SYSFS_TYPEC_PATH "/port%d/port%d-partner", conn_num, conn_num);
 
-			snprintf(port_content, sizeof(port_content), "%s/%s", path_str, "current_max");
+	conn_sts->connect_sts = (lstat(path_str, &sb) == -1) ? 0 : 1;
 
-			cur = get_dword_from_path(port_content) / 1000;
+	/* Ports without a power supply report no RDO */
+	if (libtypec_sysfs_get_power_supply_status_ops(conn_num, &psy) < 0)
+		return 0;
 
-			snprintf(port_content, sizeof(port_content), "%s/%s", path_str, "voltage_max");
+	if (psy.online)
+	{
+		unsigned long op_ma, op_mw, max_mw;
 
-			volt = get_dword_from_path(port_content) / 1000;
+		/* CURRENT_NOW is negative while sourcing, the RDO carries its magnitude */
+		op_ma = psy.current_now < 0 ? -(psy.current_now / 1000) : psy.current_now / 1000;
 
-			max_mw = (cur * volt) / (250 * 1000);
+		/* mA * mV in units of 250mW */
+		op_mw = (op_ma * (psy.voltage_now / 1000)) / (250 * 1000);
+		max_mw = ((unsigned long)(psy.current_max / 1000) * (psy.voltage_max / 1000)) / (250 * 1000);
 
-			conn_sts->rdo = ((op_mw << 10)) | (max_mw)&0x3FF;
-		}
+		conn_sts->rdo = ((op_mw & 0x3FF) << 10) | (max_mw & 0x3FF);
 	}
 	return 0;
 }
@@ -1072,48 +1178,116 @@ static int libtypec_sysfs_get_bb_data(int num_billboards,char* bb_data)
 
 	ret =  libtypec_sysfs_get_bb_status(&count);
 
-	if(num_billboards >count)
+	if(num_billboards < 1 || num_billboards >count)
 		return -EINVAL;
 	ret = read_bb_bos_descriptor(num_billboards,bb_data);
 
 	return ret;
 }
 
-void libtypec_lnx_monitor_udev_events() {
+void libtypec_lnx_monitor_udev_events(void) {
     struct udev *udev = udev_new();
     struct udev_monitor *mon = udev_monitor_new_from_netlink(udev, "udev");
+    struct pollfd pfd;
 
     udev_monitor_filter_add_match_subsystem_devtype(mon, "typec", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply", NULL);
     udev_monitor_enable_receiving(mon);
 
+    // The monitor socket is non-blocking, sleep until an event arrives
+    pfd.fd = udev_monitor_get_fd(mon);
+    pfd.events = POLLIN;
+
     while (1) {
+        if (poll(&pfd, 1, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
         struct udev_device *dev = udev_monitor_receive_device(mon);
         if (dev) {
             const char *subsystem = udev_device_get_subsystem(dev);
-            enum usb_typec_event event;
-            if (strcmp(subsystem, "typec") == 0) {
+            const char *action = udev_device_get_action(dev);
+            int event = -1, event_port = -1;
+
+            // Ports and supplies coming or going change the psy map
+            if (subsystem && action && strcmp(action, "change") != 0)
+                libtypec_psy_map_invalidate();
+
+            // Partners, cables and plugs of a port invalidate its cached PD messages
+            if (subsystem && strcmp(subsystem, "typec") == 0) {
+                const char *sysname = udev_device_get_sysname(dev);
+                int port;
+
+                if (sysname && sscanf(sysname, "port%d", &port) == 1) {
+                    libtypec_dbgfs_typec_port_changed(port);
+                    event_port = port;
+                }
+            }
+
+            if (subsystem && action && strcmp(subsystem, "typec") == 0) {
                 // typec event
-                const char *action = udev_device_get_action(dev);
                 if (strcmp(action, "add") == 0) {
                     event = USBC_DEVICE_CONNECTED;
                 } else if (strcmp(action, "remove") == 0) {
                     event = USBC_DEVICE_DISCONNECTED;
+                } else if (strcmp(action, "change") == 0) {
+                    event = USBC_DEVICE_CHANGED;
                 }
             }
             udev_device_unref(dev);
 
-            // call all callbacks for this event
-            libtypec_notification_list_t* node = registered_callbacks[event];
-            while (node) {
-                node->cb_func(event, node->data);
-                node = node->next;
-            }
+            if (event < 0)
+                continue;
+
+            libtypec_notify_event(event, event_port);
         }
     }
 
+    udev_monitor_unref(mon);
     udev_unref(udev);
 }
 libtypec_notification_list_t* registered_callbacks[USBC_EVENT_COUNT] = {0};
+pthread_mutex_t registered_callbacks_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static __thread int notify_event_port = -1;
+
+// call all callbacks for this event, from a snapshot so callbacks may
+// register or unregister and other threads may do so meanwhile
+void libtypec_notify_event(enum usb_typec_event event, int port) {
+    libtypec_notification_list_t* node;
+    libtypec_notification_list_t* snapshot;
+    int num = 0;
+
+    pthread_mutex_lock(&registered_callbacks_lock);
+    for (node = registered_callbacks[event]; node; node = node->next)
+        num++;
+
+    snapshot = num ? malloc(num * sizeof(*snapshot)) : NULL;
+    num = 0;
+    for (node = snapshot ? registered_callbacks[event] : NULL; node; node = node->next)
+        snapshot[num++] = *node;
+    pthread_mutex_unlock(&registered_callbacks_lock);
+
+    notify_event_port = port;
+    for (int i = 0; i < num; i++)
+        snapshot[i].cb_func(event, snapshot[i].data);
+    notify_event_port = -1;
+
+    free(snapshot);
+}
+
+/**
+ * This function tells notification callbacks which connector the event
+ * being delivered refers to.
+ *
+ * \returns Connector number, or -1 when the event names no connector or
+ * when called outside a notification callback
+ */
+int libtypec_get_event_port(void) {
+    return notify_event_port;
+}
 
 const struct libtypec_os_backend libtypec_lnx_sysfs_backend = {
 	.init = libtypec_sysfs_init,
@@ -1129,5 +1303,6 @@ const struct libtypec_os_backend libtypec_lnx_sysfs_backend = {
 	.get_pd_message_ops = libtypec_sysfs_get_pd_message_ops,
 	.get_bb_status = libtypec_sysfs_get_bb_status,
 	.get_bb_data = libtypec_sysfs_get_bb_data,
-	.monitor_events = libtypec_lnx_monitor_udev_events
+	.monitor_events = libtypec_lnx_monitor_udev_events,
+	.get_power_supply_status_ops = libtypec_sysfs_get_power_supply_status_ops
 };
@@ -0,0 +1,374 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_typecd_ops.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Client backend forwarding libtypec operations to typecd
+ *
+ * typecd owns the kernel interfaces and keeps the topology cached. Talking
+ * to it lets unprivileged processes see debugfs quality data and keeps
+ * the UCSI command/response pair behind a single writer.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#define TYPECD_TIMEOUT_S 10
+
+/* typecd_fd and the request/response exchange on it */
+static pthread_mutex_t typecd_lock = PTHREAD_MUTEX_INITIALIZER;
+static int typecd_fd = -1;
+
+static int typecd_connect(void)
+{
+	struct sockaddr_un addr;
+	struct timeval tv = { .tv_sec = TYPECD_TIMEOUT_S };
+	int fd;
+
+	fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0)
+		return -1;
+
+	/* A stalled daemon must not hang its clients */
+	if (setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv)) < 0 ||
+	    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	strncpy(addr.sun_path, TYPECD_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+
+	if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+	{
+		close(fd);
+		return -1;
+	}
+
+	return fd;
+}
+
+/* Drops the connection and opens a new one, called with typecd_lock held */
+static void typecd_reattach(void)
+{
+	if (typecd_fd >= 0)
+		close(typecd_fd);
+	typecd_fd = typecd_connect();
+}
+
+/**
+ * Connects to a running typecd.
+ *
+ * \returns 0 when the typecd backend can be used
+ */
+int libtypec_typecd_attach(void)
+{
+	int ret;
+
+	pthread_mutex_lock(&typecd_lock);
+	typecd_reattach();
+	ret = typecd_fd < 0 ? -1 : 0;
+	pthread_mutex_unlock(&typecd_lock);
+
+	return ret;
+}
+
+/*
+ * Sends one request and receives its response. Returns the length
+ * received, -ETIMEDOUT when typecd did not answer in time, -EPIPE when
+ * the connection was lost, or -EIO.
+ */
+static ssize_t typecd_exchange(const struct typecd_request *req, struct typecd_response *resp)
+{
+	ssize_t len;
+
+	if (typecd_fd < 0)
+		return -EPIPE;
+
+	len = send(typecd_fd, req, sizeof(*req), MSG_NOSIGNAL);
+	if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return -ETIMEDOUT;
+	if (len < 0 && (errno == EPIPE || errno == ECONNRESET || errno == ENOTCONN))
+		return -EPIPE;
+	if (len != sizeof(*req))
+		return -EIO;
+
+	len = recv(typecd_fd, resp, sizeof(*resp), 0);
+	if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		return -ETIMEDOUT;
+	if (len == 0 || (len < 0 && errno == ECONNRESET))
+		return -EPIPE;
+	if (len < 0)
+		return -EIO;
+
+	return len;
+}
+
+static int typecd_call(unsigned int op, int a0, int a1, int a2, int a3, int a4, int a5, struct typecd_response *resp)
+{
+	struct typecd_request req = {
+		.op = op,
+		.args = {a0, a1, a2, a3, a4, a5},
+	};
+	ssize_t len;
+
+	pthread_mutex_lock(&typecd_lock);
+
+	len = typecd_exchange(&req, resp);
+	if (len == -EPIPE)
+	{
+		/* typecd restarted, the request is a query and safe to resend */
+		typecd_reattach();
+		len = typecd_exchange(&req, resp);
+	}
+
+	if (len == -ETIMEDOUT || len == -EPIPE)
+	{
+		/* A late answer would be taken for the next request's, start over */
+		typecd_reattach();
+	}
+
+	pthread_mutex_unlock(&typecd_lock);
+
+	if (len == -ETIMEDOUT)
+		return -ETIMEDOUT;
+
+	if (len < (ssize_t)TYPECD_RESPONSE_HDR_LEN || resp->len > len - TYPECD_RESPONSE_HDR_LEN)
+		return -EIO;
+
+	return resp->ret;
+}
+
+/* Copies a response payload, never more than the caller's buffer holds */
+static void typecd_copy_out(void *dst, const struct typecd_response *resp, int max_len)
+{
+	int len = resp->len;
+
+	if (max_len < 0)
+		max_len = 0;
+	if (len > max_len)
+		len = max_len;
+
+	memcpy(dst, resp->data, len);
+}
+
+static int libtypec_typecd_init(char **session_info)
+{
+	int ret;
+
+	pthread_mutex_lock(&typecd_lock);
+	ret = typecd_fd < 0 ? -EIO : 0;
+	pthread_mutex_unlock(&typecd_lock);
+
+	return ret;
+}
+
+static int libtypec_typecd_exit(void)
+{
+	pthread_mutex_lock(&typecd_lock);
+	if (typecd_fd >= 0)
+		close(typecd_fd);
+	typecd_fd = -1;
+	pthread_mutex_unlock(&typecd_lock);
+
+	return 0;
+}
+
+static int libtypec_typecd_get_capability_ops(struct libtypec_capability_data *cap_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CAPABILITY, 0, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0 && resp.len == sizeof(*cap_data))
+		memcpy(cap_data, resp.data, sizeof(*cap_data));
+
+	return ret;
+}
+
+static int libtypec_typecd_get_conn_capability_ops(int conn_num, struct libtypec_connector_cap_data *conn_cap_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CONN_CAPABILITY, conn_num, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0 && resp.len == sizeof(*conn_cap_data))
+		memcpy(conn_cap_data, resp.data, sizeof(*conn_cap_data));
+
+	return ret;
+}
+
+static int libtypec_typecd_get_alternate_modes(int recipient, int conn_num, struct altmode_data *alt_mode_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_ALTERNATE_MODES, recipient, conn_num, 0, 0, 0, 0, &resp);
+	if (ret > 0)
+		typecd_copy_out(alt_mode_data, &resp, (ret > LIBTYPEC_AM_SCRATCH ? LIBTYPEC_AM_SCRATCH : ret) * (int)sizeof(*alt_mode_data));
+
+	return ret;
+}
+
+static int libtypec_typecd_get_cam_supported_ops(int conn_num, char *cam_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CAM_SUPPORTED, conn_num, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0)
+		typecd_copy_out(cam_data, &resp, ret > LIBTYPEC_AM_SCRATCH ? LIBTYPEC_AM_SCRATCH : ret);
+
+	return ret;
+}
+
+static int libtypec_typecd_get_current_cam_ops(char *cur_cam_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CURRENT_CAM, 0, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0)
+		typecd_copy_out(cur_cam_data, &resp, ret > LIBTYPEC_AM_SCRATCH ? LIBTYPEC_AM_SCRATCH : ret);
+
+	return ret;
+}
+
+static int libtypec_typecd_get_pdos_ops(int conn_num, int partner, int offset, int *num_pdo, int src_snk, int type, unsigned int *pdo_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_PDOS, conn_num, partner, offset, src_snk, type, 0, &resp);
+	if (ret >= 0)
+	{
+		*num_pdo = resp.num < 0 ? 0 : resp.num > LIBTYPEC_MAX_PDOS ? LIBTYPEC_MAX_PDOS : resp.num;
+		typecd_copy_out(pdo_data, &resp, *num_pdo * (int)sizeof(*pdo_data));
+	}
+
+	return ret;
+}
+
+static int libtypec_typecd_get_cable_properties_ops(int conn_num, struct libtypec_cable_property *cbl_prop_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CABLE_PROPERTIES, conn_num, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0 && resp.len == sizeof(*cbl_prop_data))
+		memcpy(cbl_prop_data, resp.data, sizeof(*cbl_prop_data));
+
+	return ret;
+}
+
+static int libtypec_typecd_get_connector_status_ops(int conn_num, struct libtypec_connector_status *conn_sts)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_CONNECTOR_STATUS, conn_num, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0 && resp.len == sizeof(*conn_sts))
+		memcpy(conn_sts, resp.data, sizeof(*conn_sts));
+
+	return ret;
+}
+
+static int libtypec_typecd_get_pd_message_ops(int recipient, int conn_num, int num_bytes, int resp_type, char *pd_msg_resp)
+{
+	struct typecd_response resp;
+	int ret;
+
+	if (num_bytes < 0 || num_bytes > TYPECD_MAX_PAYLOAD)
+		return -EINVAL;
+
+	ret = typecd_call(TYPECD_OP_PD_MESSAGE, recipient, conn_num, num_bytes, resp_type, 0, 0, &resp);
+	if (ret >= 0)
+		typecd_copy_out(pd_msg_resp, &resp, num_bytes);
+
+	return ret;
+}
+
+static int libtypec_typecd_get_bb_status(unsigned int *num_bb_instance)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_BB_STATUS, 0, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0)
+		*num_bb_instance = resp.num;
+
+	return ret;
+}
+
+static int libtypec_typecd_get_bb_data(int num_billboards, char *bb_data)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_BB_DATA, num_billboards, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0)
+		typecd_copy_out(bb_data, &resp, LIBTYPEC_BB_DATA_MAX);
+
+	return ret;
+}
+
+static int libtypec_typecd_get_power_supply_status_ops(int conn_num, struct libtypec_power_supply_status *psy_sts)
+{
+	struct typecd_response resp;
+	int ret;
+
+	ret = typecd_call(TYPECD_OP_POWER_SUPPLY_STATUS, conn_num, 0, 0, 0, 0, 0, &resp);
+	if (ret >= 0 && resp.len == sizeof(*psy_sts))
+		memcpy(psy_sts, resp.data, sizeof(*psy_sts));
+
+	return ret;
+}
+
+const struct libtypec_os_backend libtypec_typecd_backend = {
+	.init = libtypec_typecd_init,
+	.exit = libtypec_typecd_exit,
+	.get_capability_ops = libtypec_typecd_get_capability_ops,
+	.get_conn_capability_ops = libtypec_typecd_get_conn_capability_ops,
+	.get_alternate_modes = libtypec_typecd_get_alternate_modes,
+	.get_cam_supported_ops = libtypec_typecd_get_cam_supported_ops,
+	.get_current_cam_ops = libtypec_typecd_get_current_cam_ops,
+	.get_pdos_ops = libtypec_typecd_get_pdos_ops,
+	.get_cable_properties_ops = libtypec_typecd_get_cable_properties_ops,
+	.get_connector_status_ops = libtypec_typecd_get_connector_status_ops,
+	.get_pd_message_ops = libtypec_typecd_get_pd_message_ops,
+	.get_bb_status = libtypec_typecd_get_bb_status,
+	.get_bb_data = libtypec_typecd_get_bb_data,
+	.monitor_events = libtypec_lnx_monitor_udev_events,
+	.get_power_supply_status_ops = libtypec_typecd_get_power_supply_status_ops,
+};
@@ -0,0 +1,381 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file libtypec_ucsi_trace.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Record and replay of UCSI debugfs transactions
+ *
+ * Setting LIBTYPEC_UCSI_RECORD=<file> logs every command issued by the
+ * debugfs backend together with the decoded MESSAGE_IN and the time spent in
+ * write (the kernel runs the PPM command synchronously there) and read. LIBTYPEC_UCSI_RECORD_SIZE sets the number of records kept, older
+ * records are overwritten once the ring is full.
+ *
+ * Setting LIBTYPEC_UCSI_REPLAY=<file> makes the debugfs backend answer
+ * from a recorded file instead of the kernel, waiting as long as the
+ * original transaction took multiplied by LIBTYPEC_UCSI_REPLAY_SCALE
+ * (default 1.0, 0 replays at memory speed).
+ *
+ * Transactions from several UCSI instances may interleave, each record
+ * carries the index of the instance it was issued to.
+ *
+ * File layout, all fields little endian: one ucsi_trace_header followed by
+ * capacity ucsi_trace_record slots. head is the slot written next and
+ * count the number of transactions ever recorded, so the oldest record is
+ * slot 0 until count exceeds capacity and slot head afterwards.
+ */
+
+#include "libtypec_ops.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <endian.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define UCSI_TRACE_MAGIC "UCSITRC"
+#define UCSI_TRACE_VERSION 2
+#define UCSI_TRACE_DEFAULT_RECORDS 4096
+
+struct ucsi_trace_header
+{
+	char magic[8];
+	uint16_t version;
+	uint16_t record_size;
+	uint32_t capacity;
+	uint32_t head;
+	uint32_t reserved;
+	uint64_t count;
+	uint64_t start_time;		/* CLOCK_REALTIME seconds */
+};
+
+struct ucsi_trace_record
+{
+	uint64_t command;
+	uint64_t time_ns;		/* since the start of the trace */
+	uint32_t write_ns;
+	uint32_t reserved_ns;		/* poll time of older recorders, now 0 */
+	uint32_t read_ns;
+	uint8_t status;			/* UCSI_TRACE_* */
+	uint8_t reserved;
+	uint16_t instance;		/* debugfs instance */
+	uint16_t msg_len;		/* MESSAGE_IN bytes, least significant first */
+	uint16_t reserved2[3];
+	uint8_t message_in[LIBTYPEC_UCSI_MESSAGE_IN_MAX];
+};
+
+_Static_assert(sizeof(struct ucsi_trace_header) == 40, "trace header layout");
+_Static_assert(sizeof(struct ucsi_trace_record) == 40 + LIBTYPEC_UCSI_MESSAGE_IN_MAX, "trace record layout");
+
+static struct ucsi_trace_header *trace;
+static size_t trace_size;
+static int trace_replay;
+static struct timespec trace_start;
+
+/* Instances issue commands from their own threads */
+static pthread_mutex_t trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint32_t replay_first, replay_num, replay_cursor;
+static double replay_scale = 1.0;
+
+static uint64_t ts_ns(const struct timespec *ts)
+{
+	return (uint64_t)ts->tv_sec * 1000000000ull + ts->tv_nsec;
+}
+
+static struct ucsi_trace_record *trace_slot(uint32_t slot)
+{
+	return (struct ucsi_trace_record *)(trace + 1) + slot;
+}
+
+static int trace_record_open(const char *path)
+{
+	const char *size_env = getenv("LIBTYPEC_UCSI_RECORD_SIZE");
+	unsigned long capacity = UCSI_TRACE_DEFAULT_RECORDS;
+	size_t size;
+	void *map;
+	int fd;
+
+	if (size_env && strtoul(size_env, NULL, 0) > 0)
+		capacity = strtoul(size_env, NULL, 0);
+	if (capacity > UINT32_MAX / sizeof(struct ucsi_trace_record))
+		return -EINVAL;
+
+	size = sizeof(struct ucsi_trace_header) + capacity * sizeof(struct ucsi_trace_record);
+
+	fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return -errno;
+
+	if (ftruncate(fd, size) < 0)
+	{
+		close(fd);
+		return -errno;
+	}
+
+	map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	trace = map;
+	trace_size = size;
+	memcpy(trace->magic, UCSI_TRACE_MAGIC, sizeof(trace->magic));
+	trace->version = htole16(UCSI_TRACE_VERSION);
+	trace->record_size = htole16(sizeof(struct ucsi_trace_record));
+	trace->capacity = htole32(capacity);
+	trace->start_time = htole64(time(NULL));
+	clock_gettime(CLOCK_MONOTONIC, &trace_start);
+
+	return 0;
+}
+
+static int trace_replay_open(const char *path)
+{
+	const char *scale_env = getenv("LIBTYPEC_UCSI_REPLAY_SCALE");
+	const struct ucsi_trace_header *hdr;
+	uint32_t capacity;
+	uint64_t count;
+	struct stat sb;
+	void *map;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return -errno;
+
+	if (fstat(fd, &sb) < 0 || sb.st_size < (off_t)sizeof(*hdr))
+	{
+		close(fd);
+		return -EINVAL;
+	}
+
+	map = mmap(NULL, sb.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return -errno;
+
+	hdr = map;
+	capacity = le32toh(hdr->capacity);
+	count = le64toh(hdr->count);
+
+	if (memcmp(hdr->magic, UCSI_TRACE_MAGIC, sizeof(hdr->magic)) ||
+	    le16toh(hdr->version) != UCSI_TRACE_VERSION ||
+	    le16toh(hdr->record_size) != sizeof(struct ucsi_trace_record) ||
+	    (sb.st_size - sizeof(*hdr)) / sizeof(struct ucsi_trace_record) < capacity ||
+	    le32toh(hdr->head) >= (capacity ? capacity : 1))
+	{
+		munmap(map, sb.st_size);
+		return -EINVAL;
+	}
+
+	trace = map;
+	trace_size = sb.st_size;
+	trace_replay = 1;
+
+	replay_num = count < capacity ? count : capacity;
+	replay_first = count > capacity ? le32toh(hdr->head) : 0;
+	replay_cursor = 0;
+
+	if (scale_env)
+		replay_scale = strtod(scale_env, NULL);
+	if (replay_scale < 0)
+		replay_scale = 0;
+
+	return 0;
+}
+
+/**
+ * This function opens the recorder or the replay source selected through
+ * the environment. It is called by the debugfs backend on init.
+ *
+ * \returns 1 when replaying, 0 otherwise, negative errno on failure
+ */
+int libtypec_ucsi_trace_init(void)
+{
+	const char *path;
+	int ret;
+
+	libtypec_ucsi_trace_exit();
+
+	path = getenv("LIBTYPEC_UCSI_REPLAY");
+	if (path)
+	{
+		ret = trace_replay_open(path);
+		return ret < 0 ? ret : 1;
+	}
+
+	path = getenv("LIBTYPEC_UCSI_RECORD");
+	if (path)
+		return trace_record_open(path);
+
+	return 0;
+}
+
+void libtypec_ucsi_trace_exit(void)
+{
+	if (trace)
+		munmap(trace, trace_size);
+
+	trace = NULL;
+	trace_size = 0;
+	trace_replay = 0;
+}
+
+int libtypec_ucsi_trace_replaying(void)
+{
+	return trace_replay;
+}
+
+/**
+ * This function tells how many debugfs instances the replay source
+ * recorded transactions for.
+ *
+ * \returns number of instances, 0 when not replaying
+ */
+int libtypec_ucsi_trace_instances(void)
+{
+	int num = 0;
+
+	if (!trace || !trace_replay)
+		return 0;
+
+	for (uint32_t i = 0; i < replay_num; i++)
+	{
+		const struct ucsi_trace_record *rec = trace_slot((replay_first + i) % le32toh(trace->capacity));
+
+		if (le16toh(rec->instance) >= num)
+			num = le16toh(rec->instance) + 1;
+	}
+
+	return num ? num : 1;
+}
+
+/**
+ * This function appends one transaction to the ring. Timings are in
+ * nanoseconds and saturate at about four seconds.
+ */
+void libtypec_ucsi_trace_record(int instance, unsigned long long command, const struct timespec *start,
+				unsigned long long write_ns, unsigned long long read_ns,
+				const unsigned char *msg, int msg_len, int status)
+{
+	struct ucsi_trace_record *rec;
+	uint32_t head, capacity;
+
+	if (!trace || trace_replay)
+		return;
+
+	pthread_mutex_lock(&trace_lock);
+
+	capacity = le32toh(trace->capacity);
+	head = le32toh(trace->head);
+	rec = trace_slot(head);
+
+	if (msg_len < 0)
+		msg_len = 0;
+	if (msg_len > LIBTYPEC_UCSI_MESSAGE_IN_MAX)
+		msg_len = LIBTYPEC_UCSI_MESSAGE_IN_MAX;
+
+	rec->command = htole64(command);
+	rec->time_ns = htole64(ts_ns(start) - ts_ns(&trace_start));
+	rec->write_ns = htole32(write_ns > UINT32_MAX ? UINT32_MAX : write_ns);
+	rec->reserved_ns = 0;
+	rec->read_ns = htole32(read_ns > UINT32_MAX ? UINT32_MAX : read_ns);
+	rec->status = status;
+	rec->reserved = 0;
+	rec->instance = htole16(instance);
+	rec->msg_len = htole16(msg_len);
+	memset(rec->reserved2, 0, sizeof(rec->reserved2));
+	memset(rec->message_in, 0, sizeof(rec->message_in));
+	memcpy(rec->message_in, msg, msg_len);
+
+	trace->head = htole32(head + 1 < capacity ? head + 1 : 0);
+	trace->count = htole64(le64toh(trace->count) + 1);
+
+	pthread_mutex_unlock(&trace_lock);
+}
+
+/**
+ * This function answers a command from the replay source. Records are
+ * consumed in order; when the caller deviates from the recorded sequence
+ * the next record carrying the same command for the same instance is used.
+ *
+ * \returns number of MESSAGE_IN bytes, -1 when the command was never recorded or
+ * failed when it was recorded
+ */
+int libtypec_ucsi_trace_replay(int instance, unsigned long long command, unsigned char *msg, int max_len)
+{
+	const struct ucsi_trace_record *rec = NULL;
+	struct timespec delay;
+	uint64_t wait_ns;
+	uint32_t i, k;
+	int len;
+
+	if (!trace || !trace_replay)
+		return -1;
+
+	pthread_mutex_lock(&trace_lock);
+
+	for (i = 0; i < replay_num; i++)
+	{
+		k = (replay_cursor + i) % replay_num;
+		rec = trace_slot((replay_first + k) % le32toh(trace->capacity));
+
+		if (le64toh(rec->command) == command && le16toh(rec->instance) == instance)
+			break;
+	}
+
+	if (i == replay_num)
+	{
+		pthread_mutex_unlock(&trace_lock);
+		return -1;
+	}
+
+	replay_cursor = (k + 1) % replay_num;
+	pthread_mutex_unlock(&trace_lock);
+
+	/* Traces from older recorders keep their poll time in reserved_ns */
+	wait_ns = (uint64_t)((le32toh(rec->write_ns) + (uint64_t)le32toh(rec->reserved_ns) + le32toh(rec->read_ns)) * replay_scale);
+	if (wait_ns)
+	{
+		delay.tv_sec = wait_ns / 1000000000ull;
+		delay.tv_nsec = wait_ns % 1000000000ull;
+		while (nanosleep(&delay, &delay) < 0 && errno == EINTR)
+			;
+	}
+
+	if (rec->status != UCSI_TRACE_OK)
+		return -1;
+
+	len = le16toh(rec->msg_len) < max_len ? le16toh(rec->msg_len) : max_len;
+	memcpy(msg, rec->message_in, len);
+
+	return len;
+}
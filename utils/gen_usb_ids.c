@@ -0,0 +1,339 @@
+/*
+    Copyright (c) 2021-2022 by Rajaram Regupathy, rajaram.regupathy@gmail.com
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+    details.
+
+    (See the full license text in the LICENSES directory)
+*/
+// SPDX-License-Identifier: GPL-2.0-only
+/**
+ * @file gen_usb_ids.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Build time generator of the built-in USB vendor name table
+ *
+ * Reads the vendor lines of a usb.ids file and writes a C header holding
+ * a perfect hash of the vendor IDs and a packed pool of their names, each
+ * distinct name stored once. Run by the build, not installed.
+ *
+ * Usage: gen_usb_ids <usb.ids> <output.h>
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+
+#include "usb_ids_hash.h"
+
+#define MAX_SEEDS 4096
+
+struct vendor
+{
+    uint16_t vid;
+    uint32_t name;
+    uint32_t hash;
+};
+
+static struct vendor *vendors;
+static size_t num_vendors, max_vendors;
+
+static char *pool;
+static size_t pool_len, pool_size;
+
+static uint32_t pool_add(const char *name)
+{
+    size_t len = strlen(name) + 1;
+    size_t off;
+
+    // Vendors sharing a name, e.g. 8086 and 8087, share the string
+    for (off = 0; off < pool_len; off += strlen(pool + off) + 1)
+    {
+        if (strcmp(pool + off, name) == 0)
+            return off;
+    }
+
+    if (pool_len + len > pool_size)
+    {
+        pool_size = (pool_len + len) * 2;
+        pool = realloc(pool, pool_size);
+        if (!pool)
+        {
+            perror("gen_usb_ids");
+            exit(1);
+        }
+    }
+
+    memcpy(pool + pool_len, name, len);
+    off = pool_len;
+    pool_len += len;
+    return off;
+}
+
+static void parse(FILE *in)
+{
+    char line[512];
+    size_t i, len;
+    unsigned int vid;
+
+    while (fgets(line, sizeof(line), in))
+    {
+        // Vendors are followed by device classes and other lists
+        if (strncmp(line, "# List of known device classes", 30) == 0)
+            break;
+
+        if (!isxdigit((unsigned char)line[0]) || sscanf(line, "%4x", &vid) != 1 ||
+            line[4] != ' ' || line[5] != ' ')
+            continue;
+
+        len = strlen(line);
+        while (len > 6 && isspace((unsigned char)line[len - 1]))
+            line[--len] = '\0';
+
+        for (i = 0; i < num_vendors; i++)
+        {
+            if (vendors[i].vid == vid)
+                break;
+        }
+        if (i < num_vendors)
+            continue;
+
+        if (num_vendors == max_vendors)
+        {
+            max_vendors = max_vendors ? max_vendors * 2 : 1024;
+            vendors = realloc(vendors, max_vendors * sizeof(*vendors));
+            if (!vendors)
+            {
+                perror("gen_usb_ids");
+                exit(1);
+            }
+        }
+
+        vendors[num_vendors].vid = vid;
+        vendors[num_vendors].name = pool_add(line + 6);
+        num_vendors++;
+    }
+}
+
+static uint32_t pow2(uint32_t n)
+{
+    uint32_t p = 1;
+
+    while (p < n)
+        p <<= 1;
+    return p;
+}
+
+/*
+ * Places every bucket, largest first, at the first displacement that maps
+ * all its vendors to free slots. Returns 0 when every bucket found one.
+ */
+static int place(uint32_t seed, uint32_t num_buckets, uint32_t num_slots, uint16_t *disp, int32_t *slot_vendor)
+{
+    uint32_t *order, *bucket_size, *slots;
+    uint32_t b, i, j, k, d, n;
+    int ret = 0;
+
+    order = calloc(num_buckets, sizeof(*order));
+    bucket_size = calloc(num_buckets, sizeof(*bucket_size));
+    slots = calloc(num_vendors + 1, sizeof(*slots));
+    if (!order || !bucket_size || !slots)
+    {
+        perror("gen_usb_ids");
+        exit(1);
+    }
+
+    for (i = 0; i < num_slots; i++)
+        slot_vendor[i] = -1;
+
+    for (i = 0; i < num_vendors; i++)
+    {
+        vendors[i].hash = usb_ids_hash(vendors[i].vid, seed);
+        bucket_size[vendors[i].hash & (num_buckets - 1)]++;
+    }
+
+    for (b = 0; b < num_buckets; b++)
+        order[b] = b;
+    for (i = 1; i < num_buckets; i++)
+    {
+        for (j = i; j > 0 && bucket_size[order[j - 1]] < bucket_size[order[j]]; j--)
+        {
+            b = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = b;
+        }
+    }
+
+    for (i = 0; i < num_buckets && bucket_size[order[i]]; i++)
+    {
+        b = order[i];
+
+        for (d = 0; d < num_slots && d <= UINT16_MAX; d++)
+        {
+            for (n = 0, j = 0; j < num_vendors; j++)
+            {
+                if ((vendors[j].hash & (num_buckets - 1)) != b)
+                    continue;
+
+                slots[n] = usb_ids_slot(vendors[j].hash, d, num_slots);
+                if (slot_vendor[slots[n]] >= 0)
+                    break;
+                for (k = 0; k < n && slots[k] != slots[n]; k++)
+                    ;
+                if (k < n)
+                    break;
+                n++;
+            }
+            if (n == bucket_size[b])
+                break;
+        }
+
+        if (n != bucket_size[b])
+        {
+            ret = -1;
+            break;
+        }
+
+        disp[b] = d;
+        for (n = 0, j = 0; j < num_vendors; j++)
+        {
+            if ((vendors[j].hash & (num_buckets - 1)) == b)
+                slot_vendor[usb_ids_slot(vendors[j].hash, d, num_slots)] = j;
+        }
+    }
+
+    free(order);
+    free(bucket_size);
+    free(slots);
+    return ret;
+}
+
+static void write_string(FILE *out, const char *s)
+{
+    fputc('"', out);
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+
+        // Octal escapes keep non-ASCII names and trigraphs intact
+        if (c == '"' || c == '\\' || c == '?' || c < 0x20 || c > 0x7e)
+            fprintf(out, "\\%03o", c);
+        else
+            fputc(c, out);
+    }
+    fputs("\\0\"", out);
+}
+
+int main(int argc, char *argv[])
+{
+    uint32_t num_buckets, num_slots, seed = 0, i, off;
+    int32_t *slot_vendor;
+    uint16_t *disp;
+    FILE *in, *out;
+
+    if (argc != 3)
+    {
+        fprintf(stderr, "usage: %s <usb.ids> <output.h>\n", argv[0]);
+        return 1;
+    }
+
+    in = fopen(argv[1], "r");
+    if (!in)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+    parse(in);
+    fclose(in);
+
+    num_buckets = pow2(num_vendors / 4 ? num_vendors / 4 : 1);
+    num_slots = pow2(num_vendors + num_vendors / 4 + 1);
+
+    disp = calloc(num_buckets, sizeof(*disp));
+    slot_vendor = calloc(num_slots, sizeof(*slot_vendor));
+    if (!disp || !slot_vendor)
+    {
+        perror("gen_usb_ids");
+        return 1;
+    }
+
+    while (place(seed, num_buckets, num_slots, disp, slot_vendor) < 0)
+    {
+        if (++seed < MAX_SEEDS)
+            continue;
+
+        // Give up on this load factor
+        seed = 0;
+        num_slots *= 2;
+        if (num_slots > 0x10000)
+        {
+            fprintf(stderr, "gen_usb_ids: no perfect hash for %zu vendors\n", num_vendors);
+            return 1;
+        }
+        free(slot_vendor);
+        slot_vendor = calloc(num_slots, sizeof(*slot_vendor));
+        if (!slot_vendor)
+        {
+            perror("gen_usb_ids");
+            return 1;
+        }
+    }
+
+    out = fopen(argv[2], "w");
+    if (!out)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    fprintf(out, "/* Generated by gen_usb_ids from usb.ids, do not edit */\n\n");
+    fprintf(out, "#ifndef USB_IDS_TABLE_H\n#define USB_IDS_TABLE_H\n\n#include <stdint.h>\n\n");
+    fprintf(out, "#define USB_IDS_NUM_VENDORS %zu\n", num_vendors);
+    fprintf(out, "#define USB_IDS_SEED 0x%xu\n", seed);
+    fprintf(out, "#define USB_IDS_NUM_BUCKETS %u\n", num_buckets);
+    fprintf(out, "#define USB_IDS_NUM_SLOTS %u\n", num_slots);
+    fprintf(out, "#define USB_IDS_EMPTY 0xffffffffu\n\n");
+
+    fprintf(out, "static const uint16_t usb_ids_disp[USB_IDS_NUM_BUCKETS] = {");
+    for (i = 0; i < num_buckets; i++)
+        fprintf(out, "%s%u,", i % 16 ? " " : "\n    ", disp[i]);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const uint16_t usb_ids_vid[USB_IDS_NUM_SLOTS] = {");
+    for (i = 0; i < num_slots; i++)
+        fprintf(out, "%s0x%04x,", i % 12 ? " " : "\n    ", slot_vendor[i] >= 0 ? vendors[slot_vendor[i]].vid : 0);
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const uint32_t usb_ids_name[USB_IDS_NUM_SLOTS] = {");
+    for (i = 0; i < num_slots; i++)
+    {
+        if (slot_vendor[i] >= 0)
+            fprintf(out, "%s%u,", i % 12 ? " " : "\n    ", vendors[slot_vendor[i]].name);
+        else
+            fprintf(out, "%sUSB_IDS_EMPTY,", i % 12 ? " " : "\n    ");
+    }
+    fprintf(out, "\n};\n\n");
+
+    fprintf(out, "static const char usb_ids_strings[] =");
+    for (off = 0; off < pool_len; off += strlen(pool + off) + 1)
+    {
+        fprintf(out, "\n    ");
+        write_string(out, pool + off);
+    }
+    fprintf(out, "%s;\n\n#endif //USB_IDS_TABLE_H\n", pool_len ? "" : " \"\"");
+
+    if (fclose(out) != 0)
+    {
+        perror(argv[2]);
+        return 1;
+    }
+
+    return 0;
+}
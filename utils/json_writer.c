@@ -0,0 +1,234 @@
+/*
+    Copyright (c) 2021-2022 by Rajaram Regupathy, rajaram.regupathy@gmail.com
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+    details.
+
+    (See the full license text in the LICENSES directory)
+*/
+// SPDX-License-Identifier: GPL-2.0-only
+/**
+ * @file json_writer.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Buffered streaming JSON writer for the libtypec utilities
+ *
+ * Output is assembled in one large buffer and handed to the kernel only
+ * when the caller flushes, typically once per port, or when the buffer
+ * fills up. Values are written directly, there is no document tree.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "json_writer.h"
+
+void json_init(struct json_writer *w, int fd, int seq)
+{
+    w->fd = fd;
+    w->seq = seq;
+    w->depth = 0;
+    w->error = 0;
+    w->len = 0;
+    w->need_comma[0] = 0;
+}
+
+int json_flush(struct json_writer *w)
+{
+    size_t off = 0;
+    ssize_t ret;
+
+    while (off < w->len)
+    {
+        ret = write(w->fd, w->buf + off, w->len - off);
+        if (ret < 0 && errno == EINTR)
+            continue;
+        if (ret <= 0)
+        {
+            w->error = -EIO;
+            break;
+        }
+        off += ret;
+    }
+
+    w->len = 0;
+
+    return w->error;
+}
+
+static void json_put(struct json_writer *w, const char *data, size_t len)
+{
+    if (w->len + len > sizeof(w->buf))
+        json_flush(w);
+
+    /* Anything larger than the buffer bypasses it */
+    if (len > sizeof(w->buf))
+    {
+        while (len > 0)
+        {
+            size_t chunk = len < sizeof(w->buf) ? len : sizeof(w->buf);
+
+            memcpy(w->buf, data, chunk);
+            w->len = chunk;
+            json_flush(w);
+            data += chunk;
+            len -= chunk;
+        }
+        return;
+    }
+
+    memcpy(w->buf + w->len, data, len);
+    w->len += len;
+}
+
+static void json_putc(struct json_writer *w, char c)
+{
+    if (w->len == sizeof(w->buf))
+        json_flush(w);
+
+    w->buf[w->len++] = c;
+}
+
+static void json_put_string(struct json_writer *w, const char *s)
+{
+    char esc[8];
+
+    json_putc(w, '"');
+
+    for (; *s; s++)
+    {
+        unsigned char c = *s;
+
+        if (c == '"' || c == '\\')
+        {
+            json_putc(w, '\\');
+            json_putc(w, c);
+        }
+        else if (c < 0x20)
+        {
+            snprintf(esc, sizeof(esc), "\\u%04x", c);
+            json_put(w, esc, 6);
+        }
+        else
+            json_putc(w, c);
+    }
+
+    json_putc(w, '"');
+}
+
+/* Separator and key in front of every value */
+static void json_key(struct json_writer *w, const char *key)
+{
+    if (w->need_comma[w->depth])
+        json_putc(w, ',');
+    w->need_comma[w->depth] = 1;
+
+    if (key)
+    {
+        json_put_string(w, key);
+        json_putc(w, ':');
+    }
+}
+
+/**
+ * Starts a top level value. In sequence mode every record is prefixed
+ * with the RFC 7464 record separator.
+ */
+void json_record_begin(struct json_writer *w)
+{
+    if (w->seq)
+        json_putc(w, JSON_SEQ_RS);
+
+    w->depth = 0;
+    w->need_comma[0] = 0;
+}
+
+/**
+ * Terminates a top level value and hands it to the kernel.
+ */
+void json_record_end(struct json_writer *w)
+{
+    json_putc(w, '\n');
+    json_flush(w);
+}
+
+static void json_open(struct json_writer *w, const char *key, char c)
+{
+    json_key(w, key);
+    json_putc(w, c);
+
+    if (w->depth < JSON_MAX_DEPTH - 1)
+        w->depth++;
+    w->need_comma[w->depth] = 0;
+}
+
+static void json_close(struct json_writer *w, char c)
+{
+    if (w->depth > 0)
+        w->depth--;
+    json_putc(w, c);
+}
+
+void json_object_begin(struct json_writer *w, const char *key)
+{
+    json_open(w, key, '{');
+}
+
+void json_object_end(struct json_writer *w)
+{
+    json_close(w, '}');
+}
+
+void json_array_begin(struct json_writer *w, const char *key)
+{
+    json_open(w, key, '[');
+}
+
+void json_array_end(struct json_writer *w)
+{
+    json_close(w, ']');
+}
+
+void json_uint(struct json_writer *w, const char *key, unsigned long long val)
+{
+    char num[24];
+
+    json_key(w, key);
+    json_put(w, num, snprintf(num, sizeof(num), "%llu", val));
+}
+
+void json_int(struct json_writer *w, const char *key, long long val)
+{
+    char num[24];
+
+    json_key(w, key);
+    json_put(w, num, snprintf(num, sizeof(num), "%lld", val));
+}
+
+void json_bool(struct json_writer *w, const char *key, int val)
+{
+    json_key(w, key);
+    if (val)
+        json_put(w, "true", 4);
+    else
+        json_put(w, "false", 5);
+}
+
+void json_string(struct json_writer *w, const char *key, const char *val)
+{
+    json_key(w, key);
+    json_put_string(w, val ? val : "");
+}
+
+void json_null(struct json_writer *w, const char *key)
+{
+    json_key(w, key);
+    json_put(w, "null", 4);
+}
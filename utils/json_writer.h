@@ -0,0 +1,62 @@
+/*
+    Copyright (c) 2021-2022 by Rajaram Regupathy, rajaram.regupathy@gmail.com
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+    details.
+
+    (See the full license text in the LICENSES directory)
+*/
+// SPDX-License-Identifier: GPL-2.0-only
+/**
+ * @file json_writer.h
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Buffered streaming JSON writer for the libtypec utilities
+ *
+ */
+
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <stddef.h>
+
+#define JSON_BUF_SIZE (64 * 1024)
+#define JSON_MAX_DEPTH 16
+
+/* RFC 7464 record separator used by json_record_begin() */
+#define JSON_SEQ_RS 0x1e
+
+struct json_writer
+{
+    int fd;
+    int seq;
+    int depth;
+    int error;
+    size_t len;
+    unsigned char need_comma[JSON_MAX_DEPTH];
+    char buf[JSON_BUF_SIZE];
+};
+
+void json_init(struct json_writer *w, int fd, int seq);
+int json_flush(struct json_writer *w);
+
+void json_record_begin(struct json_writer *w);
+void json_record_end(struct json_writer *w);
+
+void json_object_begin(struct json_writer *w, const char *key);
+void json_object_end(struct json_writer *w);
+void json_array_begin(struct json_writer *w, const char *key);
+void json_array_end(struct json_writer *w);
+
+void json_uint(struct json_writer *w, const char *key, unsigned long long val);
+void json_int(struct json_writer *w, const char *key, long long val);
+void json_bool(struct json_writer *w, const char *key, int val);
+void json_string(struct json_writer *w, const char *key, const char *val);
+void json_null(struct json_writer *w, const char *key);
+
+#endif //JSON_WRITER_H
@@ -27,153 +27,63 @@
 #include <string.h>
 
 #include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
 
 #include "../libtypec.h"
 #include "lstypec.h"
 #include "names.h"
+#include "json_writer.h"
 #include "libtypec_utils_config.h"
 
 struct libtypec_capability_data get_cap_data;
-struct libtypec_connector_cap_data conn_data;
-struct libtypec_connector_status conn_sts;
-struct libtypec_cable_property cable_prop;
-union libtypec_discovered_identity id;
-unsigned int* pdo_data;
+struct lstypec_port port;
+struct json_writer jw;
+
+struct lstypec_port *watch_ports;
+int watch_num_ports;
+int watch_json;
+int highlight;
+unsigned int highlight_mask;
 
-struct altmode_data am_data[64];
 char *session_info[LIBTYPEC_SESSION_MAX_INDEX];
 int verbose = 0;
 
-enum product_type get_cable_product_type(short rev, uint32_t id)
+void print_fields(const struct libtypec_vdo_field *fields, int num_fields)
 {
-  // Decode cable product type
-  if (rev == 0x200)
-  {
-    // USB PD 2.0 cable
-    if ((id & pd_ufp_product_type_mask) == pd2p0_passive_cable)
-      return product_type_pd2p0_passive_cable;
-    else if ((id & pd_ufp_product_type_mask) == pd2p0_active_cable)
-      return product_type_pd2p0_active_cable;
-    else
-      return product_type_other;
-  }
-  else if (rev == 0x300)
-  {
-    // USB PD 3.0 cable
-    if ((id & pd_ufp_product_type_mask) == pd3p0_passive_cable)
-      return product_type_pd3p0_passive_cable;
-    else if ((id & pd_ufp_product_type_mask) == pd3p0_active_cable)
-      return product_type_pd3p0_active_cable;
-    else
-      return product_type_other;
-  }
-  else if (rev == 0x310)
-  {
-    // USB PD 3.1 cable
-    if ((id & pd_ufp_product_type_mask) == pd3p1_passive_cable)
-      return product_type_pd3p1_passive_cable;
-    else if ((id & pd_ufp_product_type_mask) == pd3p1_active_cable)
-      return product_type_pd3p1_active_cable;
-    else if ((id & pd_ufp_product_type_mask) == pd3p1_vpd)
-      return product_type_pd3p1_vpd;
-    else
-      return product_type_other;
+  if (num_fields > LIBTYPEC_VDO_MAX_FIELDS)
+    num_fields = LIBTYPEC_VDO_MAX_FIELDS;
+
+  for (int i = 0; i < num_fields; i++) {
+    printf("      %s: %*d", fields[i].name, FIELD_WIDTH(MAX_FIELD_LENGTH - fields[i].name_len), fields[i].value);
+    if (fields[i].desc != NULL) {
+      // decode field
+      printf(" (%s)\n", fields[i].desc);
+    } else if (strcmp(fields[i].name, "USB Vendor ID")  == 0) {
+      // decode vendor id
+      char vendor_str[128];
+      get_vendor_string(vendor_str, sizeof(vendor_str), fields[i].value);
+      printf(" (%s)\n", (vendor_str[0] == '\0' ? "unknown" : vendor_str));
+    } else {
+      // No decoding
+      printf("\n");
+    }
   }
-  return product_type_other;
 }
 
-enum product_type get_partner_product_type(short rev, uint32_t id)
+void print_vdo(unsigned short revision, enum libtypec_vdo_type type, uint32_t vdo)
 {
-  // Decode partner product type
-  if (rev == 0x200)
-  {
-    // USB PD 2.0 partner
-    if ((id & pd_ufp_product_type_mask) == pd2p0_ama)
-      return product_type_pd2p0_ama;
-    else
-      return product_type_other;
-  }
-  else if (rev == 0x300)
-  {
-    // USB PD 3.0 partner
-    char ufp_supported = 0;
-    if ((id & pd_ufp_product_type_mask) == pd3p0_hub)
-      ufp_supported = 1;
-    else if ((id & pd_ufp_product_type_mask) == pd3p0_peripheral)
-      ufp_supported = 1;
-    else if ((id & pd_ufp_product_type_mask) == pd3p0_ama)
-      return product_type_pd3p0_ama;
-    else if ((id & pd_ufp_product_type_mask) == pd3p0_vpd)
-      return product_type_pd3p0_vpd;
-
-    char dfp_supported = 0;
-    if ((id & pd_dfp_product_type_mask) == pd3p0_dfp_hub)
-      dfp_supported = 1;
-    else if ((id & pd_dfp_product_type_mask) == pd3p0_dfp_host)
-      dfp_supported = 1;
-    else if ((id & pd_dfp_product_type_mask) == pd3p0_power_brick)
-      dfp_supported = 1;
-
-    if (ufp_supported && dfp_supported)
-      return product_type_pd3p0_drd;
-    else if (ufp_supported)
-      return product_type_pd3p0_ufp;
-    else if (dfp_supported)
-      return product_type_pd3p0_dfp;
-    else
-      return product_type_other;
-  }
-  else if (rev == 0x310)
-  {
-    // USB PD 3.1 partner
-    char ufp_supported = 0;
-    if ((id & pd_ufp_product_type_mask) == pd3p1_hub)
-      ufp_supported = 1;
-    else if ((id & pd_ufp_product_type_mask) == pd3p1_peripheral)
-      ufp_supported = 1;
-
-    char dfp_supported = 0;
-    if ((id & pd_dfp_product_type_mask) == pd3p1_dfp_hub)
-      dfp_supported = 1;
-    else if ((id & pd_dfp_product_type_mask) == pd3p1_dfp_host)
-      dfp_supported = 1;
-    else if ((id & pd_dfp_product_type_mask) == pd3p1_power_brick)
-      dfp_supported = 1;
-
-    if (ufp_supported && dfp_supported)
-      return product_type_pd3p1_drd;
-    else if (ufp_supported)
-      return product_type_pd3p1_ufp;
-    else if (dfp_supported)
-      return product_type_pd3p1_dfp;
-    else
-      return product_type_other;
-  }
-  return product_type_other;
+  struct libtypec_vdo_field fields[LIBTYPEC_VDO_MAX_FIELDS];
+
+  print_fields(fields, libtypec_decode_vdo(revision, type, vdo, fields, LIBTYPEC_VDO_MAX_FIELDS));
 }
 
-void print_vdo(uint32_t vdo, int num_fields, const struct vdo_field vdo_fields[], const char *vdo_field_desc[][MAX_FIELDS])
+void print_pdo(unsigned short revision, int src_snk, uint32_t pdo)
 {
-  for (int i = 0; i < num_fields; i++) {
-    if (!vdo_fields[i].print)
-      continue;
+  struct libtypec_vdo_field fields[LIBTYPEC_VDO_MAX_FIELDS];
 
-      uint32_t field = (vdo >> vdo_fields[i].index) & vdo_fields[i].mask;
-      printf("      %s: %*d", vdo_fields[i].name, FIELD_WIDTH(MAX_FIELD_LENGTH - ((int) strlen(vdo_fields[i].name))), ((vdo >> vdo_fields[i].index) & vdo_fields[i].mask));
-      if (vdo_field_desc[i][0] != NULL) {
-        // decode field
-        printf(" (%s)\n", vdo_field_desc[i][field]);
-      } else if (strcmp(vdo_fields[i].name, "USB Vendor ID")  == 0) {
-        // decode vendor id
-         char vendor_str[128];
-         uint16_t svid = ((vdo >> vdo_fields[i].index) & vdo_fields[i].mask);
-         get_vendor_string(vendor_str, sizeof(vendor_str), svid);
-        printf(" (%s)\n", (vendor_str[0] == '\0' ? "unknown" : vendor_str));
-      } else {
-        // No decoding
-        printf("\n");
-      }
-  }
+  print_fields(fields, libtypec_decode_pdo(revision, src_snk, pdo, fields, LIBTYPEC_VDO_MAX_FIELDS));
 }
 
 /**
@@ -187,6 +97,8 @@ void print_session_info()
   printf("  Using %s\n", session_info[LIBTYPEC_VERSION_INDEX]);
   printf("  %s with Kernel %s\n", session_info[LIBTYPEC_OS_INDEX], session_info[LIBTYPEC_KERNEL_INDEX]);
   printf("  libtypec using %s\n", session_info[LIBTYPEC_OPS_INDEX]);
+  if (strcmp(libtypec_get_routing(), session_info[LIBTYPEC_OPS_INDEX]))
+    printf("  routing %s\n", libtypec_get_routing());
 }
 
 /**
@@ -221,17 +133,17 @@ void print_cable_prop(struct libtypec_cable_property cable_prop, int conn_num)
     printf("    Cable Plug Type: %s\n", cable_plug_type[cable_prop.plug_end_type]);
 }
 
-void get_svid_string(uint32_t svid, char* str) {
+void get_svid_string(uint32_t svid, char* str, size_t size) {
 
     switch (svid) {
         case 0xFF01:
-            strcpy(str, "Display Alternate Mode");
+            snprintf(str, size, "Display Alternate Mode");
             break;
         case 0x8087:
-            strcpy(str, "TBT Alternate Mode");
+            snprintf(str, size, "TBT Alternate Mode");
             break;
         default:
-            get_vendor_string(str, sizeof(str), svid);
+            get_vendor_string(str, size, svid);
             break;
     }
 }
@@ -242,17 +154,17 @@ void print_alternate_mode_data(int recipient, uint32_t id_header, int num_modes,
 
   if (recipient == AM_CONNECTOR) {
     for (int i = 0; i < num_modes; i++) {
-      get_svid_string(am_data[i].svid,vendor_id);
+      get_svid_string(am_data[i].svid, vendor_id, sizeof(vendor_id));
       printf("  Local Mode %d:\n", i);
       printf("    SVID: 0x%04x (%s)\n", am_data[i].svid,vendor_id);
       printf("    VDO: 0x%08x\n", am_data[i].vdo);
       if (verbose) {
         switch(am_data[i].svid){
         case 0x8087:
-          print_vdo(am_data[i].vdo, 7, tbt3_sop_fields, tbt3_sop_field_desc);
+          print_vdo(0, LIBTYPEC_VDO_TBT3_SOP, am_data[i].vdo);
           break;
         case 0xff01:
-          print_vdo(am_data[i].vdo, 7, dp_alt_mode_partner_fields, dp_alt_mode_partner_field_desc);
+          print_vdo(0, LIBTYPEC_VDO_DP_PARTNER, am_data[i].vdo);
           break;
         default:
           get_vendor_string(vendor_id, sizeof(vendor_id), am_data[i].svid);
@@ -265,17 +177,17 @@ void print_alternate_mode_data(int recipient, uint32_t id_header, int num_modes,
 
   if (recipient == AM_SOP) {
     for (int i = 0; i < num_modes; i++) {
-      get_svid_string(am_data[i].svid,vendor_id);
+      get_svid_string(am_data[i].svid, vendor_id, sizeof(vendor_id));
       printf("  Partner Mode %d:\n", i);
       printf("    SVID: 0x%04x (%s)\n", am_data[i].svid,vendor_id);
       printf("    VDO: 0x%08x\n", am_data[i].vdo);
       if (verbose) {
         switch(am_data[i].svid){
         case 0x8087:
-          print_vdo(am_data[i].vdo, 7, tbt3_sop_fields, tbt3_sop_field_desc);
+          print_vdo(0, LIBTYPEC_VDO_TBT3_SOP, am_data[i].vdo);
           break;
         case 0xff01:
-          print_vdo(am_data[i].vdo, 7, dp_alt_mode_partner_fields, dp_alt_mode_partner_field_desc);
+          print_vdo(0, LIBTYPEC_VDO_DP_PARTNER, am_data[i].vdo);
           break;
         default:
           get_vendor_string(vendor_id, sizeof(vendor_id), am_data[i].svid);
@@ -288,7 +200,7 @@ void print_alternate_mode_data(int recipient, uint32_t id_header, int num_modes,
 
   if (recipient == AM_SOP_PR) {
     for (int i = 0; i < num_modes; i++) {
-      get_svid_string(am_data[i].svid,vendor_id);
+      get_svid_string(am_data[i].svid, vendor_id, sizeof(vendor_id));
       printf("  Cable Plug Modes %d:\n", i);
       printf("    SVID: 0x%04x (%s)\n", am_data[i].svid,vendor_id);
       printf("    VDO: 0x%08x\n", am_data[i].vdo);
@@ -296,11 +208,11 @@ void print_alternate_mode_data(int recipient, uint32_t id_header, int num_modes,
       if (verbose) {
         switch(am_data[i].svid){
         case 0x8087:
-          print_vdo(am_data[i].vdo, 7, tbt3_sop_pr_fields, tbt3_sop_pr_field_desc);
+          print_vdo(0, LIBTYPEC_VDO_TBT3_SOP_PR, am_data[i].vdo);
           break;
         case 0xff01:
           if ((id_header & ACTIVE_CABLE_MASK) == ACTIVE_CABLE_COMP) {
-            print_vdo(am_data[i].vdo, 7, dp_alt_mode_active_cable_fields, dp_alt_mode_active_cable_field_desc);
+            print_vdo(0, LIBTYPEC_VDO_DP_CABLE, am_data[i].vdo);
           } else {
             get_vendor_string(vendor_id, sizeof(vendor_id), am_data[i].svid);
             printf("      SVID Decoding not supported for 0x%04x (%s)\n", am_data[i].svid, (vendor_id[0] == '\0' ? "unknown" : vendor_id));
@@ -317,236 +229,102 @@ void print_alternate_mode_data(int recipient, uint32_t id_header, int num_modes,
 }
 
 
+void print_product_vdos(unsigned short rev, union libtypec_discovered_identity *id, int vdo1, int vdo2, int vdo3)
+{
+  printf("    Product VDO 1: 0x%08x\n", id->disc_id.product_type_vdo1);
+  if (vdo1 >= 0)
+    print_vdo(rev, vdo1, ((uint32_t) id->disc_id.product_type_vdo1));
+  printf("    Product VDO 2: 0x%08x\n", id->disc_id.product_type_vdo2);
+  if (vdo2 >= 0)
+    print_vdo(rev, vdo2, ((uint32_t) id->disc_id.product_type_vdo2));
+  printf("    Product VDO 3: 0x%08x\n", id->disc_id.product_type_vdo3);
+  if (vdo3 >= 0)
+    print_vdo(rev, vdo3, ((uint32_t) id->disc_id.product_type_vdo3));
+}
+
 void print_identity_data(int recipient, union libtypec_discovered_identity id, struct libtypec_connector_cap_data conn_data)
 {
-  union id_header id_hdr_val;
-  id_hdr_val.id_hdr = id.disc_id.id_header;
+  unsigned short rev = recipient == AM_SOP ? conn_data.partner_rev : conn_data.cable_rev;
 
   if (recipient == AM_SOP)
-  {
     printf("  Partner Identity :\n");
-
-    // Partner ID
-    if (verbose)
-    {
-      // ID Header/Cert Stat/Product are base on revision
-      switch (conn_data.partner_rev)
-      {
-        case 0x200:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 6, pd2p0_partner_id_header_fields, pd2p0_partner_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd2p0_cert_stat_fields, pd2p0_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd2p0_product_fields, pd2p0_product_field_desc);
-          break;
-        case 0x300:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 7, pd3p0_partner_id_header_fields, pd3p0_partner_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd3p0_cert_stat_fields, pd3p0_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd3p0_product_fields, pd3p0_product_field_desc);
-          break;
-        case 0x310:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 8, pd3p1_partner_id_header_fields, pd3p1_partner_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd3p1_cert_stat_fields, pd3p1_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd3p1_product_fields, pd3p1_product_field_desc);
-          break;
-        default:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          break;
-      }
-
-      //Product Type VDOs based on product type
-      enum product_type partner_product_type = get_partner_product_type(conn_data.partner_rev, ((uint32_t) id.disc_id.id_header));
-      switch (partner_product_type)
-      {
-        case product_type_pd2p0_ama:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 11, pd2p0_ama_fields, pd2p0_ama_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_ama:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 8, pd3p0_ama_fields, pd3p0_ama_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_vpd:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 10, pd3p0_vpd_fields, pd3p0_vpd_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_ufp:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 6, pd3p0_ufp_vdo1_fields, pd3p0_ufp_vdo1_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo2), 6, pd3p0_ufp_vdo2_fields, pd3p0_ufp_vdo2_field_desc);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_dfp:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 5, pd3p0_dfp_fields, pd3p0_dfp_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_drd:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 6, pd3p0_ufp_vdo1_fields, pd3p0_ufp_vdo1_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo2), 6, pd3p0_ufp_vdo2_fields, pd3p0_ufp_vdo2_field_desc);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo3), 5, pd3p0_dfp_fields, pd3p0_dfp_field_desc);
-          break;
-        case product_type_pd3p1_ufp:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 10, pd3p1_ufp_fields, pd3p1_ufp_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p1_dfp:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 6, pd3p1_dfp_fields, pd3p1_dfp_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p1_drd:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 10, pd3p1_ufp_fields, pd3p1_ufp_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo3), 6, pd3p1_dfp_fields, pd3p1_dfp_field_desc);
-          break;
-        default:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-      }
-    }
-    else
-    {
-      printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-      printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-      printf("    Product: 0x%08x\n", id.disc_id.product);
-      printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-      printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-      printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-    }
-  }
   else if (recipient == AM_SOP_PR)
+    printf("  Cable Identity :\n");
+  else
+    return;
+
+  if (!verbose)
   {
+    printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
+    printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
+    printf("    Product: 0x%08x\n", id.disc_id.product);
+    print_product_vdos(rev, &id, -1, -1, -1);
+    return;
+  }
 
-    printf("  Cable Identity :\n");
+  // ID Header/Cert Stat/Product are base on revision
+  printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
+  print_vdo(rev, recipient == AM_SOP ? LIBTYPEC_VDO_ID_HEADER_PARTNER : LIBTYPEC_VDO_ID_HEADER_CABLE, ((uint32_t) id.disc_id.id_header));
+  printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
+  print_vdo(rev, LIBTYPEC_VDO_CERT_STAT, ((uint32_t) id.disc_id.cert_stat));
+  printf("    Product: 0x%08x\n", id.disc_id.product);
+  print_vdo(rev, LIBTYPEC_VDO_PRODUCT, ((uint32_t) id.disc_id.product));
 
-    // Partner ID
-    if (verbose)
+  //Product Type VDOs based on product type
+  if (recipient == AM_SOP)
+  {
+    switch (libtypec_get_partner_product_type(rev, ((uint32_t) id.disc_id.id_header)))
     {
-      // ID Header/Cert Stat/Product are base on revision
-      switch (conn_data.cable_rev)
-      {
-        case 0x200:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 6, pd2p0_cable_id_header_fields, pd2p0_cable_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd2p0_cert_stat_fields, pd2p0_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd2p0_product_fields, pd2p0_product_field_desc);
-          break;
-        case 0x300:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 7, pd3p0_cable_id_header_fields, pd3p0_cable_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd3p0_cert_stat_fields, pd3p0_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd3p0_product_fields, pd3p0_product_field_desc);
-          break;
-        case 0x310:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          print_vdo(((uint32_t) id.disc_id.id_header), 8, pd3p1_cable_id_header_fields, pd3p1_cable_id_header_field_desc);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          print_vdo(((uint32_t) id.disc_id.cert_stat), 1, pd3p1_cert_stat_fields, pd3p1_cert_stat_field_desc);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          print_vdo(((uint32_t) id.disc_id.product), 2, pd3p1_product_fields, pd3p1_product_field_desc);
-          break;
-        default:
-          printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-          printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-          printf("    Product: 0x%08x\n", id.disc_id.product);
-          break;
-      }
-
-      //Product Type VDOs based on product type
-      enum product_type cable_product_type = get_cable_product_type(conn_data.cable_rev, ((uint32_t) id.disc_id.id_header));
-      switch (cable_product_type)
-      {
-        case product_type_pd2p0_passive_cable:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 15, pd2p0_passive_cable_fields, pd2p0_passive_cable_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd2p0_active_cable:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 15, pd2p0_active_cable_fields, pd2p0_active_cable_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_passive_cable:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 13, pd3p0_passive_cable_fields, pd3p0_passive_cable_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p0_active_cable:
-          printf("   Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 15, pd3p0_active_cable_vdo1_fields, pd3p0_active_cable_vdo1_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo2), 15, pd3p0_active_cable_vdo2_fields, pd3p0_active_cable_vdo2_field_desc);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p1_passive_cable:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 13, pd3p1_passive_cable_fields, pd3p1_passive_cable_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p1_active_cable:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 15, pd3p1_active_cable_vdo1_fields, pd3p1_active_cable_vdo1_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo2), 15, pd3p1_active_cable_vdo2_fields, pd3p1_active_cable_vdo2_field_desc);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        case product_type_pd3p1_vpd:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          print_vdo(((uint32_t) id.disc_id.product_type_vdo1), 10, pd3p1_vpd_fields, pd3p0_vpd_field_desc);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-        default:
-          printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-          printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-          printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
-          break;
-      }
+      case LIBTYPEC_PRODUCT_TYPE_PD2P0_AMA:
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_AMA:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_AMA, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_VPD:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_VPD, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_UFP:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_UFP1, LIBTYPEC_VDO_UFP2, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_DFP:
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_DFP:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_DFP, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_DRD:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_UFP1, LIBTYPEC_VDO_UFP2, LIBTYPEC_VDO_DFP);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_UFP:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_UFP1, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_DRD:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_UFP1, -1, LIBTYPEC_VDO_DFP);
+        break;
+      default:
+        print_product_vdos(rev, &id, -1, -1, -1);
+        break;
     }
-    else
+  }
+  else
+  {
+    switch (libtypec_get_cable_product_type(rev, ((uint32_t) id.disc_id.id_header)))
     {
-      printf("    ID Header: 0x%08x\n", id.disc_id.id_header);
-      printf("    Cert Stat: 0x%08x\n", id.disc_id.cert_stat);
-      printf("    Product: 0x%08x\n", id.disc_id.product);
-      printf("    Product VDO 1: 0x%08x\n", id.disc_id.product_type_vdo1);
-      printf("    Product VDO 2: 0x%08x\n", id.disc_id.product_type_vdo2);
-      printf("    Product VDO 3: 0x%08x\n", id.disc_id.product_type_vdo3);
+      case LIBTYPEC_PRODUCT_TYPE_PD2P0_PASSIVE_CABLE:
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_PASSIVE_CABLE:
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_PASSIVE_CABLE:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_PASSIVE_CABLE, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD2P0_ACTIVE_CABLE:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_ACTIVE_CABLE1, -1, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P0_ACTIVE_CABLE:
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_ACTIVE_CABLE:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_ACTIVE_CABLE1, LIBTYPEC_VDO_ACTIVE_CABLE2, -1);
+        break;
+      case LIBTYPEC_PRODUCT_TYPE_PD3P1_VPD:
+        print_product_vdos(rev, &id, LIBTYPEC_VDO_VPD, -1, -1);
+        break;
+      default:
+        print_product_vdos(rev, &id, -1, -1, -1);
+        break;
     }
   }
 }
@@ -555,51 +333,8 @@ void print_source_pdo_data(unsigned int* pdo_data, int num_pdos, int revision) {
   for (int i = 0; i < num_pdos; i++) {
     printf("    PDO%d: 0x%08x\n", i+1, pdo_data[i]);
 
-    if (verbose) {
-      if (revision == 0x200) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 10, pd2p0_fixed_supply_src_fields, pd2p0_fixed_supply_src_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd2p0_battery_supply_src_fields, pd2p0_battery_supply_src_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd2p0_variable_supply_src_fields, pd2p0_variable_supply_src_field_desc);
-            break;
-        }
-      } else if (revision == 0x300) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 11, pd3p0_fixed_supply_src_fields, pd3p0_fixed_supply_src_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd3p0_battery_supply_src_fields, pd3p0_battery_supply_src_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd3p0_variable_supply_src_fields, pd3p0_variable_supply_src_field_desc);
-            break;
-          case PDO_AUGMENTED:
-            print_vdo(pdo_data[i], 9, pd3p0_pps_apdo_src_fields, pd3p0_pps_apdo_src_field_desc);
-            break;
-        }
-      } else if (revision == 0x310) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 12, pd3p1_fixed_supply_src_fields, pd3p1_fixed_supply_src_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd3p1_battery_supply_src_fields, pd3p1_battery_supply_src_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd3p1_variable_supply_src_fields, pd3p1_variable_supply_src_field_desc);
-            break;
-          case PDO_AUGMENTED:
-            print_vdo(pdo_data[i], 9, pd3p1_pps_apdo_src_fields, pd3p1_pps_apdo_src_field_desc);
-            break;
-        }
-      }
-    }
+    if (verbose)
+      print_pdo(revision, 1, pdo_data[i]);
   }
 }
 
@@ -607,54 +342,356 @@ void print_sink_pdo_data(unsigned int* pdo_data, int num_pdos, int revision) {
   for (int i = 0; i < num_pdos; i++) {
     printf("    PDO%d: 0x%08x\n", i+1, pdo_data[i]);
 
-    if (verbose) {
-      if (revision == 0x200) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 9, pd2p0_fixed_supply_snk_fields, pd2p0_fixed_supply_snk_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd2p0_battery_supply_snk_fields, pd2p0_battery_supply_snk_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd2p0_variable_supply_snk_fields, pd2p0_variable_supply_snk_field_desc);
-            break;
-        }
-      } else if (revision == 0x300) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 10, pd3p0_fixed_supply_snk_fields, pd3p0_fixed_supply_snk_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd3p0_battery_supply_snk_fields, pd3p0_battery_supply_snk_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd3p0_variable_supply_snk_fields, pd3p0_variable_supply_snk_field_desc);
-            break;
-          case PDO_AUGMENTED:
-            print_vdo(pdo_data[i], 8, pd3p0_pps_apdo_snk_fields, pd3p0_pps_apdo_snk_field_desc);
-            break;
-        }
-      } else if (revision == 0x310) {
-        switch((pdo_data[i] >> 30)) {
-          case PDO_FIXED:
-            print_vdo(pdo_data[i], 10, pd3p1_fixed_supply_snk_fields, pd3p1_fixed_supply_snk_field_desc);
-            break;
-          case PDO_BATTERY:
-            print_vdo(pdo_data[i], 4, pd3p1_battery_supply_snk_fields, pd3p1_battery_supply_snk_field_desc);
-            break;
-          case PDO_VARIABLE:
-            print_vdo(pdo_data[i], 4, pd3p1_variable_supply_snk_fields, pd3p1_variable_supply_snk_field_desc);
-            break;
-          case PDO_AUGMENTED:
-            print_vdo(pdo_data[i], 8, pd3p1_pps_apdo_snk_fields, pd3p1_pps_apdo_snk_field_desc);
-            break;
-        }
-      }
-    }
+    if (verbose)
+      print_pdo(revision, 0, pdo_data[i]);
   }
 }
 
+/**
+ * Queries everything lstypec reports about one connector.
+ *
+ * @param conn_num Connector to query.
+ * @param port Filled with the results.
+ * @param status Also query the connector status, only reported in JSON.
+ */
+void collect_port(int conn_num, struct lstypec_port *port, int status)
+{
+  int num_pdos;
+
+  memset(port, 0, sizeof(*port));
+
+  port->conn_cap_ret = libtypec_get_conn_capability(conn_num, &port->conn_cap);
+  port->conn_sts_ret = status ? libtypec_get_connector_status(conn_num, &port->conn_sts) : -1;
+
+  port->cable.cable_type = CABLE_TYPE_UNKNOWN;
+  port->cable.plug_end_type = PLUG_TYPE_OTH;
+  port->cable_ret = libtypec_get_cable_properties(conn_num, &port->cable);
+
+  for (int i = 0; i < 4; i++) {
+    num_pdos = 0;
+    if (libtypec_get_pdos(conn_num, i >> 1, 0, &num_pdos, i & 1, 0, port->pdos[i]) > 0)
+      port->num_pdos[i] = num_pdos < LSTYPEC_MAX_PDOS ? num_pdos : LSTYPEC_MAX_PDOS;
+  }
+
+  for (int i = AM_CONNECTOR; i <= AM_SOP_PR; i++) {
+    port->num_modes[i] = libtypec_get_alternate_modes(i, conn_num, port->modes[i]);
+    if (port->num_modes[i] > LSTYPEC_MAX_MODES)
+      port->num_modes[i] = LSTYPEC_MAX_MODES;
+  }
+
+  for (int i = 0; i < 2; i++)
+    port->id_ret[i] = libtypec_get_pd_message(AM_SOP + i, conn_num, 24, DISCOVER_ID_REQ, port->id[i].buf_disc_id);
+}
+
+/* Bold while printing a section that changed since the last report */
+void section_begin(unsigned int section)
+{
+  if (highlight_mask & section)
+    printf("\033[1m");
+}
+
+void section_end(unsigned int section)
+{
+  if (highlight_mask & section)
+    printf("\033[0m");
+}
+
+void print_port(int conn_num, struct lstypec_port *port)
+{
+  // Connector Capabilities
+  printf("\nConnector %d Capability/Status\n", conn_num);
+  section_begin(LSTYPEC_SEC_CAP);
+  print_conn_capability(port->conn_cap);
+  section_end(LSTYPEC_SEC_CAP);
+
+  // Connector PDOs
+  if (port->num_pdos[1] > 0) {
+    section_begin(LSTYPEC_SEC_PDO_SOURCE);
+    printf("  Connector PDO Data (Source):\n");
+    print_source_pdo_data(port->pdos[1], port->num_pdos[1], get_cap_data.bcdPDVersion);
+    section_end(LSTYPEC_SEC_PDO_SOURCE);
+  }
+
+  if (port->num_pdos[0] > 0) {
+    section_begin(LSTYPEC_SEC_PDO_SINK);
+    printf("  Connector PDO Data (Sink):\n");
+    print_sink_pdo_data(port->pdos[0], port->num_pdos[0], get_cap_data.bcdPDVersion);
+    section_end(LSTYPEC_SEC_PDO_SINK);
+  }
+
+  // Cable Properties
+  if (port->cable_ret >= 0) {
+    section_begin(LSTYPEC_SEC_CABLE);
+    print_cable_prop(port->cable, conn_num);
+    section_end(LSTYPEC_SEC_CABLE);
+  }
+
+  // Supported Alternate Modes
+  printf("  Alternate Modes Supported:\n");
+
+  section_begin(LSTYPEC_SEC_MODES_LOCAL);
+  if (port->num_modes[AM_CONNECTOR] > 0)
+    print_alternate_mode_data(AM_CONNECTOR, 0x0, port->num_modes[AM_CONNECTOR], port->modes[AM_CONNECTOR]);
+  else
+    printf("    No Local Modes listed with typec class\n");
+  section_end(LSTYPEC_SEC_MODES_LOCAL);
+
+  // Cable
+  section_begin(LSTYPEC_SEC_MODES_CABLE);
+  if (port->num_modes[AM_SOP_PR] >= 0)
+    print_alternate_mode_data(AM_SOP_PR, port->id[AM_SOP_PR - 1].disc_id.id_header, port->num_modes[AM_SOP_PR], port->modes[AM_SOP_PR]);
+  section_end(LSTYPEC_SEC_MODES_CABLE);
+  section_begin(LSTYPEC_SEC_ID_CABLE);
+  if (port->id_ret[AM_SOP_PR - 1] >= 0)
+    print_identity_data(AM_SOP_PR, port->id[AM_SOP_PR - 1], port->conn_cap);
+  section_end(LSTYPEC_SEC_ID_CABLE);
+
+  // Partner
+  section_begin(LSTYPEC_SEC_MODES_PARTNER);
+  if (port->num_modes[AM_SOP] >= 0)
+    print_alternate_mode_data(AM_SOP, port->id[AM_SOP - 1].disc_id.id_header, port->num_modes[AM_SOP], port->modes[AM_SOP]);
+  section_end(LSTYPEC_SEC_MODES_PARTNER);
+  section_begin(LSTYPEC_SEC_ID_PARTNER);
+  if (port->id_ret[AM_SOP - 1] >= 0)
+    print_identity_data(AM_SOP, port->id[AM_SOP - 1], port->conn_cap);
+  section_end(LSTYPEC_SEC_ID_PARTNER);
+
+  if (port->num_pdos[3] > 0) {
+    section_begin(LSTYPEC_SEC_PARTNER_PDO_SOURCE);
+    printf("  Partner PDO Data (Source):\n");
+    print_source_pdo_data(port->pdos[3], port->num_pdos[3], port->conn_cap.partner_rev);
+    section_end(LSTYPEC_SEC_PARTNER_PDO_SOURCE);
+  }
+
+  if (port->num_pdos[2] > 0) {
+    section_begin(LSTYPEC_SEC_PARTNER_PDO_SINK);
+    printf("  Partner PDO Data (Sink):\n");
+    print_sink_pdo_data(port->pdos[2], port->num_pdos[2], port->conn_cap.partner_rev);
+    section_end(LSTYPEC_SEC_PARTNER_PDO_SINK);
+  }
+}
+
+/**
+ * Starts the JSON output. Library diagnostics are printed on stdout, so
+ * stdout is moved to stderr and the document goes to a private copy of
+ * the original descriptor.
+ *
+ * @param seq Emit RFC 7464 JSON text sequences instead of one document.
+ */
+void json_begin(int seq)
+{
+  char version[32];
+  int fd;
+
+  snprintf(version, sizeof(version), "%d.%d.%d", LSTYPEC_MAJOR_VERSION, LSTYPEC_MINOR_VERSION, LSTYPEC_PATCH_VERSION);
+
+  fflush(stdout);
+  fd = dup(STDOUT_FILENO);
+  if (fd < 0)
+    lstypec_print("Failed in duplicating stdout", LSTYPEC_ERROR);
+  dup2(STDERR_FILENO, STDOUT_FILENO);
+
+  json_init(&jw, fd, seq);
+
+  json_record_begin(&jw);
+  json_object_begin(&jw, NULL);
+  if (seq)
+    json_string(&jw, "type", "session");
+  json_string(&jw, "schema", "lstypec");
+  json_uint(&jw, "schema_version", LSTYPEC_JSON_SCHEMA_VERSION);
+
+  json_object_begin(&jw, "session");
+  json_string(&jw, "lstypec", version);
+  json_string(&jw, "libtypec", session_info[LIBTYPEC_VERSION_INDEX]);
+  json_string(&jw, "os", session_info[LIBTYPEC_OS_INDEX]);
+  json_string(&jw, "kernel", session_info[LIBTYPEC_KERNEL_INDEX]);
+  json_string(&jw, "backend", session_info[LIBTYPEC_OPS_INDEX]);
+  json_string(&jw, "routing", libtypec_get_routing());
+  json_object_end(&jw);
+
+  if (seq) {
+    json_object_end(&jw);
+    json_record_end(&jw);
+  }
+}
+
+void json_print_ppm(struct libtypec_capability_data *cap)
+{
+  if (jw.seq) {
+    json_record_begin(&jw);
+    json_object_begin(&jw, NULL);
+    json_string(&jw, "type", "ppm");
+  } else {
+    json_object_begin(&jw, "ppm");
+  }
+
+  json_uint(&jw, "attributes", cap->bmAttributes);
+  json_uint(&jw, "num_connectors", cap->bNumConnectors);
+  json_uint(&jw, "optional_features", cap->bmOptionalFeatures);
+  json_uint(&jw, "num_alt_modes", cap->bNumAltModes);
+  json_uint(&jw, "bcd_bc_version", cap->bcdBCVersion);
+  json_uint(&jw, "bcd_pd_version", cap->bcdPDVersion);
+  json_uint(&jw, "bcd_typec_version", cap->bcdTypeCVersion);
+  json_object_end(&jw);
+
+  if (jw.seq) {
+    json_record_end(&jw);
+  } else {
+    json_array_begin(&jw, "connectors");
+    json_flush(&jw);
+  }
+}
+
+void json_print_pdos(const char *key, unsigned int *pdos, int num_pdos)
+{
+  json_array_begin(&jw, key);
+  for (int i = 0; i < num_pdos; i++)
+    json_uint(&jw, NULL, pdos[i]);
+  json_array_end(&jw);
+}
+
+void json_print_modes(const char *key, struct altmode_data *modes, int num_modes)
+{
+  char svid_str[128];
+
+  if (num_modes < 0) {
+    json_null(&jw, key);
+    return;
+  }
+
+  json_array_begin(&jw, key);
+  for (int i = 0; i < num_modes; i++) {
+    get_svid_string(modes[i].svid, svid_str, sizeof(svid_str));
+    json_object_begin(&jw, NULL);
+    json_uint(&jw, "svid", modes[i].svid);
+    json_uint(&jw, "vdo", modes[i].vdo);
+    json_string(&jw, "name", svid_str);
+    json_object_end(&jw);
+  }
+  json_array_end(&jw);
+}
+
+void json_print_identity(const char *key, int ret, union libtypec_discovered_identity *id)
+{
+  if (ret < 0) {
+    json_null(&jw, key);
+    return;
+  }
+
+  json_object_begin(&jw, key);
+  json_uint(&jw, "id_header", id->disc_id.id_header);
+  json_uint(&jw, "cert_stat", id->disc_id.cert_stat);
+  json_uint(&jw, "product", id->disc_id.product);
+  json_array_begin(&jw, "product_type_vdo");
+  json_uint(&jw, NULL, id->disc_id.product_type_vdo1);
+  json_uint(&jw, NULL, id->disc_id.product_type_vdo2);
+  json_uint(&jw, NULL, id->disc_id.product_type_vdo3);
+  json_array_end(&jw);
+  json_object_end(&jw);
+}
+
+/**
+ * Writes one connector and hands it to the kernel right away, so
+ * consumers see each port as soon as it has been collected.
+ */
+void json_print_port(int conn_num, struct lstypec_port *port)
+{
+  char *cable_type[] = {"Passive", "Active", "Unknown"};
+  char *cable_plug_type[] = {"USB Type A", "USB Type B", "USB Type C", "Non-USB Type", "Unknown"};
+
+  if (jw.seq)
+    json_record_begin(&jw);
+
+  json_object_begin(&jw, NULL);
+  if (jw.seq)
+    json_string(&jw, "type", "connector");
+  json_uint(&jw, "index", conn_num);
+
+  if (port->conn_cap_ret >= 0) {
+    json_object_begin(&jw, "capability");
+    json_uint(&jw, "opr_mode", port->conn_cap.opr_mode);
+    json_bool(&jw, "provider", port->conn_cap.provider);
+    json_bool(&jw, "consumer", port->conn_cap.consumer);
+    json_bool(&jw, "swap_to_dfp", port->conn_cap.swap2dfp);
+    json_bool(&jw, "swap_to_ufp", port->conn_cap.swap2ufp);
+    json_bool(&jw, "swap_to_src", port->conn_cap.swap2src);
+    json_bool(&jw, "swap_to_snk", port->conn_cap.swap2snk);
+    json_uint(&jw, "partner_pd_rev", port->conn_cap.partner_rev);
+    json_uint(&jw, "cable_pd_rev", port->conn_cap.cable_rev);
+    json_object_end(&jw);
+  } else {
+    json_null(&jw, "capability");
+  }
+
+  if (port->conn_sts_ret >= 0) {
+    json_object_begin(&jw, "status");
+    json_bool(&jw, "connected", port->conn_sts.connect_sts);
+    json_uint(&jw, "change", port->conn_sts.sts_change);
+    json_uint(&jw, "power_op_mode", port->conn_sts.pwr_op_mode);
+    json_uint(&jw, "power_dir", port->conn_sts.pwr_dir);
+    json_uint(&jw, "partner_flags", port->conn_sts.ptnr_flags);
+    json_uint(&jw, "partner_type", port->conn_sts.ptnr_type);
+    json_uint(&jw, "rdo", port->conn_sts.rdo);
+    json_uint(&jw, "battery_charging_status", port->conn_sts.bat_chrg_cap_sts);
+    json_uint(&jw, "limited_reason", port->conn_sts.cap_ltd_reason);
+    json_uint(&jw, "bcd_pd_version_op_mode", port->conn_sts.bcdPDVer_op_mode);
+    json_object_end(&jw);
+  } else {
+    json_null(&jw, "status");
+  }
+
+  json_object_begin(&jw, "pdos");
+  json_print_pdos("source", port->pdos[1], port->num_pdos[1]);
+  json_print_pdos("sink", port->pdos[0], port->num_pdos[0]);
+  json_object_end(&jw);
+
+  if (port->cable_ret >= 0) {
+    json_object_begin(&jw, "cable");
+    json_string(&jw, "type", port->cable.cable_type < 3 ? cable_type[port->cable.cable_type] : "Unknown");
+    json_string(&jw, "plug_type", port->cable.plug_end_type < 5 ? cable_plug_type[port->cable.plug_end_type] : "Unknown");
+    json_uint(&jw, "speed_supported", port->cable.speed_supported);
+    json_uint(&jw, "current_capability", port->cable.current_capability);
+    json_bool(&jw, "vbus_support", port->cable.vbus_support);
+    json_bool(&jw, "directionality", port->cable.directionality);
+    json_bool(&jw, "mode_support", port->cable.mode_support);
+    json_uint(&jw, "latency", port->cable.latency);
+    json_print_identity("identity", port->id_ret[AM_SOP_PR - 1], &port->id[AM_SOP_PR - 1]);
+    json_print_modes("alt_modes", port->modes[AM_SOP_PR], port->num_modes[AM_SOP_PR]);
+    json_object_end(&jw);
+  } else {
+    json_null(&jw, "cable");
+  }
+
+  json_print_modes("alt_modes", port->modes[AM_CONNECTOR], port->num_modes[AM_CONNECTOR]);
+
+  json_object_begin(&jw, "partner");
+  json_print_identity("identity", port->id_ret[AM_SOP - 1], &port->id[AM_SOP - 1]);
+  json_print_modes("alt_modes", port->modes[AM_SOP], port->num_modes[AM_SOP]);
+  json_object_begin(&jw, "pdos");
+  json_print_pdos("source", port->pdos[3], port->num_pdos[3]);
+  json_print_pdos("sink", port->pdos[2], port->num_pdos[2]);
+  json_object_end(&jw);
+  json_object_end(&jw);
+
+  json_object_end(&jw);
+
+  if (jw.seq)
+    json_record_end(&jw);
+  else
+    json_flush(&jw);
+}
+
+void json_end(void)
+{
+  if (!jw.seq) {
+    json_array_end(&jw);
+    json_object_end(&jw);
+    json_record_end(&jw);
+  }
+
+  close(jw.fd);
+}
+
 void lstypec_print(char *val, int type)
 {
     if (type == LSTYPEC_ERROR)
@@ -666,28 +703,200 @@ void lstypec_print(char *val, int type)
         printf("lstypec - INFO - %s\n", val);
 }
 
+/**
+ * Compares two reports of the same connector.
+ *
+ * @returns mask of LSTYPEC_SEC_* sections that differ, 0 when unchanged.
+ */
+unsigned int port_changes(const struct lstypec_port *old, const struct lstypec_port *new)
+{
+  static const unsigned int pdo_sec[4] = {LSTYPEC_SEC_PDO_SINK, LSTYPEC_SEC_PDO_SOURCE, LSTYPEC_SEC_PARTNER_PDO_SINK, LSTYPEC_SEC_PARTNER_PDO_SOURCE};
+  static const unsigned int mode_sec[3] = {LSTYPEC_SEC_MODES_LOCAL, LSTYPEC_SEC_MODES_PARTNER, LSTYPEC_SEC_MODES_CABLE};
+  unsigned int mask = 0;
+
+  if (old->conn_cap_ret != new->conn_cap_ret || memcmp(&old->conn_cap, &new->conn_cap, sizeof(new->conn_cap)))
+    mask |= LSTYPEC_SEC_CAP;
+  if (old->conn_sts_ret != new->conn_sts_ret || memcmp(&old->conn_sts, &new->conn_sts, sizeof(new->conn_sts)))
+    mask |= LSTYPEC_SEC_STATUS;
+  if (old->cable_ret != new->cable_ret || memcmp(&old->cable, &new->cable, sizeof(new->cable)))
+    mask |= LSTYPEC_SEC_CABLE;
+
+  for (int i = 0; i < 4; i++)
+    if (old->num_pdos[i] != new->num_pdos[i] || memcmp(old->pdos[i], new->pdos[i], new->num_pdos[i] * sizeof(unsigned int)))
+      mask |= pdo_sec[i];
+
+  for (int i = 0; i < 3; i++)
+    if (old->num_modes[i] != new->num_modes[i] ||
+        (new->num_modes[i] > 0 && memcmp(old->modes[i], new->modes[i], new->num_modes[i] * sizeof(struct altmode_data))))
+      mask |= mode_sec[i];
+
+  if (old->id_ret[0] != new->id_ret[0] || memcmp(&old->id[0], &new->id[0], sizeof(new->id[0])))
+    mask |= LSTYPEC_SEC_ID_PARTNER;
+  if (old->id_ret[1] != new->id_ret[1] || memcmp(&old->id[1], &new->id[1], sizeof(new->id[1])))
+    mask |= LSTYPEC_SEC_ID_CABLE;
+
+  return mask;
+}
+
+/**
+ * Called by libtypec for every Type-C uevent. Re-collects the connector
+ * the event names, or every connector when it names none, and reports
+ * only the ones whose state actually changed.
+ */
+void watch_event(enum usb_typec_event event, void *data)
+{
+  char stamp[16];
+  time_t now;
+  unsigned int mask;
+  int first = 0, last = watch_num_ports;
+  int event_port = libtypec_get_event_port();
+
+  if (event_port >= 0 && event_port < watch_num_ports) {
+    first = event_port;
+    last = event_port + 1;
+  }
+
+  for (int i = first; i < last; i++) {
+    collect_port(i, &port, watch_json);
+
+    mask = port_changes(&watch_ports[i], &port);
+    if (!mask)
+      continue;
+
+    watch_ports[i] = port;
+
+    if (watch_json) {
+      json_print_port(i, &port);
+      continue;
+    }
+
+    now = time(NULL);
+    strftime(stamp, sizeof(stamp), "%H:%M:%S", localtime(&now));
+    printf("\n[%s] Connector %d changed\n", stamp, i);
+
+    highlight_mask = highlight ? mask : 0;
+    print_port(i, &port);
+    highlight_mask = 0;
+  }
+
+  fflush(stdout);
+}
+
+/**
+ * Prints the topology once and then reports connectors as they change
+ * until the process is interrupted.
+ */
+void watch_ports_run(int json)
+{
+  watch_json = json;
+  watch_num_ports = get_cap_data.bNumConnectors;
+  watch_ports = calloc(watch_num_ports ? watch_num_ports : 1, sizeof(*watch_ports));
+  if (!watch_ports)
+    lstypec_print("Failed in allocating port state", LSTYPEC_ERROR);
+
+  for (int i = 0; i < watch_num_ports; i++) {
+    collect_port(i, &watch_ports[i], json);
+
+    if (json)
+      json_print_port(i, &watch_ports[i]);
+    else
+      print_port(i, &watch_ports[i]);
+  }
+  fflush(stdout);
+
+  for (int event = 0; event < USBC_EVENT_COUNT; event++)
+    libtypec_register_typec_notification_callback(event, watch_event, NULL);
+
+  // Blocks for as long as the backend delivers events
+  libtypec_monitor_events();
+
+  for (int event = 0; event < USBC_EVENT_COUNT; event++)
+    libtypec_unregister_typec_notification_callback(event, watch_event);
+
+  free(watch_ports);
+}
+
 int main(int argc, char *argv[])
 {
-  int ret, opt, num_modes, num_pdos;
+  int ret, opt, json = 0, watch = 0;
+  char *snapshot_path = NULL;
+  char *fixture_path = NULL;
 
   // Process Command Args
   static const struct option options[] = {
     {"verbose", 0, 0, 'v'},
+    {"snapshot", 1, 0, 's'},
+    {"record", 1, 0, 'r'},
+    {"fixture", 1, 0, 'f'},
+    {"json", 0, 0, 'j'},
+    {"json-seq", 0, 0, 'J'},
+    {"watch", 0, 0, 'w'},
+    {"highlight", 0, 0, 'H'},
     {"help", 0, 0, 'h'},
     {0, 0, 0, 0},
   };
 
-  while ((opt = getopt_long(argc, argv, "vh", options, NULL)) != -1) {
+  while ((opt = getopt_long(argc, argv, "vs:r:f:jJwHh", options, NULL)) != -1) {
     switch (opt) {
     case 'v':
       verbose = 1;
       break;
+    case 's':
+    case 'r':
+      snapshot_path = optarg;
+      break;
+    case 'f':
+      fixture_path = optarg;
+      break;
+    case 'j':
+      json = 1;
+      break;
+    case 'J':
+      json = 2;
+      break;
+    case 'w':
+      watch = 1;
+      break;
+    case 'H':
+      highlight = 1;
+      break;
     case 'h':
-      printf("lstypec will print information about connected USB-C devices\n-v to increase verbosity\n-h for help\n");
+      printf("lstypec will print information about connected USB-C devices\n-v to increase verbosity\n-s, -r <file> to save a binary snapshot of the topology\n-f <file> to replay a recorded topology instead of this machine\n-j, --json to print a JSON document\n-J, --json-seq to print one JSON text sequence record per connector\n-w, --watch to keep running and report connectors as they change\n-H, --highlight to print changed sections in bold with --watch\n-h for help\n");
       return 0;
     }
   }
 
+  if (fixture_path && libtypec_fixture_load(fixture_path) < 0)
+    lstypec_print("Failed in loading fixture", LSTYPEC_ERROR);
+
+  if (snapshot_path) {
+    int fd;
+
+    ret = libtypec_init(session_info);
+    if (ret < 0)
+      lstypec_print("Failed in Initializing libtypec", LSTYPEC_ERROR);
+
+    fd = open(snapshot_path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+      lstypec_print("Failed to create snapshot file", LSTYPEC_ERROR);
+
+    ret = libtypec_snapshot_write(fd);
+    close(fd);
+    if (ret < 0)
+      lstypec_print("Failed in writing snapshot", LSTYPEC_ERROR);
+
+    libtypec_exit();
+    return 0;
+  }
+
+  // A document never ends in watch mode, stream records instead
+  if (watch && json)
+    json = 2;
+
+  // One large buffer instead of a syscall per line
+  if (!json)
+    setvbuf(stdout, NULL, _IOFBF, JSON_BUF_SIZE);
+
   names_init();
 
   // Initialize libtypec and print session info
@@ -695,90 +904,42 @@ int main(int argc, char *argv[])
   if (ret < 0)
     lstypec_print("Failed in Initializing libtypec", LSTYPEC_ERROR);
 
-  print_session_info();
-
   // PPM Capabilities
   ret = libtypec_get_capability(&get_cap_data);
   if (ret < 0)
     lstypec_print("Failed in Get Capability", LSTYPEC_ERROR);
 
-  print_ppm_capability(get_cap_data);
+  if (json) {
+    json_begin(json == 2);
+    json_print_ppm(&get_cap_data);
+  } else {
+    print_session_info();
+    print_ppm_capability(get_cap_data);
+  }
+
+  if (watch) {
+    watch_ports_run(json);
+    libtypec_exit();
+    names_exit();
+    return 0;
+  }
 
   for (int i = 0; i < get_cap_data.bNumConnectors; i++) {
-    // Resetting port properties
-    cable_prop.cable_type = CABLE_TYPE_UNKNOWN;
-    cable_prop.plug_end_type = PLUG_TYPE_OTH;
-
-    // Connector Capabilities
-    printf("\nConnector %d Capability/Status\n", i);
-    libtypec_get_conn_capability(i, &conn_data);
-    print_conn_capability(conn_data);
-
-
-    // Connector PDOs
-    pdo_data = malloc(sizeof(int)*8);
-    ret = libtypec_get_pdos(i, 0, 0, &num_pdos, 1, 0, pdo_data);
-    if (ret > 0) {
-      printf("  Connector PDO Data (Source):\n");
-      print_source_pdo_data(pdo_data, num_pdos, get_cap_data.bcdPDVersion);
-    }
+    collect_port(i, &port, json);
 
-    ret = libtypec_get_pdos(i, 0, 0, &num_pdos, 0, 0, pdo_data);
-    if (ret > 0) {
-      printf("  Connector PDO Data (Sink):\n");
-      print_source_pdo_data(pdo_data, num_pdos, get_cap_data.bcdPDVersion);
-    }
-    free(pdo_data);
-
-    // Cable Properties
-    ret = libtypec_get_cable_properties(i, &cable_prop);
-    if (ret >= 0)
-      print_cable_prop(cable_prop, i);
-    
-    // Supported Alternate Modes
-    printf("  Alternate Modes Supported:\n");
-  
-    num_modes = libtypec_get_alternate_modes(AM_CONNECTOR, i, am_data);
-    if (num_modes > 0)
-      print_alternate_mode_data(AM_CONNECTOR, 0x0, num_modes, am_data);
+    if (json)
+      json_print_port(i, &port);
     else
-      printf("    No Local Modes listed with typec class\n");
-   
-    // Cable
-    num_modes = libtypec_get_alternate_modes(AM_SOP_PR, i, am_data);
-    if (num_modes >= 0) 
-      print_alternate_mode_data(AM_SOP_PR, id.disc_id.id_header, num_modes, am_data);
-    ret = libtypec_get_pd_message(AM_SOP_PR, i, 24, DISCOVER_ID_REQ, id.buf_disc_id);
-    if (ret >= 0) {
-      print_identity_data(AM_SOP_PR, id, conn_data);
-    }
-    
-    // Partner
-    num_modes = libtypec_get_alternate_modes(AM_SOP, i, am_data);
-    if (num_modes >= 0) 
-      print_alternate_mode_data(AM_SOP, id.disc_id.id_header, num_modes, am_data);
-    ret = libtypec_get_pd_message(AM_SOP, i, 24, DISCOVER_ID_REQ, id.buf_disc_id);
-    if (ret >= 0) {
-      print_identity_data(AM_SOP, id, conn_data);
-    }
-    pdo_data = malloc(sizeof(int)*8);
-    
-    ret = libtypec_get_pdos(i, 1, 0, &num_pdos, 1, 0, pdo_data);
-    if (ret > 0) {
-      printf("  Partner PDO Data (Source):\n");
-      print_source_pdo_data(pdo_data, num_pdos, conn_data.partner_rev);
-    }
-   
-    ret = libtypec_get_pdos(i, 1, 0, &num_pdos, 0, 0, pdo_data);
-    if (ret > 0) {
-      printf("  Partner PDO Data (Sink):\n");
-      print_sink_pdo_data(pdo_data, num_pdos, conn_data.partner_rev);
-    }
-  
-    free(pdo_data);
+      print_port(i, &port);
   }
 
-  printf("\n");
+  if (json)
+    json_end();
+  else
+    printf("\n");
+
+  libtypec_exit();
   names_exit();
-}
 
+  return 0;
+}
@@ -20,30 +20,248 @@
 #include <libudev.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "usb_ids_hash.h"
+#include "usb_ids_table.h"
 
 static struct udev *udev = NULL;
 static struct udev_hwdb *hwdb = NULL;
+static int hwdb_opened;
+
+/*
+ * Vendor names come from the table built into the binary from usb.ids, so
+ * most runs never initialize udev. hwdb is opened on first use: product
+ * lookups and vendors missing from the table. Setting TYPEC_NAMES_HWDB in
+ * the environment makes hwdb take precedence for vendors as well.
+ */
+static int hwdb_override;
+
+/*
+ * hwdb lookups build a modalias and walk the whole property list, so the
+ * results are cached for the session. Names are interned: every distinct
+ * string is stored once in an arena and cache entries point into it.
+ * Failed lookups are cached as well, as a NULL name.
+ */
+#define NAMES_CACHE_INIT 64     /* power of two */
+#define NAMES_ARENA_CHUNK 4096
+
+#define NAMES_KEY_VENDOR(vid) (0x100000000ull | (vid))
+#define NAMES_KEY_PRODUCT(vid, pid) (0x200000000ull | (uint32_t)(vid) << 16 | (pid))
+
+struct names_entry
+{
+    uint64_t key;               /* 0 marks a free slot */
+    const char *name;
+};
+
+struct names_arena
+{
+    struct names_arena *next;
+    size_t used;
+    size_t size;
+    char data[];
+};
+
+static struct names_entry *names_cache;
+static size_t names_cache_size, names_cache_used;
+static const char **names_strings;
+static size_t names_strings_size, names_strings_used;
+static struct names_arena *names_arena;
 
 int names_init(void)
 {
+    hwdb_override = getenv("TYPEC_NAMES_HWDB") != NULL;
+
+    return 0;
+}
+
+static struct udev_hwdb *names_hwdb(void)
+{
+    if (hwdb_opened)
+        return hwdb;
+    hwdb_opened = 1;
+
     udev = udev_new();
     if (udev == NULL)
     {
-        return -1;
+        return NULL;
     }
     hwdb = udev_hwdb_new(udev);
-    if (hwdb == NULL)
+
+    return hwdb;
+}
+
+static const char *builtin_vendor(u_int16_t vendorid)
+{
+    uint32_t hash = usb_ids_hash(vendorid, USB_IDS_SEED);
+    uint32_t slot = usb_ids_slot(hash, usb_ids_disp[hash & (USB_IDS_NUM_BUCKETS - 1)], USB_IDS_NUM_SLOTS);
+
+    if (usb_ids_name[slot] == USB_IDS_EMPTY || usb_ids_vid[slot] != vendorid)
+        return NULL;
+    return usb_ids_strings + usb_ids_name[slot];
+}
+
+void names_exit(void)
+{
+    struct names_arena *arena;
+
+    while ((arena = names_arena))
     {
+        names_arena = arena->next;
+        free(arena);
+    }
+
+    free(names_cache);
+    free(names_strings);
+    names_cache = NULL;
+    names_strings = NULL;
+    names_cache_size = names_cache_used = 0;
+    names_strings_size = names_strings_used = 0;
+
+    hwdb = udev_hwdb_unref(hwdb);
+    udev = udev_unref(udev);
+    hwdb_opened = 0;
+}
+
+static uint64_t names_hash_key(uint64_t key)
+{
+    /* 64 bit finalizer from MurmurHash3 */
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdull;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ull;
+    key ^= key >> 33;
+    return key;
+}
+
+static uint64_t names_hash_string(const char *str)
+{
+    uint64_t hash = 0xcbf29ce484222325ull;
+
+    while (*str)
+    {
+        hash ^= (unsigned char)*str++;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static char *names_arena_alloc(size_t len)
+{
+    struct names_arena *arena = names_arena;
+    char *ptr;
+
+    if (!arena || arena->size - arena->used < len)
+    {
+        size_t size = len > NAMES_ARENA_CHUNK ? len : NAMES_ARENA_CHUNK;
+
+        arena = malloc(sizeof(*arena) + size);
+        if (!arena)
+            return NULL;
+        arena->used = 0;
+        arena->size = size;
+        arena->next = names_arena;
+        names_arena = arena;
+    }
+
+    ptr = arena->data + arena->used;
+    arena->used += len;
+    return ptr;
+}
+
+static int names_strings_grow(void)
+{
+    size_t size = names_strings_size ? names_strings_size * 2 : NAMES_CACHE_INIT;
+    const char **strings = calloc(size, sizeof(*strings));
+
+    if (!strings)
         return -1;
+
+    for (size_t i = 0; i < names_strings_size; i++)
+    {
+        const char *str = names_strings[i];
+        size_t j;
+
+        if (!str)
+            continue;
+        for (j = names_hash_string(str) & (size - 1); strings[j]; j = (j + 1) & (size - 1))
+            ;
+        strings[j] = str;
     }
 
+    free(names_strings);
+    names_strings = strings;
+    names_strings_size = size;
     return 0;
 }
 
-void names_exit(void)
+/* Returns the single stored copy of @str, NULL when out of memory */
+static const char *names_intern(const char *str)
 {
-    hwdb = udev_hwdb_unref(hwdb);
-    udev = udev_unref(udev);
+    size_t len, i;
+    char *copy;
+
+    if (names_strings_used * 2 >= names_strings_size && names_strings_grow() < 0)
+        return NULL;
+
+    for (i = names_hash_string(str) & (names_strings_size - 1); names_strings[i]; i = (i + 1) & (names_strings_size - 1))
+    {
+        if (strcmp(names_strings[i], str) == 0)
+            return names_strings[i];
+    }
+
+    len = strlen(str) + 1;
+    copy = names_arena_alloc(len);
+    if (!copy)
+        return NULL;
+    memcpy(copy, str, len);
+
+    names_strings[i] = copy;
+    names_strings_used++;
+    return copy;
+}
+
+static int names_cache_grow(void)
+{
+    size_t size = names_cache_size ? names_cache_size * 2 : NAMES_CACHE_INIT;
+    struct names_entry *cache = calloc(size, sizeof(*cache));
+
+    if (!cache)
+        return -1;
+
+    for (size_t i = 0; i < names_cache_size; i++)
+    {
+        size_t j;
+
+        if (!names_cache[i].key)
+            continue;
+        for (j = names_hash_key(names_cache[i].key) & (size - 1); cache[j].key; j = (j + 1) & (size - 1))
+            ;
+        cache[j] = names_cache[i];
+    }
+
+    free(names_cache);
+    names_cache = cache;
+    names_cache_size = size;
+    return 0;
+}
+
+/* Returns the slot holding @key, or the free slot where it belongs */
+static struct names_entry *names_cache_slot(uint64_t key)
+{
+    size_t i;
+
+    if (names_cache_used * 2 >= names_cache_size && names_cache_grow() < 0)
+        return NULL;
+
+    for (i = names_hash_key(key) & (names_cache_size - 1); names_cache[i].key; i = (i + 1) & (names_cache_size - 1))
+    {
+        if (names_cache[i].key == key)
+            break;
+    }
+    return &names_cache[i];
 }
 
 static const char *hwdb_get(const char *modalias, const char *key)
@@ -59,20 +277,56 @@ static const char *hwdb_get(const char *modalias, const char *key)
     return NULL;
 }
 
-const char *names_vendor(u_int16_t vendorid)
+static const char *names_lookup(u_int16_t vendorid, u_int16_t productid, int product)
 {
+    uint64_t key = product ? NAMES_KEY_PRODUCT(vendorid, productid) : NAMES_KEY_VENDOR(vendorid);
+    struct names_entry *entry = names_cache_slot(key);
+    const char *name = NULL;
     char modalias[64];
-    sprintf(modalias, "usb:v%04X*", vendorid);
-    return hwdb_get(modalias, "ID_VENDOR_FROM_DATABASE");
+
+    if (!product && !hwdb_override && (name = builtin_vendor(vendorid)))
+        return name;
+
+    if (entry && entry->key == key)
+        return entry->name;
+
+    if (names_hwdb())
+    {
+        if (product)
+        {
+            sprintf(modalias, "usb:v%04Xp%04X*", vendorid, productid);
+            name = hwdb_get(modalias, "ID_MODEL_FROM_DATABASE");
+        }
+        else
+        {
+            sprintf(modalias, "usb:v%04X*", vendorid);
+            name = hwdb_get(modalias, "ID_VENDOR_FROM_DATABASE");
+        }
+    }
+
+    /* hwdb strings only live until the next query */
+    if (name)
+        name = names_intern(name);
+    else if (!product && hwdb_override)
+        name = builtin_vendor(vendorid);
+
+    if (entry)
+    {
+        entry->key = key;
+        entry->name = name;
+        names_cache_used++;
+    }
+    return name;
 }
 
-const char *names_product(u_int16_t vendorid, u_int16_t productid)
+const char *names_vendor(u_int16_t vendorid)
 {
-    char modalias[64];
-
-    sprintf(modalias, "usb:v%04Xp%04X*", vendorid, productid);
+    return names_lookup(vendorid, 0, 0);
+}
 
-    return hwdb_get(modalias, "ID_MODEL_FROM_DATABASE");
+const char *names_product(u_int16_t vendorid, u_int16_t productid)
+{
+    return names_lookup(vendorid, productid, 1);
 }
 
 int get_vendor_string(char *buf, size_t size, u_int16_t vid)
@@ -0,0 +1,438 @@
+/*
+MIT License
+
+Copyright (c) 2023 Rajaram Regupathy <rajaram.regupathy@gmail.com>
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+
+*/
+// SPDX-License-Identifier: MIT
+/**
+ * @file typecd.c
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Daemon caching the USB Type-C topology for libtypec clients.
+ *
+ * typecd is the single owner of the libtypec kernel interfaces on a host.
+ * Clients linked against libtypec find the daemon socket at init and send
+ * their queries to it. Answers are cached until a typec or power_supply
+ * uevent invalidates them.
+ */
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <libudev.h>
+#include "../libtypec_ops.h"
+
+#define TYPECD_MAX_CLIENTS 64
+#define TYPECD_CACHE_SIZE 256
+
+struct typecd_cache_entry
+{
+    unsigned int generation;
+    struct typecd_request req;
+    struct typecd_response resp;
+};
+
+static struct typecd_cache_entry cache[TYPECD_CACHE_SIZE];
+static unsigned int cache_generation = 1;
+static int typecd_num_ports = -1;
+static volatile sig_atomic_t typecd_stop;
+static int shm_flag;
+char *session_info[LIBTYPEC_SESSION_MAX_INDEX];
+
+static void typecd_signal(int sig)
+{
+    typecd_stop = 1;
+}
+
+static unsigned int typecd_hash(const struct typecd_request *req)
+{
+    const unsigned char *p = (const unsigned char *)req;
+    unsigned int h = 2166136261u;
+
+    for (size_t i = 0; i < sizeof(*req); i++)
+        h = (h ^ p[i]) * 16777619u;
+
+    return h % TYPECD_CACHE_SIZE;
+}
+
+static int typecd_cacheable(unsigned int op)
+{
+    /*
+     * Billboard state follows USB enumeration, not typec uevents, and
+     * power supply readings change with every sample
+     */
+    return op != TYPECD_OP_BB_STATUS && op != TYPECD_OP_BB_DATA && op != TYPECD_OP_POWER_SUPPLY_STATUS;
+}
+
+static void typecd_copy(struct typecd_response *resp, const void *data, int len)
+{
+    if (len < 0)
+        len = 0;
+    if (len > TYPECD_MAX_PAYLOAD)
+        len = TYPECD_MAX_PAYLOAD;
+
+    memcpy(resp->data, data, len);
+    resp->len = len;
+}
+
+static int typecd_valid_conn(int conn_num)
+{
+    struct libtypec_capability_data cap;
+
+    /* Refreshed after every uevent, ports may come and go */
+    if (typecd_num_ports < 0) {
+        memset(&cap, 0, sizeof(cap));
+        if (libtypec_get_capability(&cap) < 0)
+            return 0;
+        typecd_num_ports = cap.bNumConnectors;
+    }
+
+    return conn_num >= 0 && conn_num < typecd_num_ports;
+}
+
+/*
+ * Clients are unprivileged and typecd is not, every argument is checked
+ * before it reaches a backend.
+ */
+static int typecd_valid_args(const struct typecd_request *req)
+{
+    const int *a = req->args;
+    unsigned int num_bb = 0;
+
+    switch (req->op)
+    {
+    case TYPECD_OP_CAPABILITY:
+    case TYPECD_OP_CURRENT_CAM:
+    case TYPECD_OP_BB_STATUS:
+        return 1;
+    case TYPECD_OP_CONN_CAPABILITY:
+    case TYPECD_OP_CAM_SUPPORTED:
+    case TYPECD_OP_CABLE_PROPERTIES:
+    case TYPECD_OP_CONNECTOR_STATUS:
+    case TYPECD_OP_POWER_SUPPLY_STATUS:
+        return typecd_valid_conn(a[0]);
+    case TYPECD_OP_ALTERNATE_MODES:
+        return a[0] >= AM_CONNECTOR && a[0] <= AM_SOP_DPR && typecd_valid_conn(a[1]);
+    case TYPECD_OP_PDOS:
+        return typecd_valid_conn(a[0]) && (a[1] == 0 || a[1] == 1) && a[2] >= 0 && a[2] < LIBTYPEC_MAX_PDOS &&
+               (a[3] == 0 || a[3] == 1) && a[4] >= 0 && a[4] <= PDO_AUGMENTED;
+    case TYPECD_OP_PD_MESSAGE:
+        return a[0] >= AM_SOP && a[0] <= AM_SOP_DPR && typecd_valid_conn(a[1]) &&
+               a[3] >= 0 && a[3] <= DISCOVER_ID_REQ;
+    case TYPECD_OP_BB_DATA:
+        return libtypec_get_bb_status(&num_bb) >= 0 && a[0] >= 1 && a[0] <= (int)num_bb;
+    default:
+        return 0;
+    }
+}
+
+static void typecd_dispatch(const struct typecd_request *req, struct typecd_response *resp)
+{
+    struct libtypec_capability_data cap;
+    struct libtypec_connector_cap_data conn_cap;
+    struct libtypec_connector_status conn_sts;
+    struct libtypec_cable_property cable_prop;
+    struct libtypec_power_supply_status psy_sts;
+    struct altmode_data am[LIBTYPEC_AM_SCRATCH];
+    unsigned int pdos[LIBTYPEC_AM_SCRATCH];
+    unsigned int num_bb = 0;
+    char buf[TYPECD_MAX_PAYLOAD];
+    const int *a = req->args;
+    int num = 0;
+
+    memset(resp, 0, TYPECD_RESPONSE_HDR_LEN);
+
+    if (!typecd_valid_args(req)) {
+        resp->ret = -EINVAL;
+        return;
+    }
+
+    switch (req->op)
+    {
+    case TYPECD_OP_CAPABILITY:
+        memset(&cap, 0, sizeof(cap));
+        resp->ret = libtypec_get_capability(&cap);
+        typecd_copy(resp, &cap, sizeof(cap));
+        break;
+    case TYPECD_OP_CONN_CAPABILITY:
+        memset(&conn_cap, 0, sizeof(conn_cap));
+        resp->ret = libtypec_get_conn_capability(a[0], &conn_cap);
+        typecd_copy(resp, &conn_cap, sizeof(conn_cap));
+        break;
+    case TYPECD_OP_ALTERNATE_MODES:
+        resp->ret = libtypec_get_alternate_modes(a[0], a[1], am);
+        typecd_copy(resp, am, (resp->ret > LIBTYPEC_AM_SCRATCH ? LIBTYPEC_AM_SCRATCH : resp->ret) * (int)sizeof(am[0]));
+        break;
+    case TYPECD_OP_CAM_SUPPORTED:
+        memset(buf, 0, sizeof(buf));
+        resp->ret = libtypec_get_cam_supported(a[0], buf);
+        typecd_copy(resp, buf, resp->ret);
+        break;
+    case TYPECD_OP_CURRENT_CAM:
+        memset(buf, 0, sizeof(buf));
+        resp->ret = libtypec_get_current_cam(buf);
+        typecd_copy(resp, buf, resp->ret);
+        break;
+    case TYPECD_OP_PDOS:
+        resp->ret = libtypec_get_pdos(a[0], a[1], a[2], &num, a[3], a[4], pdos);
+        resp->num = num > LIBTYPEC_MAX_PDOS ? LIBTYPEC_MAX_PDOS : num;
+        typecd_copy(resp, pdos, resp->num * (int)sizeof(pdos[0]));
+        break;
+    case TYPECD_OP_CABLE_PROPERTIES:
+        memset(&cable_prop, 0, sizeof(cable_prop));
+        resp->ret = libtypec_get_cable_properties(a[0], &cable_prop);
+        typecd_copy(resp, &cable_prop, sizeof(cable_prop));
+        break;
+    case TYPECD_OP_CONNECTOR_STATUS:
+        memset(&conn_sts, 0, sizeof(conn_sts));
+        resp->ret = libtypec_get_connector_status(a[0], &conn_sts);
+        typecd_copy(resp, &conn_sts, sizeof(conn_sts));
+        break;
+    case TYPECD_OP_PD_MESSAGE:
+        memset(buf, 0, sizeof(buf));
+        num = (a[2] < 0 || a[2] > TYPECD_MAX_PAYLOAD) ? TYPECD_MAX_PAYLOAD : a[2];
+        resp->ret = libtypec_get_pd_message(a[0], a[1], num, a[3], buf);
+        typecd_copy(resp, buf, resp->ret < 0 ? 0 : num);
+        break;
+    case TYPECD_OP_BB_STATUS:
+        resp->ret = libtypec_get_bb_status(&num_bb);
+        resp->num = num_bb;
+        break;
+    case TYPECD_OP_BB_DATA:
+        memset(buf, 0, sizeof(buf));
+        resp->ret = libtypec_get_bb_data(a[0], buf);
+        typecd_copy(resp, buf, resp->ret);
+        break;
+    case TYPECD_OP_POWER_SUPPLY_STATUS:
+        memset(&psy_sts, 0, sizeof(psy_sts));
+        resp->ret = libtypec_get_power_supply_status(a[0], &psy_sts);
+        typecd_copy(resp, &psy_sts, sizeof(psy_sts));
+        break;
+    default:
+        resp->ret = -EINVAL;
+        break;
+    }
+}
+
+static void typecd_serve(int fd)
+{
+    struct typecd_request req;
+    struct typecd_response resp, *out = &resp;
+    struct typecd_cache_entry *entry;
+
+    if (recv(fd, &req, sizeof(req), 0) != sizeof(req))
+        return;
+
+    entry = &cache[typecd_hash(&req)];
+
+    if (typecd_cacheable(req.op) && entry->generation == cache_generation &&
+        !memcmp(&entry->req, &req, sizeof(req)))
+    {
+        out = &entry->resp;
+    }
+    else
+    {
+        typecd_dispatch(&req, &resp);
+
+        if (typecd_cacheable(req.op))
+        {
+            entry->generation = cache_generation;
+            entry->req = req;
+            memcpy(&entry->resp, &resp, TYPECD_RESPONSE_HDR_LEN + resp.len);
+        }
+    }
+
+    send(fd, out, TYPECD_RESPONSE_HDR_LEN + out->len, MSG_NOSIGNAL);
+}
+
+static void typecd_uevent(struct udev_monitor *mon)
+{
+    struct udev_device *dev = udev_monitor_receive_device(mon);
+    const char *sysname;
+    int port = -1;
+
+    if (!dev)
+        return;
+
+    /* Any change may affect cached answers, a new generation drops them all */
+    cache_generation++;
+    typecd_num_ports = -1;
+
+    sysname = udev_device_get_sysname(dev);
+    if (!strcmp(udev_device_get_subsystem(dev), "typec") && sysname)
+        sscanf(sysname, "port%d", &port);
+
+    if (shm_flag)
+        libtypec_shm_publish_update(port);
+
+    udev_device_unref(dev);
+}
+
+static int typecd_listen(void)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return -1;
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, TYPECD_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+
+    unlink(TYPECD_SOCKET_PATH);
+
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, 16) < 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    /* Unprivileged clients are the reason typecd exists */
+    chmod(TYPECD_SOCKET_PATH, 0666);
+
+    return fd;
+}
+
+int main(int argc, char *argv[])
+{
+    struct pollfd pfds[TYPECD_MAX_CLIENTS + 2];
+    struct udev *udev;
+    struct udev_monitor *mon;
+    int opt, ret, nfds, listen_fd;
+
+    static const struct option options[] = {
+        {"shm", 0, 0, 's'},
+        {"help", 0, 0, 'h'},
+        {0, 0, 0, 0},
+    };
+
+    while ((opt = getopt_long(argc, argv, "sh", options, NULL)) != -1) {
+        switch (opt) {
+        case 's':
+            shm_flag = 1;
+            break;
+        case 'h':
+            printf("typecd caches USB-C topology for libtypec clients\n-s also publish port state in shared memory\n-h for help\n");
+            return 0;
+        }
+    }
+
+    /* typecd itself must talk to the kernel, never to another typecd */
+    setenv("LIBTYPEC_BACKEND", "native", 1);
+
+    ret = libtypec_init(session_info);
+    if (ret < 0)
+    {
+        fprintf(stderr, "typecd - Failed in Initializing libtypec\n");
+        return 1;
+    }
+
+    if (shm_flag && libtypec_shm_publish_init() < 0)
+        fprintf(stderr, "typecd - Unable to publish port state in %s\n", LIBTYPEC_SHM_PATH);
+
+    listen_fd = typecd_listen();
+    if (listen_fd < 0)
+    {
+        fprintf(stderr, "typecd - Unable to listen on %s: %s\n", TYPECD_SOCKET_PATH, strerror(errno));
+        return 1;
+    }
+
+    udev = udev_new();
+    mon = udev_monitor_new_from_netlink(udev, "udev");
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "typec", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply", NULL);
+    udev_monitor_enable_receiving(mon);
+
+    signal(SIGINT, typecd_signal);
+    signal(SIGTERM, typecd_signal);
+
+    pfds[0].fd = listen_fd;
+    pfds[0].events = POLLIN;
+    pfds[1].fd = udev_monitor_get_fd(mon);
+    pfds[1].events = POLLIN;
+    nfds = 2;
+
+    while (!typecd_stop)
+    {
+        if (poll(pfds, nfds, -1) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            break;
+        }
+
+        if (pfds[1].revents & POLLIN)
+            typecd_uevent(mon);
+
+        for (int i = 2; i < nfds; i++)
+        {
+            if (pfds[i].revents & POLLIN)
+                typecd_serve(pfds[i].fd);
+
+            if (pfds[i].revents & (POLLHUP | POLLERR))
+            {
+                close(pfds[i].fd);
+                pfds[i--] = pfds[--nfds];
+            }
+        }
+
+        if (pfds[0].revents & POLLIN)
+        {
+            int fd = accept4(listen_fd, NULL, NULL, SOCK_CLOEXEC);
+
+            if (fd >= 0 && nfds < TYPECD_MAX_CLIENTS + 2)
+            {
+                pfds[nfds].fd = fd;
+                pfds[nfds].events = POLLIN;
+                pfds[nfds].revents = 0;
+                nfds++;
+            }
+            else if (fd >= 0)
+                close(fd);
+        }
+    }
+
+    for (int i = 2; i < nfds; i++)
+        close(pfds[i].fd);
+    close(listen_fd);
+    unlink(TYPECD_SOCKET_PATH);
+
+    udev_monitor_unref(mon);
+    udev_unref(udev);
+
+    if (shm_flag)
+        libtypec_shm_publish_exit();
+
+    libtypec_exit();
+
+    return 0;
+}
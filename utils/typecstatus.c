@@ -37,6 +37,14 @@ SOFTWARE.
 #include <getopt.h>
 #include "libtypec.h"
 #include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <signal.h>
+#include <syslog.h>
+#include <poll.h>
+#include <time.h>
+#include <errno.h>
+#include <libudev.h>
 #include "names.h"
 
 struct libtypec_connector_status conn_sts;
@@ -156,7 +164,7 @@ int typec_status_billboard()
 
                         idx = bb_bos_desc->cap_desc_bmconfig[j];
 
-                        idx = (idx >> k) & 0x3;
+                        idx = (idx >> (k * 2)) & 0x3;
 
                         k++;
 
@@ -213,6 +221,334 @@ int typecstatus_power_contract()
 	return 0;
 }
 
+/*
+ * Background mode: initialize once, then sleep on udev until a Type-C,
+ * power supply or USB device event arrives. Events arriving within
+ * RB_SETTLE_MS of the first one are coalesced, and only the ports they
+ * name are queried again. A notification is emitted for every state
+ * change, to stdout or syslog and optionally to a script.
+ */
+#define RB_SETTLE_MS 100
+#define RB_MAX_PORTS 32
+#define RB_MAX_AUMS 64
+#define RB_ALL_PORTS 0xffffffffu
+
+struct rb_port_state
+{
+    int valid;
+    unsigned int connected;
+    unsigned int rdo;
+    unsigned int pwr_op_mode;
+    unsigned int pwr_dir;
+};
+
+struct rb_aum
+{
+    int device;
+    unsigned int svid;
+    int state;
+};
+
+static int rb_flag, syslog_flag;
+static char *notify_cmd;
+static volatile sig_atomic_t rb_stop;
+
+static struct rb_port_state rb_ports[RB_MAX_PORTS];
+static int rb_num_ports;
+static struct rb_aum rb_aums[RB_MAX_AUMS];
+static int rb_num_aums = -1;
+
+static void rb_notify(int port, const char *event, const char *fmt, ...)
+{
+    char msg[256], stamp[32];
+    time_t now = time(NULL);
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, ap);
+    va_end(ap);
+
+    if (syslog_flag)
+        syslog(LOG_NOTICE, "%s", msg);
+    else
+    {
+        strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&now));
+        printf("[%s] %s\n", stamp, msg);
+        fflush(stdout);
+    }
+
+    if (notify_cmd && fork() == 0)
+    {
+        char port_str[16];
+
+        snprintf(port_str, sizeof(port_str), "%d", port);
+        setenv("TYPEC_EVENT", event, 1);
+        setenv("TYPEC_PORT", port_str, 1);
+        setenv("TYPEC_MESSAGE", msg, 1);
+        execl("/bin/sh", "sh", "-c", notify_cmd, (char *)NULL);
+        _exit(127);
+    }
+}
+
+static void rb_evaluate_port(int port)
+{
+    struct rb_port_state *old = &rb_ports[port];
+    struct rb_port_state cur = {0};
+    struct libtypec_connector_status sts = {0};
+
+    if (libtypec_get_connector_status(port, &sts) >= 0)
+    {
+        cur.valid = 1;
+        cur.connected = sts.connect_sts;
+        cur.rdo = sts.rdo;
+        cur.pwr_op_mode = sts.pwr_op_mode;
+        cur.pwr_dir = sts.pwr_dir;
+    }
+
+    if (cur.valid != old->valid && !cur.valid)
+        rb_notify(port, "error", "Port %d: unable to read connector status", port);
+
+    if (cur.valid && (!old->valid || cur.connected != old->connected))
+        rb_notify(port, cur.connected ? "connect" : "disconnect", "Port %d: partner %s", port,
+                  cur.connected ? "connected" : "disconnected");
+
+    if (cur.valid && (!old->valid || cur.rdo != old->rdo || cur.pwr_op_mode != old->pwr_op_mode || cur.pwr_dir != old->pwr_dir))
+    {
+        if (cur.rdo)
+            rb_notify(port, "power", "Port %d: USB-C power contract Operating Power %u W, with Max Power %u W",
+                      port, (((cur.rdo >> 10) & 0x3ff) * 250) / 1000, ((cur.rdo & 0x3ff) * 250) / 1000);
+        else if (old->valid && old->rdo)
+            rb_notify(port, "power", "Port %d: no power contract", port);
+    }
+
+    *old = cur;
+}
+
+/* Alternate mode states of every billboard device, -1 if unreadable */
+static int rb_collect_billboard(struct rb_aum *aums, int max)
+{
+    unsigned char bb_data[512];
+    unsigned int num_bb = 0;
+    int num = 0;
+
+    if (libtypec_get_bb_status(&num_bb) < 0)
+        return -1;
+
+    for (int i = 1; i <= (int)num_bb; i++)
+    {
+        struct bb_bos_descritor *desc;
+        int ret, loc;
+
+        ret = libtypec_get_bb_data(i, (char *)bb_data);
+        if (ret < 0)
+            return -1;
+
+        loc = find_bb_bos_index((char *)bb_data, ret);
+        if (loc <= 0)
+            continue;
+
+        desc = (struct bb_bos_descritor *)&bb_data[loc];
+        for (int x = 0; x < desc->cap_desc_num_aum && num < max; x++)
+        {
+            unsigned char *aum = &desc->cap_desc_aum_array_start + x * 4;
+
+            aums[num].device = i;
+            aums[num].svid = aum[1] << 8 | aum[0];
+            aums[num].state = (desc->cap_desc_bmconfig[x / 4] >> ((x % 4) * 2)) & 0x3;
+            num++;
+        }
+    }
+
+    return num;
+}
+
+static void rb_evaluate_billboard(void)
+{
+    char *bmconf_str_array[] = {"Unspecified Error", "AUM not attempted", "AUM attempt unsuccessful", "AUM configuration successful"};
+    struct rb_aum aums[RB_MAX_AUMS];
+    int num = rb_collect_billboard(aums, RB_MAX_AUMS);
+
+    if (num < 0)
+        return;
+
+    if (num == rb_num_aums && memcmp(aums, rb_aums, num * sizeof(*aums)) == 0)
+        return;
+
+    if (num == 0)
+        rb_notify(-1, "billboard", "No Billboard alternate modes");
+
+    for (int i = 0; i < num; i++)
+    {
+        int j;
+
+        for (j = 0; j < rb_num_aums; j++)
+        {
+            if (rb_aums[j].device == aums[i].device && rb_aums[j].svid == aums[i].svid)
+                break;
+        }
+
+        if (j < rb_num_aums && rb_aums[j].state == aums[i].state)
+            continue;
+
+        rb_notify(-1, "billboard", "Billboard %d: Alternate Mode 0x%04X in state : %s",
+                  aums[i].device, aums[i].svid, bmconf_str_array[aums[i].state]);
+    }
+
+    memcpy(rb_aums, aums, num * sizeof(*aums));
+    rb_num_aums = num;
+}
+
+/* Ports a udev event refers to, RB_ALL_PORTS when it cannot be told */
+static unsigned int rb_event_ports(struct udev_device *dev)
+{
+    const char *subsystem = udev_device_get_subsystem(dev);
+    const char *sysname = udev_device_get_sysname(dev);
+    int port;
+
+    if (!subsystem || !sysname)
+        return RB_ALL_PORTS;
+
+    // port0, port0-partner, port0-cable, port0-plug0...
+    if (strcmp(subsystem, "typec") == 0 && sscanf(sysname, "port%d", &port) == 1)
+        return port < RB_MAX_PORTS ? 1u << port : 0;
+
+    // Batteries, AC adapters and supplies of no port affect no port
+    if (strcmp(subsystem, "power_supply") == 0) {
+        port = libtypec_get_power_supply_port(sysname);
+        return port >= 0 && port < RB_MAX_PORTS ? 1u << port : 0;
+    }
+
+    return RB_ALL_PORTS;
+}
+
+static void rb_signal(int sig)
+{
+    rb_stop = 1;
+}
+
+static long rb_now_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+int typecstatus_background()
+{
+    struct libtypec_capability_data cap;
+    struct udev *udev;
+    struct udev_monitor *mon;
+    struct sigaction sa = {0};
+    struct pollfd pfd;
+    unsigned int dirty = 0;
+    int bb_dirty = 0;
+    long deadline = 0;
+
+    if (libtypec_get_capability(&cap) < 0)
+    {
+        printf("Unable to read typec capabilities\n");
+        return -1;
+    }
+    rb_num_ports = cap.bNumConnectors < RB_MAX_PORTS ? cap.bNumConnectors : RB_MAX_PORTS;
+
+    udev = udev_new();
+    if (!udev)
+        return -1;
+
+    mon = udev_monitor_new_from_netlink(udev, "udev");
+    if (!mon)
+    {
+        udev_unref(udev);
+        return -1;
+    }
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "typec", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "power_supply", NULL);
+    udev_monitor_filter_add_match_subsystem_devtype(mon, "usb", "usb_device");
+    udev_monitor_enable_receiving(mon);
+
+    sa.sa_handler = rb_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    // Notification scripts are reaped automatically
+    signal(SIGCHLD, SIG_IGN);
+
+    if (syslog_flag)
+        openlog("typecstatus", LOG_PID, LOG_DAEMON);
+
+    rb_notify(-1, "start", "Monitoring %d USB-C port(s)", rb_num_ports);
+
+    // Initial state, reported like any other change
+    for (int i = 0; i < rb_num_ports; i++)
+        rb_evaluate_port(i);
+    rb_evaluate_billboard();
+
+    pfd.fd = udev_monitor_get_fd(mon);
+    pfd.events = POLLIN;
+
+    while (!rb_stop)
+    {
+        int timeout = -1, ret;
+
+        if (dirty || bb_dirty)
+        {
+            timeout = deadline - rb_now_ms();
+            if (timeout < 0)
+                timeout = 0;
+        }
+
+        ret = poll(&pfd, 1, timeout);
+        if (ret < 0 && errno != EINTR)
+            break;
+
+        if (ret > 0)
+        {
+            struct udev_device *dev = udev_monitor_receive_device(mon);
+            const char *subsystem, *action;
+
+            if (!dev)
+                continue;
+
+            subsystem = udev_device_get_subsystem(dev);
+            action = udev_device_get_action(dev);
+
+            if (!dirty && !bb_dirty)
+                deadline = rb_now_ms() + RB_SETTLE_MS;
+
+            if (subsystem && strcmp(subsystem, "usb") == 0)
+                bb_dirty |= action && (strcmp(action, "add") == 0 || strcmp(action, "remove") == 0);
+            else
+                dirty |= rb_event_ports(dev);
+
+            udev_device_unref(dev);
+            continue;
+        }
+
+        if (ret == 0)
+        {
+            for (int i = 0; i < rb_num_ports; i++)
+            {
+                if (dirty & (1u << i))
+                    rb_evaluate_port(i);
+            }
+            if (bb_dirty)
+                rb_evaluate_billboard();
+
+            dirty = 0;
+            bb_dirty = 0;
+        }
+    }
+
+    rb_notify(-1, "stop", "Stopped monitoring");
+
+    if (syslog_flag)
+        closelog();
+
+    udev_monitor_unref(mon);
+    udev_unref(udev);
+    return 0;
+}
+
 /* Check all typec ports */
 static int ro_flag;
 char *session_info[LIBTYPEC_SESSION_MAX_INDEX];
@@ -223,8 +559,11 @@ int main (int argc, char **argv)
 
     if(argc == 1)
     {
-	    printf("typecstatus - Check status of typec ports\n Usage:\t typecstatus --ro | --rb \n\
-        --ro\t Run once to gather typec port status \n\t--rb\t Run as background and notify\n");
+	    printf("typecstatus - Check status of typec ports\n Usage:\t typecstatus --ro | --rb [--syslog] [--exec <cmd>]\n\
+        --ro\t Run once to gather typec port status \n\t--rb\t Run as background and notify\n\
+        --syslog\t Send --rb notifications to syslog instead of stdout\n\
+        --exec\t Run <cmd> through sh for every --rb notification, with\n\
+        \t\t TYPEC_EVENT, TYPEC_PORT and TYPEC_MESSAGE set\n");
         exit(0);
     }
 
@@ -232,12 +571,19 @@ int main (int argc, char **argv)
     {
         /* These options set a flag. */
         {"ro", no_argument,&ro_flag, 1},
+        {"rb", no_argument,&rb_flag, 1},
+        {"syslog", no_argument,&syslog_flag, 1},
+        {"exec", required_argument, NULL, 'e'},
+        {0, 0, 0, 0}
     };
 
-    ret = getopt_long (argc, argv, "", options, &index);
-
-    if(ret != 0)    
-        printf("typecstatus - Check status of typec ports\n Usage:\t typecstatus --all \n");
+    while ((ret = getopt_long (argc, argv, "", options, &index)) != -1)
+    {
+        if (ret == 'e')
+            notify_cmd = optarg;
+        else if (ret != 0)
+            printf("typecstatus - Check status of typec ports\n Usage:\t typecstatus --all \n");
+    }
 
     names_init();
 
@@ -256,6 +602,10 @@ int main (int argc, char **argv)
         typec_status_billboard();
 
     }
+    else if(rb_flag)
+    {
+        typecstatus_background();
+    }
     names_exit();
 
 }
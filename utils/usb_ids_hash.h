@@ -0,0 +1,51 @@
+/*
+    Copyright (c) 2021-2022 by Rajaram Regupathy, rajaram.regupathy@gmail.com
+
+    This program is free software; you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation; version 2 of the License.
+
+    This program is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty MERCHANTABILITY or FITNESS
+    FOR A PARTICULAR PURPOSE. See the GNU General Public License for more
+    details.
+
+    (See the full license text in the LICENSES directory)
+*/
+// SPDX-License-Identifier: GPL-2.0-only
+/**
+ * @file usb_ids_hash.h
+ * @author Rajaram Regupathy <rajaram.regupathy@gmail.com>
+ * @brief Hash shared by the usb.ids table generator and its lookup
+ *
+ */
+
+#ifndef USB_IDS_HASH_H
+#define USB_IDS_HASH_H
+
+#include <stdint.h>
+
+/*
+ * The table is a hash-and-displace perfect hash: the low bits of the hash
+ * pick a bucket, the high bits XORed with the bucket displacement pick the
+ * slot. The generator searches seed and displacements so that no two
+ * vendors share a slot.
+ */
+static inline uint32_t usb_ids_hash(uint16_t vid, uint32_t seed)
+{
+    uint32_t h = vid ^ seed;
+
+    h ^= h >> 16;
+    h *= 0x7feb352d;
+    h ^= h >> 15;
+    h *= 0x846ca68b;
+    h ^= h >> 16;
+    return h;
+}
+
+static inline uint32_t usb_ids_slot(uint32_t hash, uint32_t disp, uint32_t num_slots)
+{
+    return ((hash >> 16) ^ disp) & (num_slots - 1);
+}
+
+#endif //USB_IDS_HASH_H